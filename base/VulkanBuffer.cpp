@@ -22,6 +22,16 @@ namespace vks
 	*/
 	VkResult Buffer::map(VkDeviceSize size, VkDeviceSize offset)
 	{
+		// Sub-allocated host visible memory is persistently mapped by the allocator
+		if (allocation.valid())
+		{
+			if (!allocation.mapped)
+			{
+				return VK_ERROR_MEMORY_MAP_FAILED;
+			}
+			mapped = static_cast<uint8_t*>(allocation.mapped) + offset;
+			return VK_SUCCESS;
+		}
 		return vkMapMemory(device, memory, offset, size, 0, &mapped);
 	}
 
@@ -34,7 +44,10 @@ namespace vks
 	{
 		if (mapped)
 		{
-			vkUnmapMemory(device, memory);
+			if (!allocation.valid())
+			{
+				vkUnmapMemory(device, memory);
+			}
 			mapped = nullptr;
 		}
 	}
@@ -48,7 +61,7 @@ namespace vks
 	*/
 	VkResult Buffer::bind(VkDeviceSize offset)
 	{
-		return vkBindBufferMemory(device, buffer, memory, offset);
+		return vkBindBufferMemory(device, buffer, memory, allocation.offset + offset);
 	}
 
 	/**
@@ -90,6 +103,10 @@ namespace vks
 	*/
 	VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset)
 	{
+		if (allocation.valid())
+		{
+			return allocation.allocator->flush(allocation, offset, size);
+		}
 		VkMappedMemoryRange mappedRange{
 			.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
 			.memory = memory,
@@ -111,6 +128,10 @@ namespace vks
 	*/
 	VkResult Buffer::invalidate(VkDeviceSize size, VkDeviceSize offset)
 	{
+		if (allocation.valid())
+		{
+			return allocation.allocator->invalidate(allocation, offset, size);
+		}
 		VkMappedMemoryRange mappedRange{
 			.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
 			.memory = memory,
@@ -130,7 +151,13 @@ namespace vks
 			vkDestroyBuffer(device, buffer, nullptr);
 			buffer = VK_NULL_HANDLE;
 		}
-		if (memory)
+		if (allocation.valid())
+		{
+			allocation.allocator->free(allocation);
+			mapped = nullptr;
+			memory = VK_NULL_HANDLE;
+		}
+		else if (memory)
 		{
 			vkFreeMemory(device, memory, nullptr);
 			memory = VK_NULL_HANDLE;
@@ -14,6 +14,7 @@
 
 #include "vulkan/vulkan.h"
 #include "VulkanTools.h"
+#include "VulkanMemoryAllocator.h"
 
 namespace vks
 {	
@@ -26,6 +27,8 @@ namespace vks
 		VkDevice device;
 		VkBuffer buffer = VK_NULL_HANDLE;
 		VkDeviceMemory memory = VK_NULL_HANDLE;
+		/** @brief Range of device memory the buffer is bound to, if created by the VulkanDevice (memory is then shared with other resources) */
+		MemoryAllocation allocation{};
 		VkDescriptorBufferInfo descriptor;
 		VkDeviceSize size = 0;
 		VkDeviceSize alignment = 0;
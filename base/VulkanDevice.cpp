@@ -60,16 +60,18 @@ namespace vks
 	/** 
 	* Default destructor
 	*
-	* @note Frees the logical device
+	* @note Frees the logical device and all memory blocks of the memory allocator
 	*/
 	VulkanDevice::~VulkanDevice()
 	{
+		uploadManager.destroy();
 		if (commandPool)
 		{
 			vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
 		}
 		if (logicalDevice)
 		{
+			memoryAllocator.destroy();
 			vkDestroyDevice(logicalDevice, nullptr);
 		}
 	}
@@ -295,6 +297,14 @@ namespace vks
 		}
 
 		this->enabledFeatures = enabledFeatures;
+		this->enabledExtensions.assign(deviceExtensions.begin(), deviceExtensions.end());
+		// Keep a copy of the Vulkan 1.2 features, so code using the device can check what has been enabled
+		for (auto* pNext = static_cast<const VkBaseInStructure*>(pNextChain); pNext; pNext = pNext->pNext) {
+			if (pNext->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES) {
+				enabledFeatures12 = *reinterpret_cast<const VkPhysicalDeviceVulkan12Features*>(pNext);
+				enabledFeatures12.pNext = nullptr;
+			}
+		}
 
 		VkResult result = vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &logicalDevice);
 		if (result != VK_SUCCESS) 
@@ -302,6 +312,15 @@ namespace vks
 			return result;
 		}
 
+		memoryAllocator.init(physicalDevice, logicalDevice);
+
+		// Uploads are copied on the transfer queue and handed over to the graphics queue
+		VkQueue transferQueue{ VK_NULL_HANDLE };
+		VkQueue graphicsQueue{ VK_NULL_HANDLE };
+		vkGetDeviceQueue(logicalDevice, queueFamilyIndices.transfer, 0, &transferQueue);
+		vkGetDeviceQueue(logicalDevice, queueFamilyIndices.graphics, 0, &graphicsQueue);
+		uploadManager.create(this, transferQueue, graphicsQueue);
+
 		// Create a default command pool for graphics command buffers
 		commandPool = createCommandPool(queueFamilyIndices.graphics);
 
@@ -368,6 +387,50 @@ namespace vks
 		return VK_SUCCESS;
 	}
 
+	/**
+	* Create a buffer on the device with memory taken from the device's memory allocator
+	*
+	* @param usageFlags Usage flag bit mask for the buffer (i.e. index, vertex, uniform buffer)
+	* @param memoryPropertyFlags Memory properties for this buffer (i.e. device local, host visible, coherent)
+	* @param size Size of the buffer in byes
+	* @param buffer Pointer to the buffer handle acquired by the function
+	* @param allocation Pointer to the memory allocation acquired by the function (release with freeMemory)
+	* @param data Pointer to the data that should be copied to the buffer after creation (optional, if not set, no data is copied over)
+	*
+	* @return VK_SUCCESS if buffer handle and memory have been created and (optionally passed) data has been copied
+	*/
+	VkResult VulkanDevice::createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, VkBuffer *buffer, vks::MemoryAllocation *allocation, void *data)
+	{
+		// Create the buffer handle
+		VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo(usageFlags, size);
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		VK_CHECK_RESULT(vkCreateBuffer(logicalDevice, &bufferCreateInfo, nullptr, buffer));
+
+		// Sub-allocate the memory backing up the buffer handle
+		VkMemoryRequirements memReqs;
+		vkGetBufferMemoryRequirements(logicalDevice, *buffer, &memReqs);
+		// If the buffer has VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT set the memory needs to be allocated with the appropriate flag
+		VkMemoryAllocateFlags allocateFlags = (usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT : 0;
+		VK_CHECK_RESULT(allocateMemory(memReqs, memoryPropertyFlags, allocation, true, allocateFlags));
+
+		// If a pointer to the buffer data has been passed, copy it over using the persistent mapping of the allocation
+		if (data != nullptr)
+		{
+			assert(allocation->mapped);
+			memcpy(allocation->mapped, data, size);
+			// If host coherency hasn't been requested, do a manual flush to make writes visible
+			if ((memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
+			{
+				memoryAllocator.flush(*allocation);
+			}
+		}
+
+		// Attach the memory to the buffer object
+		VK_CHECK_RESULT(vkBindBufferMemory(logicalDevice, *buffer, allocation->memory, allocation->offset));
+
+		return VK_SUCCESS;
+	}
+
 	/**
 	* Create a buffer on the device
 	*
@@ -377,6 +440,8 @@ namespace vks
 	* @param size Size of the buffer in bytes
 	* @param data Pointer to the data that should be copied to the buffer after creation (optional, if not set, no data is copied over)
 	*
+	* @note The buffer's memory is taken from the device's memory allocator
+	*
 	* @return VK_SUCCESS if buffer handle and memory have been created and (optionally passed) data has been copied
 	*/
 	VkResult VulkanDevice::createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, vks::Buffer *buffer, VkDeviceSize size, void *data)
@@ -387,21 +452,13 @@ namespace vks
 		VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo(usageFlags, size);
 		VK_CHECK_RESULT(vkCreateBuffer(logicalDevice, &bufferCreateInfo, nullptr, &buffer->buffer));
 
-		// Create the memory backing up the buffer handle
+		// Sub-allocate the memory backing up the buffer handle
 		VkMemoryRequirements memReqs;
-		VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
 		vkGetBufferMemoryRequirements(logicalDevice, buffer->buffer, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		// Find a memory type index that fits the properties of the buffer
-		memAlloc.memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-		// If the buffer has VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT set we also need to enable the appropriate flag during allocation
-		VkMemoryAllocateFlagsInfoKHR allocFlagsInfo{};
-		if (usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
-			allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR;
-			allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
-			memAlloc.pNext = &allocFlagsInfo;
-		}
-		VK_CHECK_RESULT(vkAllocateMemory(logicalDevice, &memAlloc, nullptr, &buffer->memory));
+		// If the buffer has VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT set the memory needs to be allocated with the appropriate flag
+		VkMemoryAllocateFlags allocateFlags = (usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT : 0;
+		VK_CHECK_RESULT(allocateMemory(memReqs, memoryPropertyFlags, &buffer->allocation, true, allocateFlags));
+		buffer->memory = buffer->allocation.memory;
 
 		buffer->alignment = memReqs.alignment;
 		buffer->size = size;
@@ -426,6 +483,35 @@ namespace vks
 		return buffer->bind();
 	}
 
+	/**
+	* Sub-allocate device memory from the device's memory allocator
+	*
+	* @param memoryRequirements Memory requirements of the resource to allocate for
+	* @param memoryPropertyFlags Memory properties the allocation needs to have
+	* @param allocation Pointer to the allocation acquired by the function
+	* @param linear (Optional) Set to false for images with optimal tiling so they don't share blocks with linear resources
+	* @param allocateFlags (Optional) Flags the backing memory needs to be allocated with (e.g. VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT)
+	*
+	* @return VK_SUCCESS if the allocation could be fulfilled
+	*
+	* @note Resources need to be bound at allocation->offset
+	*/
+	VkResult VulkanDevice::allocateMemory(const VkMemoryRequirements &memoryRequirements, VkMemoryPropertyFlags memoryPropertyFlags, vks::MemoryAllocation *allocation, bool linear, VkMemoryAllocateFlags allocateFlags)
+	{
+		const uint32_t memoryTypeIndex = getMemoryType(memoryRequirements.memoryTypeBits, memoryPropertyFlags);
+		return memoryAllocator.allocate(memoryRequirements, memoryTypeIndex, linear, allocateFlags, *allocation);
+	}
+
+	/**
+	* Return memory acquired via allocateMemory (or the allocation based createBuffer) to the device's memory allocator
+	*
+	* @param allocation Allocation to free, will be reset
+	*/
+	void VulkanDevice::freeMemory(vks::MemoryAllocation &allocation)
+	{
+		memoryAllocator.free(allocation);
+	}
+
 	/**
 	* Copy buffer data from src to dst using VkCmdCopyBuffer
 	* 
@@ -563,6 +649,18 @@ namespace vks
 		return (std::find(supportedExtensions.begin(), supportedExtensions.end(), extension) != supportedExtensions.end());
 	}
 
+	/**
+	* Check if an extension has been enabled for the logical device
+	*
+	* @param extension Name of the extension to check
+	*
+	* @return True if the extension was passed to createLogicalDevice
+	*/
+	bool VulkanDevice::extensionEnabled(std::string extension)
+	{
+		return (std::find(enabledExtensions.begin(), enabledExtensions.end(), extension) != enabledExtensions.end());
+	}
+
 	/**
 	* Select the best-fit depth format for this device from a list of possible depth (and stencil) formats
 	*
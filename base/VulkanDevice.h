@@ -11,6 +11,8 @@
 #pragma once
 
 #include "VulkanBuffer.h"
+#include "VulkanMemoryAllocator.h"
+#include "VulkanUploadManager.h"
 #include "VulkanTools.h"
 #include "vulkan/vulkan.h"
 #include <algorithm>
@@ -31,14 +33,22 @@ struct VulkanDevice
 	VkPhysicalDeviceFeatures features{};
 	/** @brief Features that have been enabled for use on the physical device */
 	VkPhysicalDeviceFeatures enabledFeatures{};
+	/** @brief Vulkan 1.2 features that have been enabled by passing a VkPhysicalDeviceVulkan12Features structure in the device creation pNext chain */
+	VkPhysicalDeviceVulkan12Features enabledFeatures12{};
 	/** @brief Memory types and heaps of the physical device */
 	VkPhysicalDeviceMemoryProperties memoryProperties{};
 	/** @brief Queue family properties of the physical device */
 	std::vector<VkQueueFamilyProperties> queueFamilyProperties{};
 	/** @brief List of extensions supported by the device */
 	std::vector<std::string> supportedExtensions{};
+	/** @brief List of extensions that have been enabled for the logical device */
+	std::vector<std::string> enabledExtensions{};
 	/** @brief Default command pool for the graphics queue family index */
 	VkCommandPool commandPool{ VK_NULL_HANDLE };;
+	/** @brief Sub-allocator that buffers and images created through the device helpers take their memory from */
+	vks::MemoryAllocator memoryAllocator;
+	/** @brief Batches staging uploads on the transfer queue */
+	vks::UploadManager uploadManager;
 	/** @brief Contains queue family indices */
 	struct
 	{
@@ -54,9 +64,12 @@ struct VulkanDevice
 	~VulkanDevice();
 	uint32_t        getMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, VkBool32 *memTypeFound = nullptr) const;
 	uint32_t        getQueueFamilyIndex(VkQueueFlags queueFlags) const;
-	VkResult        createLogicalDevice(VkPhysicalDeviceFeatures enabledFeatures, std::vector<const char *> enabledExtensions, void *pNextChain, bool useSwapChain = true, VkQueueFlags requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+	VkResult        createLogicalDevice(VkPhysicalDeviceFeatures enabledFeatures, std::vector<const char *> enabledExtensions, void *pNextChain, bool useSwapChain = true, VkQueueFlags requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT);
 	VkResult        createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, VkBuffer *buffer, VkDeviceMemory *memory, void *data = nullptr);
+	VkResult        createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, VkBuffer *buffer, vks::MemoryAllocation *allocation, void *data = nullptr);
 	VkResult        createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, vks::Buffer *buffer, VkDeviceSize size, void *data = nullptr);
+	VkResult        allocateMemory(const VkMemoryRequirements &memoryRequirements, VkMemoryPropertyFlags memoryPropertyFlags, vks::MemoryAllocation *allocation, bool linear = true, VkMemoryAllocateFlags allocateFlags = 0);
+	void            freeMemory(vks::MemoryAllocation &allocation);
 	void            copyBuffer(vks::Buffer *src, vks::Buffer *dst, VkQueue queue, VkBufferCopy *copyRegion = nullptr);
 	VkCommandPool   createCommandPool(uint32_t queueFamilyIndex, VkCommandPoolCreateFlags createFlags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 	VkCommandBuffer createCommandBuffer(VkCommandBufferLevel level, VkCommandPool pool, bool begin = false);
@@ -64,6 +77,7 @@ struct VulkanDevice
 	void            flushCommandBuffer(VkCommandBuffer commandBuffer, VkQueue queue, VkCommandPool pool, bool free = true);
 	void            flushCommandBuffer(VkCommandBuffer commandBuffer, VkQueue queue, bool free = true);
 	bool            extensionSupported(std::string extension);
+	bool            extensionEnabled(std::string extension);
 	VkFormat        getSupportedDepthFormat(bool checkSamplingSupport);
 };
 }        // namespace vks
@@ -0,0 +1,547 @@
+/*
+* GPU driven culling for glTF models
+*
+* Frustum culls every primitive instance of a vkglTF::Model in a compute shader and compacts the visible ones into an indirect draw buffer with a draw count
+* Optionally adds two phase occlusion culling against a hierarchical depth buffer (Hi-Z pyramid)
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include "VulkanGpuCulling.h"
+#include "VulkanDevice.h"
+#include "VulkanglTFModel.h"
+#include "frustum.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
+namespace vks
+{
+	static_assert(sizeof(GpuCulling::Candidate) == 32, "Candidate has to match the std430 layout of the cull shader");
+
+	// Have to match local_size of the cull and downsample shaders
+	constexpr uint32_t cullWorkGroupSize = 64;
+	constexpr uint32_t downsampleWorkGroupSize = 8;
+
+	/**
+	* Request what's required for indirect count draws, call this from the sample's getEnabledFeatures
+	* Uses the drawIndirectCount feature if the device supports Vulkan 1.2 and falls back to VK_KHR_draw_indirect_count
+	*
+	* @param physicalDevice Physical device the logical device will be created for
+	* @param apiVersion Vulkan version the instance has been created with
+	* @param enabledFeatures12 Vulkan 1.2 features that will be chained into the device creation (e.g. via deviceCreatepNextChain), drawIndirectCount is set if supported
+	* @param enabledDeviceExtensions Device extensions that will be enabled, VK_KHR_draw_indirect_count is added if required and supported
+	*
+	* @return True if indirect count draws will be available on the logical device
+	*/
+	bool GpuCulling::getEnabledFeatures(VkPhysicalDevice physicalDevice, uint32_t apiVersion, VkPhysicalDeviceVulkan12Features& enabledFeatures12, std::vector<const char*>& enabledDeviceExtensions)
+	{
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		if (std::min(apiVersion, deviceProperties.apiVersion) >= VK_API_VERSION_1_2) {
+			VkPhysicalDeviceVulkan12Features supportedFeatures12{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+			VkPhysicalDeviceFeatures2 deviceFeatures2{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &supportedFeatures12 };
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures2);
+			if (supportedFeatures12.drawIndirectCount == VK_TRUE) {
+				enabledFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+				enabledFeatures12.drawIndirectCount = VK_TRUE;
+				return true;
+			}
+		}
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+		for (const VkExtensionProperties& extension : extensions) {
+			if (strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0) {
+				enabledDeviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	* Collect the primitive instances of the model and create the buffers, descriptors and compute pipeline for culling them
+	*
+	* @param device Vulkan device the model has been loaded with
+	* @param model Model loaded with vkglTF::FileLoadingFlags::NodeStorageBuffers, one set of cull buffers is created per node storage buffer (frame in flight)
+	* @param cullShaderStage Compute shader stage of gltfcull.comp, the shader module is owned by the caller
+	* @note Blended primitives aren't culled, as they need to be sorted on the CPU (see vkglTF::Model::sortBlendedDraws), draw them with vkglTF::Model::draw and RenderFlags::RenderAlphaBlendedNodes
+	*/
+	void GpuCulling::create(VulkanDevice* device, vkglTF::Model* model, const VkPipelineShaderStageCreateInfo& cullShaderStage)
+	{
+		this->device = device;
+		this->model = model;
+		// The function pointer may be returned even if the feature or extension hasn't been enabled, so check what the device has been created with
+		vkCmdDrawIndexedIndirectCount = nullptr;
+		if (device->enabledFeatures12.drawIndirectCount == VK_TRUE) {
+			vkCmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(vkGetDeviceProcAddr(device->logicalDevice, "vkCmdDrawIndexedIndirectCount"));
+		} else if (device->extensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+			vkCmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(vkGetDeviceProcAddr(device->logicalDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+		}
+
+		// Every instance of a draw is culled on its own, so instanced draws are split into one candidate per node
+		std::vector<Candidate> candidates;
+		for (const vkglTF::Model::DrawBatch& batch : model->drawBatches) {
+			for (const vkglTF::Primitive* primitive : batch.mesh->primitives) {
+				if ((primitive->indexCount == 0) || (primitive->material.alphaMode == vkglTF::Material::ALPHAMODE_BLEND)) {
+					continue;
+				}
+				const uint32_t material = static_cast<uint32_t>(&primitive->material - model->materials.data());
+				for (uint32_t instance = batch.firstInstance; instance < batch.firstInstance + batch.instanceCount; instance++) {
+					candidates.push_back({ glm::vec4(primitive->dimensions.center, primitive->dimensions.radius), primitive->firstIndex, primitive->indexCount, instance, material });
+				}
+			}
+		}
+		statistics = { .candidates = static_cast<uint32_t>(candidates.size()) };
+		enabled = (vkCmdDrawIndexedIndirectCount != nullptr) && !candidates.empty() && !model->nodeBuffers.empty();
+		if (!enabled) {
+			return;
+		}
+
+		const VkDeviceSize candidateBufferSize = candidates.size() * sizeof(Candidate);
+		VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, candidateBufferSize, &candidateBuffer, &candidateAllocation));
+		device->uploadManager.uploadBuffer(candidateBuffer, candidates.data(), candidateBufferSize);
+		device->uploadManager.wait(device->uploadManager.flush());
+
+		// Output buffers have room for all candidates in both phases, the count buffer limits the draws to the visible ones
+		frames.resize(model->nodeBuffers.size());
+		for (Frame& frame : frames) {
+			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 2 * candidates.size() * sizeof(VkDrawIndexedIndirectCommand), &frame.drawBuffer, &frame.drawAllocation));
+			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 2 * candidates.size() * sizeof(uint32_t), &frame.materialBuffer, &frame.materialAllocation));
+			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, candidates.size() * sizeof(uint32_t), &frame.occludedBuffer, &frame.occludedAllocation));
+			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(Counts), &frame.countBuffer, &frame.countAllocation));
+			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(UniformData), &frame.uniformBuffer, &frame.uniformAllocation));
+			UniformData uniformData{};
+			uniformData.candidateCount = statistics.candidates;
+			memcpy(frame.uniformAllocation.mapped, &uniformData, sizeof(UniformData));
+		}
+
+		// Depth pyramid samples are read with texelFetch and textureLod, both without filtering
+		VkSamplerCreateInfo samplerCI{
+			.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+			.magFilter = VK_FILTER_NEAREST,
+			.minFilter = VK_FILTER_NEAREST,
+			.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+			.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			.maxLod = VK_LOD_CLAMP_NONE,
+		};
+		VK_CHECK_RESULT(vkCreateSampler(device->logicalDevice, &samplerCI, nullptr, &depthSampler));
+
+		// Descriptors
+		const uint32_t frameCount = static_cast<uint32_t>(frames.size());
+		const std::array<VkDescriptorPoolSize, 3> poolSizes = {
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * 6 },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameCount },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameCount },
+		};
+		VkDescriptorPoolCreateInfo descriptorPoolCI{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, .maxSets = frameCount, .poolSizeCount = static_cast<uint32_t>(poolSizes.size()), .pPoolSizes = poolSizes.data() };
+		VK_CHECK_RESULT(vkCreateDescriptorPool(device->logicalDevice, &descriptorPoolCI, nullptr, &descriptorPool));
+		const std::array<VkDescriptorSetLayoutBinding, 8> setLayoutBindings = {
+			// Binding 0: Candidates
+			VkDescriptorSetLayoutBinding{ .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+			// Binding 1: Node data of the model
+			VkDescriptorSetLayoutBinding{ .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+			// Binding 2: Indirect draws
+			VkDescriptorSetLayoutBinding{ .binding = 2, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+			// Binding 3: Material indices of the draws
+			VkDescriptorSetLayoutBinding{ .binding = 3, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+			// Binding 4: Draw counts
+			VkDescriptorSetLayoutBinding{ .binding = 4, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+			// Binding 5: Frustum planes, view projection and candidate count
+			VkDescriptorSetLayoutBinding{ .binding = 5, .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+			// Binding 6: Candidates rejected by the early occlusion test
+			VkDescriptorSetLayoutBinding{ .binding = 6, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+			// Binding 7: Depth pyramid
+			VkDescriptorSetLayoutBinding{ .binding = 7, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+		};
+		VkDescriptorSetLayoutCreateInfo descriptorLayoutCI{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, .bindingCount = static_cast<uint32_t>(setLayoutBindings.size()), .pBindings = setLayoutBindings.data() };
+		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device->logicalDevice, &descriptorLayoutCI, nullptr, &descriptorSetLayout));
+		for (uint32_t i = 0; i < frameCount; i++) {
+			Frame& frame = frames[i];
+			VkDescriptorSetAllocateInfo descriptorSetAllocInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, .descriptorPool = descriptorPool, .descriptorSetCount = 1, .pSetLayouts = &descriptorSetLayout };
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(device->logicalDevice, &descriptorSetAllocInfo, &frame.descriptorSet));
+			const std::array<VkDescriptorBufferInfo, 7> bufferInfos = {
+				VkDescriptorBufferInfo{ candidateBuffer, 0, VK_WHOLE_SIZE },
+				VkDescriptorBufferInfo{ model->nodeBuffers[i].buffer, 0, model->instanceNodes.size() * sizeof(vkglTF::NodeData) },
+				VkDescriptorBufferInfo{ frame.drawBuffer, 0, VK_WHOLE_SIZE },
+				VkDescriptorBufferInfo{ frame.materialBuffer, 0, VK_WHOLE_SIZE },
+				VkDescriptorBufferInfo{ frame.countBuffer, 0, VK_WHOLE_SIZE },
+				VkDescriptorBufferInfo{ frame.uniformBuffer, 0, VK_WHOLE_SIZE },
+				VkDescriptorBufferInfo{ frame.occludedBuffer, 0, VK_WHOLE_SIZE },
+			};
+			std::array<VkWriteDescriptorSet, 7> writeDescriptorSets{};
+			for (uint32_t binding = 0; binding < static_cast<uint32_t>(writeDescriptorSets.size()); binding++) {
+				writeDescriptorSets[binding] = {
+					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					.dstSet = frame.descriptorSet,
+					.dstBinding = binding,
+					.descriptorCount = 1,
+					.descriptorType = setLayoutBindings[binding].descriptorType,
+					.pBufferInfo = &bufferInfos[binding]
+				};
+			}
+			vkUpdateDescriptorSets(device->logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+		}
+		// The cull shader always accesses the pyramid, so a placeholder is created until setDepthSource is called (binding 7 is written by createDepthPyramid)
+		createDepthPyramid(1, 1);
+
+		// Pipeline, the push constant selects the early (0) or late (1) phase
+		VkPushConstantRange pushConstantRange{ .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .offset = 0, .size = sizeof(uint32_t) };
+		VkPipelineLayoutCreateInfo pipelineLayoutCI{ .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, .setLayoutCount = 1, .pSetLayouts = &descriptorSetLayout, .pushConstantRangeCount = 1, .pPushConstantRanges = &pushConstantRange };
+		VK_CHECK_RESULT(vkCreatePipelineLayout(device->logicalDevice, &pipelineLayoutCI, nullptr, &pipelineLayout));
+		VkComputePipelineCreateInfo computePipelineCI{ .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO, .stage = cullShaderStage, .layout = pipelineLayout };
+		VK_CHECK_RESULT(vkCreateComputePipelines(device->logicalDevice, VK_NULL_HANDLE, 1, &computePipelineCI, nullptr, &pipeline));
+	}
+
+	void GpuCulling::destroyFrame(Frame& frame)
+	{
+		vkDestroyBuffer(device->logicalDevice, frame.drawBuffer, nullptr);
+		device->freeMemory(frame.drawAllocation);
+		vkDestroyBuffer(device->logicalDevice, frame.materialBuffer, nullptr);
+		device->freeMemory(frame.materialAllocation);
+		vkDestroyBuffer(device->logicalDevice, frame.occludedBuffer, nullptr);
+		device->freeMemory(frame.occludedAllocation);
+		vkDestroyBuffer(device->logicalDevice, frame.countBuffer, nullptr);
+		device->freeMemory(frame.countAllocation);
+		vkDestroyBuffer(device->logicalDevice, frame.uniformBuffer, nullptr);
+		device->freeMemory(frame.uniformAllocation);
+	}
+
+	/** @brief Release all resources, the device must be idle */
+	void GpuCulling::destroy()
+	{
+		if (!device) {
+			return;
+		}
+		destroyDepthPyramid();
+		for (Frame& frame : frames) {
+			destroyFrame(frame);
+		}
+		frames.clear();
+		vkDestroyBuffer(device->logicalDevice, candidateBuffer, nullptr);
+		device->freeMemory(candidateAllocation);
+		candidateBuffer = VK_NULL_HANDLE;
+		vkDestroySampler(device->logicalDevice, depthSampler, nullptr);
+		vkDestroyPipeline(device->logicalDevice, pipeline, nullptr);
+		vkDestroyPipelineLayout(device->logicalDevice, pipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device->logicalDevice, descriptorSetLayout, nullptr);
+		vkDestroyDescriptorPool(device->logicalDevice, descriptorPool, nullptr);
+		vkDestroyPipeline(device->logicalDevice, downsamplePipeline, nullptr);
+		vkDestroyPipelineLayout(device->logicalDevice, downsamplePipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device->logicalDevice, downsampleDescriptorSetLayout, nullptr);
+		depthSampler = VK_NULL_HANDLE;
+		pipeline = VK_NULL_HANDLE;
+		pipelineLayout = VK_NULL_HANDLE;
+		descriptorSetLayout = VK_NULL_HANDLE;
+		descriptorPool = VK_NULL_HANDLE;
+		downsamplePipeline = VK_NULL_HANDLE;
+		downsamplePipelineLayout = VK_NULL_HANDLE;
+		downsampleDescriptorSetLayout = VK_NULL_HANDLE;
+		depthView = VK_NULL_HANDLE;
+		enabled = false;
+		occlusionCulling = false;
+	}
+
+	/** @brief Create the pyramid image with its views and descriptors, levels are reduced from the depth buffer of the given size */
+	void GpuCulling::createDepthPyramid(uint32_t width, uint32_t height)
+	{
+		depthPyramid.sourceWidth = width;
+		depthPyramid.sourceHeight = height;
+		// Reducing to a power of two lets every following level cover exactly 2x2 texels of the previous one
+		depthPyramid.width = std::bit_floor(std::max(width, 1u));
+		depthPyramid.height = std::bit_floor(std::max(height, 1u));
+		depthPyramid.levels = static_cast<uint32_t>(std::bit_width(std::max(depthPyramid.width, depthPyramid.height)));
+
+		VkImageCreateInfo imageCI{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+			.imageType = VK_IMAGE_TYPE_2D,
+			.format = VK_FORMAT_R32_SFLOAT,
+			.extent = { .width = depthPyramid.width, .height = depthPyramid.height, .depth = 1 },
+			.mipLevels = depthPyramid.levels,
+			.arrayLayers = 1,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.tiling = VK_IMAGE_TILING_OPTIMAL,
+			.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		};
+		VK_CHECK_RESULT(vkCreateImage(device->logicalDevice, &imageCI, nullptr, &depthPyramid.image));
+		VkMemoryRequirements memReqs;
+		vkGetImageMemoryRequirements(device->logicalDevice, depthPyramid.image, &memReqs);
+		VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &depthPyramid.allocation, false));
+		VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, depthPyramid.image, depthPyramid.allocation.memory, depthPyramid.allocation.offset));
+
+		VkImageViewCreateInfo viewCI{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.image = depthPyramid.image,
+			.viewType = VK_IMAGE_VIEW_TYPE_2D,
+			.format = VK_FORMAT_R32_SFLOAT,
+			.subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = 0, .levelCount = depthPyramid.levels, .baseArrayLayer = 0, .layerCount = 1 },
+		};
+		VK_CHECK_RESULT(vkCreateImageView(device->logicalDevice, &viewCI, nullptr, &depthPyramid.view));
+		depthPyramid.levelViews.resize(depthPyramid.levels);
+		for (uint32_t level = 0; level < depthPyramid.levels; level++) {
+			viewCI.subresourceRange.baseMipLevel = level;
+			viewCI.subresourceRange.levelCount = 1;
+			VK_CHECK_RESULT(vkCreateImageView(device->logicalDevice, &viewCI, nullptr, &depthPyramid.levelViews[level]));
+		}
+
+		const VkDescriptorImageInfo pyramidInfo{ depthSampler, depthPyramid.view, VK_IMAGE_LAYOUT_GENERAL };
+		for (Frame& frame : frames) {
+			VkWriteDescriptorSet writeDescriptorSet{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstSet = frame.descriptorSet, .dstBinding = 7, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .pImageInfo = &pyramidInfo };
+			vkUpdateDescriptorSets(device->logicalDevice, 1, &writeDescriptorSet, 0, nullptr);
+		}
+
+		// One downsample pass per level, reading the depth buffer or the previous level
+		if ((downsampleDescriptorSetLayout == VK_NULL_HANDLE) || (depthView == VK_NULL_HANDLE)) {
+			return;
+		}
+		const std::array<VkDescriptorPoolSize, 2> poolSizes = {
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, depthPyramid.levels },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, depthPyramid.levels },
+		};
+		VkDescriptorPoolCreateInfo descriptorPoolCI{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, .maxSets = depthPyramid.levels, .poolSizeCount = static_cast<uint32_t>(poolSizes.size()), .pPoolSizes = poolSizes.data() };
+		VK_CHECK_RESULT(vkCreateDescriptorPool(device->logicalDevice, &descriptorPoolCI, nullptr, &downsampleDescriptorPool));
+		depthPyramid.descriptorSets.resize(depthPyramid.levels);
+		for (uint32_t level = 0; level < depthPyramid.levels; level++) {
+			VkDescriptorSetAllocateInfo descriptorSetAllocInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, .descriptorPool = downsampleDescriptorPool, .descriptorSetCount = 1, .pSetLayouts = &downsampleDescriptorSetLayout };
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(device->logicalDevice, &descriptorSetAllocInfo, &depthPyramid.descriptorSets[level]));
+			const VkDescriptorImageInfo sourceInfo = (level == 0) ? VkDescriptorImageInfo{ depthSampler, depthView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL } : VkDescriptorImageInfo{ depthSampler, depthPyramid.levelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL };
+			const VkDescriptorImageInfo destinationInfo{ VK_NULL_HANDLE, depthPyramid.levelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+			const std::array<VkWriteDescriptorSet, 2> writeDescriptorSets = {
+				VkWriteDescriptorSet{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstSet = depthPyramid.descriptorSets[level], .dstBinding = 0, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .pImageInfo = &sourceInfo },
+				VkWriteDescriptorSet{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstSet = depthPyramid.descriptorSets[level], .dstBinding = 1, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .pImageInfo = &destinationInfo },
+			};
+			vkUpdateDescriptorSets(device->logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+		}
+	}
+
+	void GpuCulling::destroyDepthPyramid()
+	{
+		for (VkImageView levelView : depthPyramid.levelViews) {
+			vkDestroyImageView(device->logicalDevice, levelView, nullptr);
+		}
+		vkDestroyImageView(device->logicalDevice, depthPyramid.view, nullptr);
+		vkDestroyImage(device->logicalDevice, depthPyramid.image, nullptr);
+		device->freeMemory(depthPyramid.allocation);
+		vkDestroyDescriptorPool(device->logicalDevice, downsampleDescriptorPool, nullptr);
+		downsampleDescriptorPool = VK_NULL_HANDLE;
+		depthPyramid = {};
+	}
+
+	/**
+	* Enable occlusion culling against a depth pyramid built from the given depth buffer, call again if the depth buffer is recreated (e.g. on resize)
+	*
+	* @param depthView View of the depth aspect of the depth buffer the early draws are rendered to, has to be in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL when buildDepthPyramid is recorded
+	* @param width Width of the depth buffer
+	* @param height Height of the depth buffer
+	* @param downsampleShaderStage Compute shader stage of hizdownsample.comp, the shader module is owned by the caller
+	* @note The device must be idle
+	*/
+	void GpuCulling::setDepthSource(VkImageView depthView, uint32_t width, uint32_t height, const VkPipelineShaderStageCreateInfo& downsampleShaderStage)
+	{
+		if (!enabled) {
+			return;
+		}
+		if (downsamplePipeline == VK_NULL_HANDLE) {
+			const std::array<VkDescriptorSetLayoutBinding, 2> setLayoutBindings = {
+				// Binding 0: Depth buffer or previous level
+				VkDescriptorSetLayoutBinding{ .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+				// Binding 1: Level to write
+				VkDescriptorSetLayoutBinding{ .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+			};
+			VkDescriptorSetLayoutCreateInfo descriptorLayoutCI{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, .bindingCount = static_cast<uint32_t>(setLayoutBindings.size()), .pBindings = setLayoutBindings.data() };
+			VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device->logicalDevice, &descriptorLayoutCI, nullptr, &downsampleDescriptorSetLayout));
+			// Source and destination size
+			VkPushConstantRange pushConstantRange{ .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .offset = 0, .size = 4 * sizeof(int32_t) };
+			VkPipelineLayoutCreateInfo pipelineLayoutCI{ .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, .setLayoutCount = 1, .pSetLayouts = &downsampleDescriptorSetLayout, .pushConstantRangeCount = 1, .pPushConstantRanges = &pushConstantRange };
+			VK_CHECK_RESULT(vkCreatePipelineLayout(device->logicalDevice, &pipelineLayoutCI, nullptr, &downsamplePipelineLayout));
+			VkComputePipelineCreateInfo computePipelineCI{ .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO, .stage = downsampleShaderStage, .layout = downsamplePipelineLayout };
+			VK_CHECK_RESULT(vkCreateComputePipelines(device->logicalDevice, VK_NULL_HANDLE, 1, &computePipelineCI, nullptr, &downsamplePipeline));
+		}
+		this->depthView = depthView;
+		destroyDepthPyramid();
+		createDepthPyramid(width, height);
+		occlusionCulling = true;
+	}
+
+	/**
+	* Read back the results of the frame's previous use and set the view for the next cull
+	*
+	* @param frame Frame in flight, call after the frame's fence has been signalled and with the same index as vkglTF::Model::updateNodeBuffer
+	* @param viewProjection Combined projection and view matrix the model is rendered with
+	*/
+	void GpuCulling::update(uint32_t frame, const glm::mat4& viewProjection)
+	{
+		if (!enabled || (frame >= frames.size())) {
+			return;
+		}
+		Frame& cullFrame = frames[frame];
+		if (cullFrame.pending) {
+			const Counts counts = *static_cast<const Counts*>(cullFrame.countAllocation.mapped);
+			statistics.visibleDraws = counts.earlyDraws + counts.lateDraws;
+			statistics.lateDraws = counts.lateDraws;
+			statistics.frustumCulled = statistics.candidates - counts.earlyDraws - counts.occludedCandidates;
+			statistics.occlusionCulled = counts.occludedCandidates - counts.lateDraws;
+			cullFrame.pending = false;
+		}
+		Frustum frustum;
+		frustum.update(viewProjection);
+		UniformData uniformData{};
+		memcpy(uniformData.frustumPlanes, frustum.planes.data(), sizeof(uniformData.frustumPlanes));
+		uniformData.viewProjection = viewProjection;
+		uniformData.pyramidWidth = static_cast<float>(depthPyramid.width);
+		uniformData.pyramidHeight = static_cast<float>(depthPyramid.height);
+		uniformData.candidateCount = statistics.candidates;
+		// The early phase needs a pyramid from a previous frame
+		uniformData.occlusionEnabled = (occlusionCulling && depthPyramid.built) ? 1 : 0;
+		memcpy(cullFrame.uniformAllocation.mapped, &uniformData, sizeof(UniformData));
+	}
+
+	/** @brief Transition a newly created pyramid to the general layout it's used with, its contents are only read once they have been built */
+	void GpuCulling::initializeDepthPyramid(VkCommandBuffer commandBuffer)
+	{
+		if (depthPyramid.initialized) {
+			return;
+		}
+		VkImageMemoryBarrier imageBarrier{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = 0,
+			.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.newLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = depthPyramid.image,
+			.subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = 0, .levelCount = depthPyramid.levels, .baseArrayLayer = 0, .layerCount = 1 },
+		};
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+		depthPyramid.initialized = true;
+	}
+
+	void GpuCulling::dispatchCull(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t phase)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frames[frame].descriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &phase);
+		vkCmdDispatch(commandBuffer, (statistics.candidates + cullWorkGroupSize - 1) / cullWorkGroupSize, 1, 1);
+
+		// Draws and material indices are consumed by the indirect draw and the vertex shader, the occluded candidates by the late phase and the counts are also read back on the host
+		VkMemoryBarrier memoryBarrier{ .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER, .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT, .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_HOST_READ_BIT };
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	/** @brief Record the early culling phase, has to be recorded outside of a render pass and before draw */
+	void GpuCulling::cull(VkCommandBuffer commandBuffer, uint32_t frame)
+	{
+		if (!enabled || (frame >= frames.size())) {
+			return;
+		}
+		initializeDepthPyramid(commandBuffer);
+		vkCmdFillBuffer(commandBuffer, frames[frame].countBuffer, 0, sizeof(Counts), 0);
+		VkMemoryBarrier memoryBarrier{ .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER, .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT, .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT };
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+		dispatchCull(commandBuffer, frame, 0);
+		frames[frame].pending = true;
+	}
+
+	/**
+	* Reduce the depth buffer of the early draws into the pyramid, has to be recorded outside of a render pass after the early draws
+	* @note The depth buffer has to be in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, e.g. as the final layout of the render pass
+	*/
+	void GpuCulling::buildDepthPyramid(VkCommandBuffer commandBuffer)
+	{
+		if (!enabled || !occlusionCulling || depthPyramid.descriptorSets.empty()) {
+			return;
+		}
+		initializeDepthPyramid(commandBuffer);
+		// Wait for the depth writes of the early draws and for the early cull to finish reading the previous pyramid
+		VkMemoryBarrier memoryBarrier{ .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER, .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT };
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, downsamplePipeline);
+		uint32_t sourceWidth = depthPyramid.sourceWidth;
+		uint32_t sourceHeight = depthPyramid.sourceHeight;
+		for (uint32_t level = 0; level < depthPyramid.levels; level++) {
+			const uint32_t levelWidth = std::max(depthPyramid.width >> level, 1u);
+			const uint32_t levelHeight = std::max(depthPyramid.height >> level, 1u);
+			const std::array<int32_t, 4> sizes = { static_cast<int32_t>(sourceWidth), static_cast<int32_t>(sourceHeight), static_cast<int32_t>(levelWidth), static_cast<int32_t>(levelHeight) };
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, downsamplePipelineLayout, 0, 1, &depthPyramid.descriptorSets[level], 0, nullptr);
+			vkCmdPushConstants(commandBuffer, downsamplePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(sizes), sizes.data());
+			vkCmdDispatch(commandBuffer, (levelWidth + downsampleWorkGroupSize - 1) / downsampleWorkGroupSize, (levelHeight + downsampleWorkGroupSize - 1) / downsampleWorkGroupSize, 1);
+			// The next level (and after the last level the late cull) reads this level
+			VkImageMemoryBarrier imageBarrier{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+				.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+				.oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+				.newLayout = VK_IMAGE_LAYOUT_GENERAL,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = depthPyramid.image,
+				.subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = level, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 },
+			};
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+			sourceWidth = levelWidth;
+			sourceHeight = levelHeight;
+		}
+		depthPyramid.built = true;
+	}
+
+	/** @brief Record the late culling phase, which tests the candidates rejected by the early phase against the pyramid built by buildDepthPyramid */
+	void GpuCulling::cullOccluded(VkCommandBuffer commandBuffer, uint32_t frame)
+	{
+		if (!enabled || !occlusionCulling || !depthPyramid.built || (frame >= frames.size())) {
+			return;
+		}
+		dispatchCull(commandBuffer, frame, 1);
+	}
+
+	void GpuCulling::drawIndirect(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t phase)
+	{
+		const VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &model->vertices.buffer, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, model->indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+		const VkDeviceSize drawOffset = phase * statistics.candidates * sizeof(VkDrawIndexedIndirectCommand);
+		const VkDeviceSize countOffset = (phase == 0) ? offsetof(Counts, earlyDraws) : offsetof(Counts, lateDraws);
+		vkCmdDrawIndexedIndirectCount(commandBuffer, frames[frame].drawBuffer, drawOffset, frames[frame].countBuffer, countOffset, statistics.candidates, sizeof(VkDrawIndexedIndirectCommand));
+	}
+
+	/**
+	* Draw the primitives that passed the early phase with a single indirect count draw
+	* @note The pipeline and descriptor sets (node storage buffer, materials) have to be bound by the caller, gl_InstanceIndex selects the node like for vkglTF::Model::draw
+	*/
+	void GpuCulling::draw(VkCommandBuffer commandBuffer, uint32_t frame)
+	{
+		if (!enabled || (frame >= frames.size())) {
+			return;
+		}
+		drawIndirect(commandBuffer, frame, 0);
+	}
+
+	/** @brief Draw the primitives that passed the late phase, into a render pass that loads the color and depth results of the early draws */
+	void GpuCulling::drawOccluded(VkCommandBuffer commandBuffer, uint32_t frame)
+	{
+		if (!enabled || !occlusionCulling || !depthPyramid.built || (frame >= frames.size())) {
+			return;
+		}
+		drawIndirect(commandBuffer, frame, 1);
+	}
+
+	VkDescriptorBufferInfo GpuCulling::getMaterialBufferInfo(uint32_t frame) const
+	{
+		if (frame >= frames.size()) {
+			return {};
+		}
+		return { frames[frame].materialBuffer, 0, VK_WHOLE_SIZE };
+	}
+}
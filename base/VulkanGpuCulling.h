@@ -0,0 +1,168 @@
+/*
+* GPU driven culling for glTF models
+*
+* Frustum culls every primitive instance of a vkglTF::Model in a compute shader and compacts the visible ones into an indirect draw buffer with a draw count
+* Optionally adds two phase occlusion culling against a hierarchical depth buffer (Hi-Z pyramid)
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanMemoryAllocator.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+namespace vkglTF
+{
+	class Model;
+}
+
+namespace vks
+{
+	struct VulkanDevice;
+
+	/**
+	* @brief Culls the opaque and alpha masked primitives of a glTF model on the GPU and draws the visible ones with vkCmdDrawIndexedIndirectCount
+	* @note The CPU cost per frame (one fill, one dispatch, one draw) doesn't depend on the size of the scene, bounds are transformed with the matrices of the model's node storage buffers
+	* @note Requires drawIndirectCount (Vulkan 1.2) or VK_KHR_draw_indirect_count to be enabled on the device (see getEnabledFeatures), the cull shader is shaders/glsl/base/gltfcull.comp
+	*
+	* With occlusion culling (see setDepthSource) a frame is recorded in two phases:
+	* cull -> draw (early draws) -> buildDepthPyramid -> cullOccluded -> drawOccluded (late draws)
+	* The early phase tests against the depth pyramid of the previous frame, candidates it rejects are tested again against the pyramid built from the early draws,
+	* so objects that became visible this frame are drawn without a frame of delay
+	*/
+	class GpuCulling
+	{
+	public:
+		/** @brief Primitive instance to be culled, object space bounding sphere (xyz = center, w = radius) and the draw parameters (std430 layout) */
+		struct Candidate
+		{
+			glm::vec4 boundingSphere;
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			// Index of the node in the model's node storage buffers, passed as firstInstance
+			uint32_t instance;
+			uint32_t material;
+		};
+		/** @brief Results of the last frame that has been read back */
+		struct Statistics
+		{
+			uint32_t candidates{ 0 };
+			// Drawn by the early and the late phase
+			uint32_t visibleDraws{ 0 };
+			uint32_t lateDraws{ 0 };
+			uint32_t frustumCulled{ 0 };
+			uint32_t occlusionCulled{ 0 };
+		};
+	private:
+		struct UniformData
+		{
+			glm::vec4 frustumPlanes[6];
+			glm::mat4 viewProjection;
+			float pyramidWidth;
+			float pyramidHeight;
+			uint32_t candidateCount;
+			// Test the early phase against the pyramid, only set once a pyramid has been built
+			uint32_t occlusionEnabled;
+		};
+		/** @brief Layout of the count buffer */
+		struct Counts
+		{
+			uint32_t earlyDraws;
+			uint32_t occludedCandidates;
+			uint32_t lateDraws;
+			uint32_t padding;
+		};
+		struct Frame
+		{
+			// Early draws followed by the late draws, each part has room for all candidates
+			VkBuffer drawBuffer{ VK_NULL_HANDLE };
+			MemoryAllocation drawAllocation;
+			VkBuffer materialBuffer{ VK_NULL_HANDLE };
+			MemoryAllocation materialAllocation;
+			// Candidates rejected by the early occlusion test
+			VkBuffer occludedBuffer{ VK_NULL_HANDLE };
+			MemoryAllocation occludedAllocation;
+			// Host visible, so the counts can be read back once the frame's fence has been signalled
+			VkBuffer countBuffer{ VK_NULL_HANDLE };
+			MemoryAllocation countAllocation;
+			VkBuffer uniformBuffer{ VK_NULL_HANDLE };
+			MemoryAllocation uniformAllocation;
+			VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+			bool pending{ false };
+		};
+		/** @brief Max. depth of 2x2 texel blocks per level, the first level is the depth buffer reduced to the next lower power of two */
+		struct DepthPyramid
+		{
+			VkImage image{ VK_NULL_HANDLE };
+			MemoryAllocation allocation;
+			// View of all levels for the cull shader and one view per level for the downsample passes
+			VkImageView view{ VK_NULL_HANDLE };
+			std::vector<VkImageView> levelViews;
+			std::vector<VkDescriptorSet> descriptorSets;
+			uint32_t width{ 1 };
+			uint32_t height{ 1 };
+			uint32_t levels{ 1 };
+			// Size of the depth buffer the first level is reduced from
+			uint32_t sourceWidth{ 1 };
+			uint32_t sourceHeight{ 1 };
+			bool initialized{ false };
+			bool built{ false };
+		};
+		VulkanDevice* device{ nullptr };
+		vkglTF::Model* model{ nullptr };
+		PFN_vkCmdDrawIndexedIndirectCount vkCmdDrawIndexedIndirectCount{ nullptr };
+		VkBuffer candidateBuffer{ VK_NULL_HANDLE };
+		MemoryAllocation candidateAllocation;
+		VkDescriptorPool descriptorPool{ VK_NULL_HANDLE };
+		VkDescriptorSetLayout descriptorSetLayout{ VK_NULL_HANDLE };
+		VkPipelineLayout pipelineLayout{ VK_NULL_HANDLE };
+		VkPipeline pipeline{ VK_NULL_HANDLE };
+		std::vector<Frame> frames;
+		DepthPyramid depthPyramid;
+		VkSampler depthSampler{ VK_NULL_HANDLE };
+		VkImageView depthView{ VK_NULL_HANDLE };
+		VkDescriptorPool downsampleDescriptorPool{ VK_NULL_HANDLE };
+		VkDescriptorSetLayout downsampleDescriptorSetLayout{ VK_NULL_HANDLE };
+		VkPipelineLayout downsamplePipelineLayout{ VK_NULL_HANDLE };
+		VkPipeline downsamplePipeline{ VK_NULL_HANDLE };
+		void destroyFrame(Frame& frame);
+		void createDepthPyramid(uint32_t width, uint32_t height);
+		void destroyDepthPyramid();
+		void initializeDepthPyramid(VkCommandBuffer commandBuffer);
+		void dispatchCull(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t phase);
+		void drawIndirect(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t phase);
+	public:
+		/** @brief False if indirect count draws haven't been enabled on the device or the model has nothing to cull, all calls are no-ops in that case */
+		bool enabled{ false };
+		/** @brief Test candidates against the depth pyramid, requires setDepthSource */
+		bool occlusionCulling{ false };
+		Statistics statistics;
+
+		static bool getEnabledFeatures(VkPhysicalDevice physicalDevice, uint32_t apiVersion, VkPhysicalDeviceVulkan12Features& enabledFeatures12, std::vector<const char*>& enabledDeviceExtensions);
+		void create(VulkanDevice* device, vkglTF::Model* model, const VkPipelineShaderStageCreateInfo& cullShaderStage);
+		void destroy();
+		void setDepthSource(VkImageView depthView, uint32_t width, uint32_t height, const VkPipelineShaderStageCreateInfo& downsampleShaderStage);
+		void update(uint32_t frame, const glm::mat4& viewProjection);
+		void cull(VkCommandBuffer commandBuffer, uint32_t frame);
+		void draw(VkCommandBuffer commandBuffer, uint32_t frame);
+		void buildDepthPyramid(VkCommandBuffer commandBuffer);
+		void cullOccluded(VkCommandBuffer commandBuffer, uint32_t frame);
+		void drawOccluded(VkCommandBuffer commandBuffer, uint32_t frame);
+		/**
+		* Material index of every compacted draw of a frame, for shaders that select the material with gl_DrawID (requires shaderDrawParameters):
+		* layout (set = n, binding = m) readonly buffer DrawMaterials { uint drawMaterials[]; };
+		* Late draws start at candidate count, pass it to the shader (e.g. as a push constant) when drawing them
+		*/
+		VkDescriptorBufferInfo getMaterialBufferInfo(uint32_t frame) const;
+	};
+}
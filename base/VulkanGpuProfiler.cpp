@@ -0,0 +1,207 @@
+/*
+* Vulkan GPU profiler
+*
+* Measures GPU execution time of named regions of a command buffer using timestamp queries
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include "VulkanGpuProfiler.h"
+#include "VulkanDevice.h"
+
+namespace vks
+{
+	/**
+	* Create the timestamp query pool
+	*
+	* @param device Vulkan device the profiled command buffers are submitted to (on the graphics queue)
+	* @param frameCount Number of frames in flight, each frame gets its own range of queries
+	* @param synchronization2 True if the synchronization2 feature has been enabled, timestamps are then written with vkCmdWriteTimestamp2
+	* @param maxRegions Max. number of regions per frame (including the frame itself), additional regions are ignored
+	*/
+	void GpuProfiler::create(VulkanDevice* device, uint32_t frameCount, bool synchronization2, uint32_t maxRegions)
+	{
+		this->device = device;
+		const uint32_t timestampValidBits = device->queueFamilyProperties[device->queueFamilyIndices.graphics].timestampValidBits;
+		enabled = (timestampValidBits > 0) && (device->properties.limits.timestampPeriod > 0.0f);
+		if (!enabled) {
+			return;
+		}
+		timestampMask = (timestampValidBits >= 64) ? ~0ULL : ((1ULL << timestampValidBits) - 1);
+		timestampPeriod = device->properties.limits.timestampPeriod;
+		if (synchronization2) {
+			vkCmdWriteTimestamp2 = reinterpret_cast<PFN_vkCmdWriteTimestamp2KHR>(vkGetDeviceProcAddr(device->logicalDevice, "vkCmdWriteTimestamp2"));
+			if (!vkCmdWriteTimestamp2) {
+				vkCmdWriteTimestamp2 = reinterpret_cast<PFN_vkCmdWriteTimestamp2KHR>(vkGetDeviceProcAddr(device->logicalDevice, "vkCmdWriteTimestamp2KHR"));
+			}
+		}
+		queriesPerFrame = maxRegions * 2;
+		frames.resize(frameCount);
+		VkQueryPoolCreateInfo queryPoolCI{
+			.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.queryType = VK_QUERY_TYPE_TIMESTAMP,
+			.queryCount = queriesPerFrame * frameCount,
+		};
+		VK_CHECK_RESULT(vkCreateQueryPool(device->logicalDevice, &queryPoolCI, nullptr, &queryPool));
+		queryResults.resize(queriesPerFrame);
+	}
+
+	/** @brief Release the query pool, the device must be idle */
+	void GpuProfiler::destroy()
+	{
+		if (queryPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(device->logicalDevice, queryPool, nullptr);
+			queryPool = VK_NULL_HANDLE;
+		}
+		frames.clear();
+		statistics.clear();
+		results.clear();
+		enabled = false;
+	}
+
+	uint32_t GpuProfiler::getRegionIndex(const char* name, uint32_t depth)
+	{
+		for (uint32_t i = 0; i < static_cast<uint32_t>(statistics.size()); i++) {
+			if ((statistics[i].depth == depth) && (statistics[i].name == name)) {
+				return i;
+			}
+		}
+		statistics.push_back({ .name = name, .depth = depth });
+		return static_cast<uint32_t>(statistics.size() - 1);
+	}
+
+	void GpuProfiler::writeTimestamp(VkCommandBuffer commandBuffer, uint32_t query, bool begin)
+	{
+		const uint32_t firstQuery = currentFrame * queriesPerFrame;
+		if (vkCmdWriteTimestamp2) {
+			vkCmdWriteTimestamp2(commandBuffer, begin ? VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, queryPool, firstQuery + query);
+		} else {
+			vkCmdWriteTimestamp(commandBuffer, begin ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, firstQuery + query);
+		}
+	}
+
+	/**
+	* Get the timestamps of a previous frame without waiting for them
+	* @note If any of the timestamps isn't available (yet) the frame is skipped
+	*/
+	void GpuProfiler::readResults(uint32_t frameIndex)
+	{
+		FrameQueries& frame = frames[frameIndex];
+		frame.pending = false;
+		if (frame.queryCount == 0) {
+			return;
+		}
+		VkResult result = vkGetQueryPoolResults(device->logicalDevice, queryPool, frameIndex * queriesPerFrame, frame.queryCount, frame.queryCount * sizeof(uint64_t), queryResults.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS) {
+			return;
+		}
+		results.clear();
+		for (auto& region : frame.regions) {
+			// Timestamps may wrap around within the valid bits
+			const uint64_t ticks = ((queryResults[region.endQuery] & timestampMask) - (queryResults[region.beginQuery] & timestampMask)) & timestampMask;
+			const double time = static_cast<double>(ticks) * timestampPeriod / 1000000.0;
+			RegionStatistics& stats = statistics[region.regionIndex];
+			stats.samples++;
+			stats.average += (time - stats.average) / static_cast<double>(stats.samples);
+			stats.min = std::min(stats.min, time);
+			stats.max = std::max(stats.max, time);
+			results.push_back({ .name = stats.name, .depth = stats.depth, .time = time });
+		}
+	}
+
+	/**
+	* Start profiling a new frame, reads back the results of the last frame that used the same index
+	* @note Must be called outside of a render pass, before any other region is recorded to the command buffer
+	*
+	* @param commandBuffer Command buffer to write the timestamps to
+	* @param frameIndex Index of the frame in flight (e.g. currentBuffer), the fence for that frame must have been waited on
+	*/
+	void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		if (!enabled) {
+			return;
+		}
+		assert(frameIndex < frames.size());
+		currentFrame = frameIndex;
+		FrameQueries& frame = frames[frameIndex];
+		if (frame.pending) {
+			readResults(frameIndex);
+		}
+		frame.regions.clear();
+		frame.queryCount = 0;
+		regionStack.clear();
+		vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * queriesPerFrame, queriesPerFrame);
+		beginRegion(commandBuffer, "Frame");
+	}
+
+	/** @brief Finish profiling the current frame, all regions must have been closed */
+	void GpuProfiler::endFrame(VkCommandBuffer commandBuffer)
+	{
+		if (!enabled) {
+			return;
+		}
+		endRegion(commandBuffer);
+		assert(regionStack.empty());
+		frames[currentFrame].pending = true;
+	}
+
+	/**
+	* Start a named region, regions can be nested
+	*
+	* @param commandBuffer Command buffer to write the timestamp to
+	* @param name Name of the region, regions with the same name at the same depth are accumulated into the same statistics
+	*/
+	void GpuProfiler::beginRegion(VkCommandBuffer commandBuffer, const char* name)
+	{
+		if (!enabled) {
+			return;
+		}
+		FrameQueries& frame = frames[currentFrame];
+		if (frame.queryCount + 2 > queriesPerFrame) {
+			regionStack.push_back(UINT32_MAX);
+			return;
+		}
+		const uint32_t regionIndex = getRegionIndex(name, static_cast<uint32_t>(regionStack.size()));
+		// Reserve the end query right away so the closing timestamps of nested regions always fit
+		frame.regions.push_back({ .regionIndex = regionIndex, .beginQuery = frame.queryCount, .endQuery = frame.queryCount + 1 });
+		frame.queryCount += 2;
+		regionStack.push_back(static_cast<uint32_t>(frame.regions.size() - 1));
+		writeTimestamp(commandBuffer, frame.regions.back().beginQuery, true);
+	}
+
+	/** @brief End the most recently started region */
+	void GpuProfiler::endRegion(VkCommandBuffer commandBuffer)
+	{
+		if (!enabled) {
+			return;
+		}
+		assert(!regionStack.empty());
+		const uint32_t index = regionStack.back();
+		regionStack.pop_back();
+		if (index != UINT32_MAX) {
+			writeTimestamp(commandBuffer, frames[currentFrame].regions[index].endQuery, false);
+		}
+	}
+
+	/** @brief Get the accumulated timings in ms of all regions that have been read back at least once */
+	std::vector<GpuProfiler::RegionStatistics> GpuProfiler::getStatistics() const
+	{
+		std::vector<RegionStatistics> regionStatistics;
+		for (auto& stats : statistics) {
+			if (stats.samples > 0) {
+				regionStatistics.push_back(stats);
+			}
+		}
+		return regionStatistics;
+	}
+
+	/** @brief Restart accumulation of the region statistics, e.g. after a benchmark's warmup */
+	void GpuProfiler::resetStatistics()
+	{
+		for (auto& stats : statistics) {
+			stats = { .name = stats.name, .depth = stats.depth };
+		}
+	}
+}
@@ -0,0 +1,93 @@
+/*
+* Vulkan GPU profiler
+*
+* Measures GPU execution time of named regions of a command buffer using timestamp queries
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <limits>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+
+namespace vks
+{
+	struct VulkanDevice;
+
+	/**
+	* @brief Per-frame GPU timings of (nested) command buffer regions based on timestamp queries
+	* @note Every frame in flight gets its own range of the query pool, results of a frame are read back without waiting when that range is reused, which is the case once the frame's fence has been signalled
+	*/
+	class GpuProfiler
+	{
+	public:
+		/** @brief GPU time of a region in the last frame that has been read back */
+		struct Region
+		{
+			std::string name;
+			uint32_t depth{ 0 };
+			double time{ 0.0 };
+		};
+		/** @brief Accumulated GPU time of a region over all frames since the last reset */
+		struct RegionStatistics
+		{
+			std::string name;
+			uint32_t depth{ 0 };
+			double average{ 0.0 };
+			double min{ std::numeric_limits<double>::max() };
+			double max{ 0.0 };
+			uint64_t samples{ 0 };
+		};
+	private:
+		struct RegionQueries
+		{
+			uint32_t regionIndex{ 0 };
+			uint32_t beginQuery{ 0 };
+			uint32_t endQuery{ 0 };
+		};
+		struct FrameQueries
+		{
+			std::vector<RegionQueries> regions;
+			uint32_t queryCount{ 0 };
+			bool pending{ false };
+		};
+		VulkanDevice* device{ nullptr };
+		VkQueryPool queryPool{ VK_NULL_HANDLE };
+		PFN_vkCmdWriteTimestamp2KHR vkCmdWriteTimestamp2{ nullptr };
+		uint32_t queriesPerFrame{ 0 };
+		uint64_t timestampMask{ 0 };
+		double timestampPeriod{ 1.0 };
+		std::vector<FrameQueries> frames;
+		uint32_t currentFrame{ 0 };
+		/** @brief Indices into the open regions of the current frame, UINT32_MAX for regions that got dropped due to the query limit */
+		std::vector<uint32_t> regionStack;
+		/** @brief Region names and nesting depths, regions are identified by their name and depth so statistics can be accumulated across frames */
+		std::vector<RegionStatistics> statistics;
+		std::vector<Region> results;
+		std::vector<uint64_t> queryResults;
+		uint32_t getRegionIndex(const char* name, uint32_t depth);
+		void writeTimestamp(VkCommandBuffer commandBuffer, uint32_t query, bool begin);
+		void readResults(uint32_t frameIndex);
+	public:
+		/** @brief False if the graphics queue doesn't support timestamps, all calls are no-ops in that case */
+		bool enabled{ false };
+
+		void create(VulkanDevice* device, uint32_t frameCount, bool synchronization2 = false, uint32_t maxRegions = 32);
+		void destroy();
+		void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		void endFrame(VkCommandBuffer commandBuffer);
+		void beginRegion(VkCommandBuffer commandBuffer, const char* name);
+		void endRegion(VkCommandBuffer commandBuffer);
+		/** @brief Timings in ms of the most recent frame that has been read back, the first entry is the whole frame */
+		const std::vector<Region>& getResults() const { return results; }
+		std::vector<RegionStatistics> getStatistics() const;
+		void resetStatistics();
+	};
+}
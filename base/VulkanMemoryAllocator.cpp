@@ -0,0 +1,302 @@
+/*
+* Vulkan device memory sub-allocator
+*
+* Carves buffers and images out of large per-memory-type blocks instead of doing one vkAllocateMemory call per resource
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include "VulkanMemoryAllocator.h"
+
+namespace vks
+{
+	/**
+	* Initialize the allocator for the given device
+	*
+	* @param physicalDevice Physical device to read memory properties and limits from
+	* @param device Logical device to allocate memory on
+	*/
+	void MemoryAllocator::init(VkPhysicalDevice physicalDevice, VkDevice device)
+	{
+		this->device = device;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		bufferImageGranularity = std::max(deviceProperties.limits.bufferImageGranularity, VkDeviceSize(1));
+		nonCoherentAtomSize = std::max(deviceProperties.limits.nonCoherentAtomSize, VkDeviceSize(1));
+	}
+
+	/**
+	* Release all device memory blocks
+	*
+	* @note All resources bound to memory from this allocator must have been destroyed before
+	*/
+	void MemoryAllocator::destroy()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& block : blocks) {
+			if (block->mapped) {
+				vkUnmapMemory(device, block->memory);
+			}
+			vkFreeMemory(device, block->memory, nullptr);
+		}
+		blocks.clear();
+	}
+
+	VkResult MemoryAllocator::createBlock(VkDeviceSize size, uint32_t memoryTypeIndex, bool linear, VkMemoryAllocateFlags allocateFlags, bool dedicated, MemoryBlock** block)
+	{
+		VkMemoryAllocateInfo memAlloc{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+			.allocationSize = size,
+			.memoryTypeIndex = memoryTypeIndex
+		};
+		VkMemoryAllocateFlagsInfo allocFlagsInfo{};
+		if (allocateFlags != 0) {
+			allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+			allocFlagsInfo.flags = allocateFlags;
+			memAlloc.pNext = &allocFlagsInfo;
+		}
+		std::unique_ptr<MemoryBlock> newBlock = std::make_unique<MemoryBlock>();
+		VkResult result = vkAllocateMemory(device, &memAlloc, nullptr, &newBlock->memory);
+		if (result != VK_SUCCESS) {
+			return result;
+		}
+		newBlock->size = size;
+		newBlock->memoryTypeIndex = memoryTypeIndex;
+		newBlock->allocateFlags = allocateFlags;
+		newBlock->linear = linear;
+		newBlock->dedicated = dedicated;
+		newBlock->freeRanges[0] = size;
+		// Host visible memory is mapped once for the lifetime of the block, as a memory object can't be mapped more than once at a time
+		if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			result = vkMapMemory(device, newBlock->memory, 0, VK_WHOLE_SIZE, 0, &newBlock->mapped);
+			if (result != VK_SUCCESS) {
+				vkFreeMemory(device, newBlock->memory, nullptr);
+				return result;
+			}
+		}
+		*block = newBlock.get();
+		blocks.push_back(std::move(newBlock));
+		return VK_SUCCESS;
+	}
+
+	void MemoryAllocator::destroyBlock(MemoryBlock* block)
+	{
+		if (block->mapped) {
+			vkUnmapMemory(device, block->memory);
+		}
+		vkFreeMemory(device, block->memory, nullptr);
+		blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [block](const std::unique_ptr<MemoryBlock>& b) { return b.get() == block; }), blocks.end());
+	}
+
+	bool MemoryAllocator::allocateFromBlock(MemoryBlock* block, VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation& allocation)
+	{
+		// First fit
+		for (auto it = block->freeRanges.begin(); it != block->freeRanges.end(); it++) {
+			const VkDeviceSize rangeStart = it->first;
+			const VkDeviceSize rangeEnd = it->first + it->second;
+			const VkDeviceSize alignedOffset = vks::tools::alignedVkSize(rangeStart, alignment);
+			if (alignedOffset + size > rangeEnd) {
+				continue;
+			}
+			// Split the free range, padding in front of the allocation stays free
+			block->freeRanges.erase(it);
+			if (alignedOffset > rangeStart) {
+				block->freeRanges[rangeStart] = alignedOffset - rangeStart;
+			}
+			if (alignedOffset + size < rangeEnd) {
+				block->freeRanges[alignedOffset + size] = rangeEnd - (alignedOffset + size);
+			}
+			block->allocationCount++;
+			allocation.memory = block->memory;
+			allocation.offset = alignedOffset;
+			allocation.size = size;
+			allocation.mapped = block->mapped ? static_cast<uint8_t*>(block->mapped) + alignedOffset : nullptr;
+			allocation.block = block;
+			allocation.allocator = this;
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	* Sub-allocate memory for a resource
+	*
+	* @param memoryRequirements Memory requirements of the resource (from vkGet*MemoryRequirements)
+	* @param memoryTypeIndex Index of the memory type to allocate from
+	* @param linear True for buffers and linear images, false for optimal tiled images
+	* @param allocateFlags Flags the backing memory needs to be allocated with (e.g. VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT)
+	* @param allocation Receives the allocated memory range
+	*
+	* @return VK_SUCCESS if the allocation could be fulfilled
+	*/
+	VkResult MemoryAllocator::allocate(const VkMemoryRequirements& memoryRequirements, uint32_t memoryTypeIndex, bool linear, VkMemoryAllocateFlags allocateFlags, MemoryAllocation& allocation)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		VkDeviceSize size = memoryRequirements.size;
+		VkDeviceSize alignment = std::max(memoryRequirements.alignment, VkDeviceSize(1));
+		// Mapped ranges of non-coherent memory need to be flushed at nonCoherentAtomSize granularity, so align allocations to that to not touch neighbours
+		const VkMemoryPropertyFlags propertyFlags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+		if ((propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+			alignment = std::max(alignment, nonCoherentAtomSize);
+			size = vks::tools::alignedVkSize(size, nonCoherentAtomSize);
+		}
+		// Only separate linear and optimal resources if the device actually has a granularity restriction
+		if (bufferImageGranularity == 1) {
+			linear = true;
+		}
+
+		// Smaller heaps (e.g. host visible device local memory) get smaller blocks
+		const VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+		const VkDeviceSize typeBlockSize = std::min(blockSize, heapSize / 8);
+
+		// Large resources get their own memory object
+		if (size > typeBlockSize / 2) {
+			MemoryBlock* block{ nullptr };
+			VkResult result = createBlock(size, memoryTypeIndex, linear, allocateFlags, true, &block);
+			if (result != VK_SUCCESS) {
+				return result;
+			}
+			allocateFromBlock(block, size, alignment, allocation);
+			return VK_SUCCESS;
+		}
+
+		for (auto& block : blocks) {
+			if (block->dedicated || (block->memoryTypeIndex != memoryTypeIndex) || (block->linear != linear) || (block->allocateFlags != allocateFlags)) {
+				continue;
+			}
+			if (allocateFromBlock(block.get(), size, alignment, allocation)) {
+				return VK_SUCCESS;
+			}
+		}
+
+		MemoryBlock* block{ nullptr };
+		VkResult result = createBlock(typeBlockSize, memoryTypeIndex, linear, allocateFlags, false, &block);
+		if (result != VK_SUCCESS) {
+			return result;
+		}
+		allocateFromBlock(block, size, alignment, allocation);
+		return VK_SUCCESS;
+	}
+
+	/**
+	* Return an allocation to its block
+	*
+	* @param allocation Allocation to free, will be reset
+	*/
+	void MemoryAllocator::free(MemoryAllocation& allocation)
+	{
+		if (!allocation.valid()) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		MemoryBlock* block = allocation.block;
+		assert(block->allocationCount > 0);
+		// Insert the range and merge it with adjacent free ranges
+		VkDeviceSize offset = allocation.offset;
+		VkDeviceSize size = allocation.size;
+		auto next = block->freeRanges.lower_bound(offset);
+		if (next != block->freeRanges.end() && (offset + size == next->first)) {
+			size += next->second;
+			next = block->freeRanges.erase(next);
+		}
+		if (next != block->freeRanges.begin()) {
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset) {
+				offset = prev->first;
+				size += prev->second;
+				block->freeRanges.erase(prev);
+			}
+		}
+		block->freeRanges[offset] = size;
+		block->allocationCount--;
+		allocation = {};
+
+		if (block->allocationCount == 0) {
+			// Keep one empty block per memory type around, so frequently recreated resources don't cause allocations from the driver
+			bool release = block->dedicated;
+			if (!release) {
+				for (auto& b : blocks) {
+					if ((b.get() != block) && !b->dedicated && (b->allocationCount == 0) && (b->memoryTypeIndex == block->memoryTypeIndex) && (b->linear == block->linear) && (b->allocateFlags == block->allocateFlags)) {
+						release = true;
+						break;
+					}
+				}
+			}
+			if (release) {
+				destroyBlock(block);
+			}
+		}
+	}
+
+	VkMappedMemoryRange MemoryAllocator::getMappedRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const
+	{
+		// Ranges need to be aligned to nonCoherentAtomSize, allocations from non-coherent memory are padded to that so this stays within the allocation
+		VkDeviceSize start = allocation.offset + offset;
+		VkDeviceSize end = (size == VK_WHOLE_SIZE) ? allocation.offset + allocation.size : std::min(start + size, allocation.offset + allocation.size);
+		start = (start / nonCoherentAtomSize) * nonCoherentAtomSize;
+		end = std::min(vks::tools::alignedVkSize(end, nonCoherentAtomSize), allocation.block->size);
+		VkMappedMemoryRange mappedRange{
+			.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+			.memory = allocation.memory,
+			.offset = start,
+			.size = end - start
+		};
+		return mappedRange;
+	}
+
+	/**
+	* Flush a range of a host visible allocation to make host writes visible to the device
+	*
+	* @note Only required for non-coherent memory
+	*/
+	VkResult MemoryAllocator::flush(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		VkMappedMemoryRange mappedRange = getMappedRange(allocation, offset, size);
+		return vkFlushMappedMemoryRanges(device, 1, &mappedRange);
+	}
+
+	/**
+	* Invalidate a range of a host visible allocation to make device writes visible to the host
+	*
+	* @note Only required for non-coherent memory
+	*/
+	VkResult MemoryAllocator::invalidate(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		VkMappedMemoryRange mappedRange = getMappedRange(allocation, offset, size);
+		return vkInvalidateMappedMemoryRanges(device, 1, &mappedRange);
+	}
+
+	/** @brief Gather block, usage and fragmentation statistics */
+	MemoryStatistics MemoryAllocator::getStatistics()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		MemoryStatistics stats{};
+		VkDeviceSize freeBytes{ 0 };
+		VkDeviceSize largestFreeRanges{ 0 };
+		for (auto& block : blocks) {
+			stats.blockCount++;
+			stats.blockBytes += block->size;
+			stats.allocationCount += block->allocationCount;
+			if (block->dedicated) {
+				stats.dedicatedBlockCount++;
+			}
+			VkDeviceSize blockFree{ 0 };
+			VkDeviceSize largestFreeRange{ 0 };
+			for (auto& range : block->freeRanges) {
+				blockFree += range.second;
+				largestFreeRange = std::max(largestFreeRange, range.second);
+			}
+			freeBytes += blockFree;
+			largestFreeRanges += largestFreeRange;
+			stats.usedBytes += block->size - blockFree;
+		}
+		if (freeBytes > 0) {
+			stats.fragmentation = 1.0f - (float)largestFreeRanges / (float)freeBytes;
+		}
+		return stats;
+	}
+}
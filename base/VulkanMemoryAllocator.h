@@ -0,0 +1,96 @@
+/*
+* Vulkan device memory sub-allocator
+*
+* Carves buffers and images out of large per-memory-type blocks instead of doing one vkAllocateMemory call per resource
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+
+namespace vks
+{
+	class MemoryAllocator;
+
+	/** @brief Device memory object that allocations are sub-allocated from */
+	struct MemoryBlock
+	{
+		VkDeviceMemory memory{ VK_NULL_HANDLE };
+		VkDeviceSize size{ 0 };
+		uint32_t memoryTypeIndex{ 0 };
+		VkMemoryAllocateFlags allocateFlags{ 0 };
+		/** @brief Linear resources (buffers, linear images) and optimal images are kept in separate blocks to honor bufferImageGranularity */
+		bool linear{ true };
+		/** @brief Dedicated blocks back exactly one (large) allocation */
+		bool dedicated{ false };
+		/** @brief Host visible blocks are persistently mapped for their whole lifetime */
+		void* mapped{ nullptr };
+		uint32_t allocationCount{ 0 };
+		/** @brief Free ranges of the block, offset -> size */
+		std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+	};
+
+	/** @brief Range of device memory handed out by the memory allocator */
+	struct MemoryAllocation
+	{
+		VkDeviceMemory memory{ VK_NULL_HANDLE };
+		VkDeviceSize offset{ 0 };
+		VkDeviceSize size{ 0 };
+		/** @brief Host pointer to the start of the allocation (only set for host visible memory) */
+		void* mapped{ nullptr };
+		MemoryBlock* block{ nullptr };
+		MemoryAllocator* allocator{ nullptr };
+		bool valid() const { return allocator != nullptr; }
+	};
+
+	/** @brief Usage statistics of the memory allocator */
+	struct MemoryStatistics
+	{
+		/** @brief Number of device memory objects allocated from the driver (including dedicated ones) */
+		uint32_t blockCount{ 0 };
+		uint32_t dedicatedBlockCount{ 0 };
+		uint32_t allocationCount{ 0 };
+		/** @brief Total size of all device memory objects */
+		VkDeviceSize blockBytes{ 0 };
+		/** @brief Bytes handed out to allocations */
+		VkDeviceSize usedBytes{ 0 };
+		/** @brief 1 - (sum of the largest free range of each block / total free space), 0 means the free space of every block is contiguous */
+		float fragmentation{ 0.0f };
+	};
+
+	class MemoryAllocator
+	{
+	private:
+		VkDevice device{ VK_NULL_HANDLE };
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		VkDeviceSize bufferImageGranularity{ 1 };
+		VkDeviceSize nonCoherentAtomSize{ 1 };
+		std::vector<std::unique_ptr<MemoryBlock>> blocks;
+		std::mutex mutex;
+		VkResult createBlock(VkDeviceSize size, uint32_t memoryTypeIndex, bool linear, VkMemoryAllocateFlags allocateFlags, bool dedicated, MemoryBlock** block);
+		void destroyBlock(MemoryBlock* block);
+		bool allocateFromBlock(MemoryBlock* block, VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation& allocation);
+		VkMappedMemoryRange getMappedRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+	public:
+		/** @brief Default size of the blocks that allocations are carved out of (clamped to a fraction of the heap size) */
+		VkDeviceSize blockSize{ 64 * 1024 * 1024 };
+
+		void init(VkPhysicalDevice physicalDevice, VkDevice device);
+		void destroy();
+		VkResult allocate(const VkMemoryRequirements& memoryRequirements, uint32_t memoryTypeIndex, bool linear, VkMemoryAllocateFlags allocateFlags, MemoryAllocation& allocation);
+		void free(MemoryAllocation& allocation);
+		VkResult flush(const MemoryAllocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+		VkResult invalidate(const MemoryAllocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+		MemoryStatistics getStatistics();
+	};
+}
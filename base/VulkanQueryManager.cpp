@@ -0,0 +1,181 @@
+/*
+* Vulkan query manager
+*
+* Non-blocking occlusion and pipeline statistics queries, results are read back once the frame that recorded them has finished on the GPU
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include "VulkanQueryManager.h"
+#include "VulkanDevice.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace vks
+{
+	/**
+	* Create the query pool and the host visible buffer the results are copied to
+	*
+	* @param device Vulkan device the command buffers with the queries are submitted to
+	* @param queryType Type of the queries, VK_QUERY_TYPE_OCCLUSION or VK_QUERY_TYPE_PIPELINE_STATISTICS
+	* @param queryCount Number of queries per frame
+	* @param frameCount Number of frames in flight, each frame gets its own range of queries
+	* @param pipelineStatistics Counters returned by pipeline statistics queries (requires the pipelineStatisticsQuery feature), each one is a value of the query's results
+	*/
+	void QueryManager::create(VulkanDevice* device, VkQueryType queryType, uint32_t queryCount, uint32_t frameCount, VkQueryPipelineStatisticFlags pipelineStatistics)
+	{
+		this->device = device;
+		this->queryCount = queryCount;
+		valuesPerQuery = (queryType == VK_QUERY_TYPE_PIPELINE_STATISTICS) ? static_cast<uint32_t>(std::popcount(pipelineStatistics)) : 1;
+		resultStride = (valuesPerQuery + 1) * sizeof(uint64_t);
+		VkQueryPoolCreateInfo queryPoolCI{
+			.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.queryType = queryType,
+			.queryCount = queryCount * frameCount,
+			.pipelineStatistics = (queryType == VK_QUERY_TYPE_PIPELINE_STATISTICS) ? pipelineStatistics : 0,
+		};
+		VK_CHECK_RESULT(vkCreateQueryPool(device->logicalDevice, &queryPoolCI, nullptr, &queryPool));
+		VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, resultStride * queryCount * frameCount, &resultBuffer, &resultAllocation));
+		frames.resize(frameCount);
+		for (FrameQueries& frame : frames) {
+			frame.used.resize(queryCount, false);
+		}
+		results.values.resize(queryCount * valuesPerQuery, 0);
+		enabled = true;
+	}
+
+	/** @brief Release the query pool and the result buffer, the device must be idle */
+	void QueryManager::destroy()
+	{
+		if (queryPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(device->logicalDevice, queryPool, nullptr);
+			queryPool = VK_NULL_HANDLE;
+			vkDestroyBuffer(device->logicalDevice, resultBuffer, nullptr);
+			device->freeMemory(resultAllocation);
+			resultBuffer = VK_NULL_HANDLE;
+		}
+		frames.clear();
+		results = {};
+		enabled = false;
+	}
+
+	/**
+	* Read the results the GPU copied for a previous frame
+	* @note Queries without the availability bit set keep the values of an earlier frame
+	*/
+	void QueryManager::readResults(uint32_t frameIndex)
+	{
+		FrameQueries& frame = frames[frameIndex];
+		frame.pending = false;
+		const uint8_t* frameResults = static_cast<const uint8_t*>(resultAllocation.mapped) + frameIndex * queryCount * resultStride;
+		bool available = false;
+		for (uint32_t query = 0; query < queryCount; query++) {
+			if (!frame.used[query]) {
+				continue;
+			}
+			const uint64_t* queryResults = reinterpret_cast<const uint64_t*>(frameResults + query * resultStride);
+			if (queryResults[valuesPerQuery] == 0) {
+				continue;
+			}
+			std::copy(queryResults, queryResults + valuesPerQuery, results.values.begin() + query * valuesPerQuery);
+			available = true;
+		}
+		if (available) {
+			results.frame = frame.frame;
+			results.latency = static_cast<uint32_t>(frameCounter - frame.frame);
+			results.available = true;
+		}
+	}
+
+	/**
+	* Start recording the queries of a new frame, reads back the results of the last frame that used the same index
+	* @note Must be called outside of a render pass, before any query of the frame is recorded
+	*
+	* @param commandBuffer Command buffer the queries are recorded to
+	* @param frameIndex Index of the frame in flight (e.g. currentBuffer), the fence for that frame must have been waited on
+	*/
+	void QueryManager::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		if (!enabled) {
+			return;
+		}
+		assert(frameIndex < frames.size());
+		frameCounter++;
+		currentFrame = frameIndex;
+		FrameQueries& frame = frames[frameIndex];
+		if (frame.pending) {
+			readResults(frameIndex);
+		}
+		std::fill(frame.used.begin(), frame.used.end(), false);
+		frame.frame = frameCounter;
+		vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * queryCount, queryCount);
+	}
+
+	/**
+	* Copy the results of the frame's queries to the result buffer on the GPU
+	* @note Must be called outside of a render pass, after all queries of the frame have been ended
+	*/
+	void QueryManager::endFrame(VkCommandBuffer commandBuffer)
+	{
+		if (!enabled) {
+			return;
+		}
+		FrameQueries& frame = frames[currentFrame];
+		const uint32_t firstQuery = currentFrame * queryCount;
+		// The copy waits on the GPU for the queries to finish, so only queries that have actually been recorded are copied (in contiguous ranges)
+		uint32_t query = 0;
+		while (query < queryCount) {
+			if (!frame.used[query]) {
+				query++;
+				continue;
+			}
+			uint32_t rangeEnd = query;
+			while ((rangeEnd < queryCount) && frame.used[rangeEnd]) {
+				rangeEnd++;
+			}
+			vkCmdCopyQueryPoolResults(commandBuffer, queryPool, firstQuery + query, rangeEnd - query, resultBuffer, (firstQuery + query) * resultStride, resultStride, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+			query = rangeEnd;
+		}
+		VkMemoryBarrier memoryBarrier{ .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER, .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT, .dstAccessMask = VK_ACCESS_HOST_READ_BIT };
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+		frame.pending = true;
+	}
+
+	/**
+	* Begin a query of the current frame
+	*
+	* @param commandBuffer Command buffer to record the query to
+	* @param query Index of the query within the frame
+	* @param flags Control flags, e.g. VK_QUERY_CONTROL_PRECISE_BIT for exact sample counts of occlusion queries
+	*/
+	void QueryManager::beginQuery(VkCommandBuffer commandBuffer, uint32_t query, VkQueryControlFlags flags)
+	{
+		if (!enabled) {
+			return;
+		}
+		assert(query < queryCount);
+		vkCmdBeginQuery(commandBuffer, queryPool, currentFrame * queryCount + query, flags);
+	}
+
+	/** @brief End a query of the current frame */
+	void QueryManager::endQuery(VkCommandBuffer commandBuffer, uint32_t query)
+	{
+		if (!enabled) {
+			return;
+		}
+		assert(query < queryCount);
+		vkCmdEndQuery(commandBuffer, queryPool, currentFrame * queryCount + query);
+		frames[currentFrame].used[query] = true;
+	}
+
+	uint64_t QueryManager::getResult(uint32_t query, uint32_t value) const
+	{
+		if ((query >= queryCount) || (value >= valuesPerQuery)) {
+			return 0;
+		}
+		return results.values[query * valuesPerQuery + value];
+	}
+}
@@ -0,0 +1,78 @@
+/*
+* Vulkan query manager
+*
+* Non-blocking occlusion and pipeline statistics queries, results are read back once the frame that recorded them has finished on the GPU
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanMemoryAllocator.h"
+
+namespace vks
+{
+	struct VulkanDevice;
+
+	/**
+	* @brief Occlusion or pipeline statistics queries without stalling the CPU
+	* @note Every frame in flight gets its own range of the query pool, the results are copied on the GPU into a host visible buffer with vkCmdCopyQueryPoolResults
+	* @note The results of a frame are read when its range is reused, which is the case once the frame's fence has been signalled, so they lag behind by the number of frames in flight
+	*/
+	class QueryManager
+	{
+	public:
+		/** @brief Results of the most recent frame that has been read back */
+		struct Results
+		{
+			/** @brief valuesPerQuery consecutive values for every query, queries that weren't available keep their previous values */
+			std::vector<uint64_t> values;
+			/** @brief Number of the frame that recorded the queries (counted by beginFrame) */
+			uint64_t frame{ 0 };
+			/** @brief Number of frames between recording the queries and reading back their results */
+			uint32_t latency{ 0 };
+			bool available{ false };
+		};
+	private:
+		struct FrameQueries
+		{
+			// Queries that have been ended in the frame, only these are copied and read back
+			std::vector<bool> used;
+			uint64_t frame{ 0 };
+			bool pending{ false };
+		};
+		VulkanDevice* device{ nullptr };
+		VkQueryPool queryPool{ VK_NULL_HANDLE };
+		VkBuffer resultBuffer{ VK_NULL_HANDLE };
+		MemoryAllocation resultAllocation;
+		uint32_t queryCount{ 0 };
+		uint32_t valuesPerQuery{ 1 };
+		// Values plus the availability of a single query in the result buffer
+		VkDeviceSize resultStride{ 0 };
+		std::vector<FrameQueries> frames;
+		uint32_t currentFrame{ 0 };
+		uint64_t frameCounter{ 0 };
+		Results results;
+		void readResults(uint32_t frameIndex);
+	public:
+		/** @brief False until created, all calls are no-ops in that case */
+		bool enabled{ false };
+
+		void create(VulkanDevice* device, VkQueryType queryType, uint32_t queryCount, uint32_t frameCount, VkQueryPipelineStatisticFlags pipelineStatistics = 0);
+		void destroy();
+		void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		void endFrame(VkCommandBuffer commandBuffer);
+		void beginQuery(VkCommandBuffer commandBuffer, uint32_t query, VkQueryControlFlags flags = 0);
+		void endQuery(VkCommandBuffer commandBuffer, uint32_t query);
+		const Results& getResults() const { return results; }
+		/** @brief Get a single value of a query from the most recent results, e.g. the number of passed samples of an occlusion query */
+		uint64_t getResult(uint32_t query, uint32_t value = 0) const;
+		uint32_t getValuesPerQuery() const { return valuesPerQuery; }
+	};
+}
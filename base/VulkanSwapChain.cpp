@@ -345,14 +345,162 @@ void VulkanSwapChain::create(uint32_t& width, uint32_t& height, bool vsync, bool
 	}
 }
 
+void VulkanSwapChain::createHeadless(uint32_t width, uint32_t height, uint32_t imageCount, VkQueue queue)
+{
+	assert(physicalDevice);
+	assert(device);
+
+	destroyHeadlessImages();
+	headless = true;
+	headlessQueue = queue;
+	headlessNextImage = 0;
+
+	// Use the same preferred formats as for a surface, but only require support as a color attachment and for transfers (e.g. screenshots)
+	const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+	std::vector<VkFormat> preferredImageFormats = {
+		VK_FORMAT_B8G8R8A8_UNORM,
+		VK_FORMAT_R8G8B8A8_UNORM,
+		VK_FORMAT_A8B8G8R8_UNORM_PACK32
+	};
+	colorFormat = VK_FORMAT_UNDEFINED;
+	for (auto& format : preferredImageFormats) {
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+		if ((formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures) {
+			colorFormat = format;
+			break;
+		}
+	}
+	if (colorFormat == VK_FORMAT_UNDEFINED) {
+		vks::tools::exitFatal("Could not find a color format for headless rendering!", -1);
+	}
+	colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+
+	// Without a surface there are no present capabilities to check, so simply use the first graphics queue family
+	uint32_t queueCount;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueProps(queueCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, queueProps.data());
+	for (uint32_t i = 0; i < queueCount; i++) {
+		if ((queueProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+			queueNodeIndex = i;
+			break;
+		}
+	}
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	this->imageCount = imageCount;
+	images.resize(imageCount);
+	imageViews.resize(imageCount);
+	headlessMemory.resize(imageCount);
+	for (uint32_t i = 0; i < imageCount; i++) {
+		VkImageCreateInfo imageCI{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+			.imageType = VK_IMAGE_TYPE_2D,
+			.format = colorFormat,
+			.extent = { width, height, 1 },
+			.mipLevels = 1,
+			.arrayLayers = 1,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.tiling = VK_IMAGE_TILING_OPTIMAL,
+			.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+		};
+		VK_CHECK_RESULT(vkCreateImage(device, &imageCI, nullptr, &images[i]));
+		VkMemoryRequirements memReqs;
+		vkGetImageMemoryRequirements(device, images[i], &memReqs);
+		uint32_t memoryTypeIndex = UINT32_MAX;
+		for (uint32_t j = 0; j < memoryProperties.memoryTypeCount; j++) {
+			if ((memReqs.memoryTypeBits & (1 << j)) && (memoryProperties.memoryTypes[j].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+				memoryTypeIndex = j;
+				break;
+			}
+		}
+		if (memoryTypeIndex == UINT32_MAX) {
+			vks::tools::exitFatal("Could not find a memory type for headless rendering!", -1);
+		}
+		VkMemoryAllocateInfo memAllocInfo{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+			.allocationSize = memReqs.size,
+			.memoryTypeIndex = memoryTypeIndex
+		};
+		VK_CHECK_RESULT(vkAllocateMemory(device, &memAllocInfo, nullptr, &headlessMemory[i]));
+		VK_CHECK_RESULT(vkBindImageMemory(device, images[i], headlessMemory[i], 0));
+		VkImageViewCreateInfo colorAttachmentView{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.image = images[i],
+			.viewType = VK_IMAGE_VIEW_TYPE_2D,
+			.format = colorFormat,
+			.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A },
+			.subresourceRange = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.baseMipLevel = 0,
+				.levelCount = 1,
+				.baseArrayLayer = 0,
+				.layerCount = 1
+			},
+		};
+		VK_CHECK_RESULT(vkCreateImageView(device, &colorAttachmentView, nullptr, &imageViews[i]));
+	}
+}
+
+void VulkanSwapChain::destroyHeadlessImages()
+{
+	if (!headless) {
+		return;
+	}
+	for (size_t i = 0; i < images.size(); i++) {
+		vkDestroyImageView(device, imageViews[i], nullptr);
+		vkDestroyImage(device, images[i], nullptr);
+		vkFreeMemory(device, headlessMemory[i], nullptr);
+	}
+	images.clear();
+	imageViews.clear();
+	headlessMemory.clear();
+}
+
 VkResult VulkanSwapChain::acquireNextImage(VkSemaphore presentCompleteSemaphore, uint32_t& imageIndex)
 {
+	if (headless) {
+		imageIndex = headlessNextImage;
+		headlessNextImage = (headlessNextImage + 1) % imageCount;
+		// There is no presentation engine that signals the semaphore, so an empty submit does it to keep the same synchronization as with a swapchain
+		if (presentCompleteSemaphore != VK_NULL_HANDLE) {
+			VkSubmitInfo submitInfo{ .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO, .signalSemaphoreCount = 1, .pSignalSemaphores = &presentCompleteSemaphore };
+			return vkQueueSubmit(headlessQueue, 1, &submitInfo, VK_NULL_HANDLE);
+		}
+		return VK_SUCCESS;
+	}
 	// By setting timeout to UINT64_MAX we will always wait until the next image has been acquired or an actual error is thrown
 	// With that we don't have to handle VK_NOT_READY
 	return vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, presentCompleteSemaphore, (VkFence)nullptr, &imageIndex);
 }
+VkResult VulkanSwapChain::queuePresent(VkQueue queue, uint32_t imageIndex, VkSemaphore waitSemaphore)
+{
+	if (headless) {
+		// Nothing to present, but the semaphore still needs to be waited on (unsignalled) before it can be signalled again
+		const VkPipelineStageFlags waitStageMask{ VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+		VkSubmitInfo submitInfo{ .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO, .waitSemaphoreCount = 1, .pWaitSemaphores = &waitSemaphore, .pWaitDstStageMask = &waitStageMask };
+		return vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+	}
+	VkPresentInfoKHR presentInfo{
+		.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+		.waitSemaphoreCount = 1,
+		.pWaitSemaphores = &waitSemaphore,
+		.swapchainCount = 1,
+		.pSwapchains = &swapChain,
+		.pImageIndices = &imageIndex
+	};
+	return vkQueuePresentKHR(queue, &presentInfo);
+}
+
 void VulkanSwapChain::cleanup()
 {
+	destroyHeadlessImages();
+	headless = false;
 	if (swapChain != VK_NULL_HANDLE) {
 		for (auto i = 0; i < images.size(); i++) {
 			vkDestroyImageView(device, imageViews[i], nullptr);
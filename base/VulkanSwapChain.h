@@ -34,6 +34,11 @@ private:
 	VkDevice device{ VK_NULL_HANDLE };
 	VkPhysicalDevice physicalDevice{ VK_NULL_HANDLE };
 	VkSurfaceKHR surface{ VK_NULL_HANDLE };
+	// Headless mode renders into a ring of offscreen images instead of presentable swapchain images
+	std::vector<VkDeviceMemory> headlessMemory{};
+	VkQueue headlessQueue{ VK_NULL_HANDLE };
+	uint32_t headlessNextImage{ 0 };
+	void destroyHeadlessImages();
 public:
 	VkFormat colorFormat{};
 	VkColorSpaceKHR colorSpace{};
@@ -42,6 +47,8 @@ public:
 	std::vector<VkImageView> imageViews{};
 	uint32_t queueNodeIndex{ UINT32_MAX };
 	uint32_t imageCount{ 0 };
+	/** @brief True if the images are offscreen images created by createHeadless() */
+	bool headless{ false };
 
 #if defined(VK_USE_PLATFORM_WIN32_KHR)
 	void initSurface(void* platformHandle, void* platformWindow);
@@ -76,6 +83,15 @@ public:
 	*/
 	void create(uint32_t& width, uint32_t& height, bool vsync = false, bool fullscreen = false);
 	/**
+	* Create a ring of offscreen color images used in place of the swapchain images, no surface or window system is required
+	*
+	* @param width Width of the images
+	* @param height Height of the images
+	* @param imageCount Number of images in the ring, images are handed out in order, so with as many images as frames in flight an image is free for reuse once the frame's fence has been signalled
+	* @param queue Queue used to signal and wait on the semaphores passed to acquireNextImage and queuePresent
+	*/
+	void createHeadless(uint32_t width, uint32_t height, uint32_t imageCount, VkQueue queue);
+	/**
 	* Acquires the next image in the swap chain
 	* 
 	* @param presentCompleteSemaphore (Optional) Semaphore that is signaled when the image is ready for use
@@ -86,6 +102,16 @@ public:
 	* @return VkResult of the image acquisition
 	*/
 	VkResult acquireNextImage(VkSemaphore presentCompleteSemaphore, uint32_t& imageIndex);
+	/**
+	* Queue an image for presentation
+	*
+	* @param queue Presentation queue
+	* @param imageIndex Index of the image to present
+	* @param waitSemaphore Semaphore that is waited on before the image is presented
+	*
+	* @return VkResult of the queue presentation
+	*/
+	VkResult queuePresent(VkQueue queue, uint32_t imageIndex, VkSemaphore waitSemaphore);
 	/* Free all Vulkan resources acquired by the swapchain */
 	void cleanup();
 };
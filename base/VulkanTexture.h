@@ -35,6 +35,7 @@ class Texture
 	VkImage               image;
 	VkImageLayout         imageLayout;
 	VkDeviceMemory        deviceMemory;
+	vks::MemoryAllocation allocation{};
 	VkImageView           view;
 	uint32_t              width, height;
 	uint32_t              mipLevels;
@@ -44,7 +45,14 @@ class Texture
 
 	void      updateDescriptor();
 	void      destroy();
-	ktxResult loadKTXFile(std::string filename, ktxTexture **target);
+
+  protected:
+#if defined(__ANDROID__)
+	AAsset *ktxAsset{nullptr};
+#endif
+	ktxResult openKTXFile(std::string filename, ktxTexture **target);
+	void      closeKTXFile(ktxTexture *ktxTexture);
+	void      uploadKTXImageData(ktxTexture *ktxTexture, const std::vector<VkBufferImageCopy> &regions, const VkImageSubresourceRange &subresourceRange);
 };
 
 class Texture2D : public Texture
@@ -0,0 +1,383 @@
+/*
+* Vulkan upload manager
+*
+* Batches buffer and image uploads through a persistently mapped staging ring into few submits on the transfer queue
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include "VulkanUploadManager.h"
+#include "VulkanDevice.h"
+
+namespace vks
+{
+	/**
+	* Create the command pools used for recording upload batches
+	*
+	* @param device Vulkan device to upload to
+	* @param transferQueue Queue from queueFamilyIndices.transfer used for the copies
+	* @param graphicsQueue Queue from queueFamilyIndices.graphics that acquires the uploaded resources
+	*/
+	void UploadManager::create(VulkanDevice* device, VkQueue transferQueue, VkQueue graphicsQueue)
+	{
+		this->device = device;
+		this->transferQueue = transferQueue;
+		this->graphicsQueue = graphicsQueue;
+		transferQueueFamilyIndex = device->queueFamilyIndices.transfer;
+		graphicsQueueFamilyIndex = device->queueFamilyIndices.graphics;
+		ownershipTransfer = (transferQueueFamilyIndex != graphicsQueueFamilyIndex);
+		// Copy offsets need to be aligned to the texel block size of compressed formats (at most 16 bytes)
+		stagingAlignment = std::max(device->properties.limits.optimalBufferCopyOffsetAlignment, VkDeviceSize(16));
+		transferCommandPool = device->createCommandPool(transferQueueFamilyIndex);
+		if (ownershipTransfer) {
+			graphicsCommandPool = device->createCommandPool(graphicsQueueFamilyIndex);
+		}
+	}
+
+	/** @brief Wait for all pending uploads and release all resources */
+	void UploadManager::destroy()
+	{
+		if (!device) {
+			return;
+		}
+		waitIdle();
+		for (auto& batch : freeBatches) {
+			vkDestroyFence(device->logicalDevice, batch.fence, nullptr);
+			if (batch.ownershipSemaphore != VK_NULL_HANDLE) {
+				vkDestroySemaphore(device->logicalDevice, batch.ownershipSemaphore, nullptr);
+			}
+		}
+		freeBatches.clear();
+		if (stagingBuffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
+			device->freeMemory(stagingAllocation);
+			stagingBuffer = VK_NULL_HANDLE;
+		}
+		vkDestroyCommandPool(device->logicalDevice, transferCommandPool, nullptr);
+		if (graphicsCommandPool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(device->logicalDevice, graphicsCommandPool, nullptr);
+		}
+		device = nullptr;
+	}
+
+	void UploadManager::beginBatch()
+	{
+		if (recording) {
+			return;
+		}
+		if (!freeBatches.empty()) {
+			current = std::move(freeBatches.back());
+			freeBatches.pop_back();
+		} else {
+			current = {};
+			VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(transferCommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(device->logicalDevice, &cmdBufAllocateInfo, &current.transferCommandBuffer));
+			if (ownershipTransfer) {
+				cmdBufAllocateInfo.commandPool = graphicsCommandPool;
+				VK_CHECK_RESULT(vkAllocateCommandBuffers(device->logicalDevice, &cmdBufAllocateInfo, &current.graphicsCommandBuffer));
+				VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
+				VK_CHECK_RESULT(vkCreateSemaphore(device->logicalDevice, &semaphoreCreateInfo, nullptr, &current.ownershipSemaphore));
+			}
+			VkFenceCreateInfo fenceCreateInfo = vks::initializers::fenceCreateInfo();
+			VK_CHECK_RESULT(vkCreateFence(device->logicalDevice, &fenceCreateInfo, nullptr, &current.fence));
+		}
+		VkCommandBufferBeginInfo cmdBufferBeginInfo = vks::initializers::commandBufferBeginInfo();
+		cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(current.transferCommandBuffer, &cmdBufferBeginInfo));
+		if (ownershipTransfer) {
+			VK_CHECK_RESULT(vkBeginCommandBuffer(current.graphicsCommandBuffer, &cmdBufferBeginInfo));
+		}
+		recording = true;
+	}
+
+	UploadManager::Token UploadManager::submitBatch()
+	{
+		if (!recording) {
+			return nextToken - 1;
+		}
+		// Make buffer copies visible to all later commands on the graphics queue (images and ownership transfers have their own barriers)
+		if (current.bufferUploads && !ownershipTransfer) {
+			VkMemoryBarrier memoryBarrier = vks::initializers::memoryBarrier();
+			memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			vkCmdPipelineBarrier(current.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+		}
+		VK_CHECK_RESULT(vkEndCommandBuffer(current.transferCommandBuffer));
+		if (ownershipTransfer) {
+			VK_CHECK_RESULT(vkEndCommandBuffer(current.graphicsCommandBuffer));
+			// Copies run on the transfer queue, the graphics queue waits for them before acquiring ownership
+			VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &current.transferCommandBuffer;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &current.ownershipSemaphore;
+			VK_CHECK_RESULT(vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE));
+			const VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &current.ownershipSemaphore;
+			submitInfo.pWaitDstStageMask = &waitStageMask;
+			submitInfo.pCommandBuffers = &current.graphicsCommandBuffer;
+			submitInfo.signalSemaphoreCount = 0;
+			submitInfo.pSignalSemaphores = nullptr;
+			VK_CHECK_RESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, current.fence));
+		} else {
+			VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &current.transferCommandBuffer;
+			VK_CHECK_RESULT(vkQueueSubmit(transferQueue, 1, &submitInfo, current.fence));
+		}
+		current.token = nextToken++;
+		current.stagingEnd = stagingHead;
+		inFlight.push_back(std::move(current));
+		current = {};
+		recording = false;
+		submitCount++;
+		return nextToken - 1;
+	}
+
+	void UploadManager::retireBatch()
+	{
+		Batch batch = std::move(inFlight.front());
+		inFlight.pop_front();
+		VK_CHECK_RESULT(vkResetFences(device->logicalDevice, 1, &batch.fence));
+		VK_CHECK_RESULT(vkResetCommandBuffer(batch.transferCommandBuffer, 0));
+		if (batch.graphicsCommandBuffer != VK_NULL_HANDLE) {
+			VK_CHECK_RESULT(vkResetCommandBuffer(batch.graphicsCommandBuffer, 0));
+		}
+		for (auto& [buffer, allocation] : batch.dedicatedStaging) {
+			vkDestroyBuffer(device->logicalDevice, buffer, nullptr);
+			device->freeMemory(allocation);
+		}
+		batch.dedicatedStaging.clear();
+		batch.bufferUploads = false;
+		stagingTail = batch.stagingEnd;
+		completedToken = batch.token;
+		freeBatches.push_back(std::move(batch));
+		// The whole ring is free again once nothing references it anymore
+		if (inFlight.empty() && !recording) {
+			stagingHead = stagingTail = 0;
+		}
+	}
+
+	/** @brief Retire all batches that have finished executing, returns true if at least one batch was retired */
+	bool UploadManager::pollBatches()
+	{
+		bool retired = false;
+		while (!inFlight.empty() && (vkGetFenceStatus(device->logicalDevice, inFlight.front().fence) == VK_SUCCESS)) {
+			retireBatch();
+			retired = true;
+		}
+		return retired;
+	}
+
+	bool UploadManager::allocateStaging(VkDeviceSize size, VkDeviceSize& offset)
+	{
+		const VkDeviceSize alignedHead = vks::tools::alignedVkSize(stagingHead, stagingAlignment);
+		if (stagingHead >= stagingTail) {
+			// Used range is [tail, head), try to append at the end of the ring first and wrap around if that doesn't fit
+			if (alignedHead + size <= stagingBufferSize) {
+				offset = alignedHead;
+				stagingHead = alignedHead + size;
+				return true;
+			}
+			if (size < stagingTail) {
+				offset = 0;
+				stagingHead = size;
+				return true;
+			}
+			return false;
+		}
+		// Wrapped, used ranges are [tail, end) and [0, head)
+		if (alignedHead + size < stagingTail) {
+			offset = alignedHead;
+			stagingHead = alignedHead + size;
+			return true;
+		}
+		return false;
+	}
+
+	/** @brief Reserve staging memory and let the writer fill it, the batch that references it is started if necessary */
+	void UploadManager::stage(VkDeviceSize size, const StagingWriter& writer, VkBuffer& buffer, VkDeviceSize& offset)
+	{
+		if (stagingBuffer == VK_NULL_HANDLE) {
+			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBufferSize, &stagingBuffer, &stagingAllocation));
+		}
+		if (size <= stagingBufferSize) {
+			pollBatches();
+			bool allocated = allocateStaging(size, offset);
+			while (!allocated && (recording || !inFlight.empty())) {
+				// Ring is full, submit what has been recorded so far and wait for the oldest batch to free up space
+				if (recording) {
+					submitBatch();
+				}
+				VK_CHECK_RESULT(vkWaitForFences(device->logicalDevice, 1, &inFlight.front().fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+				retireBatch();
+				allocated = allocateStaging(size, offset);
+			}
+			if (allocated) {
+				beginBatch();
+				buffer = stagingBuffer;
+				writer(static_cast<uint8_t*>(stagingAllocation.mapped) + offset);
+				return;
+			}
+		}
+		// Upload doesn't fit into the ring at all, use a dedicated staging buffer that's released along with the batch
+		beginBatch();
+		std::pair<VkBuffer, MemoryAllocation> dedicated{};
+		VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, size, &dedicated.first, &dedicated.second));
+		writer(dedicated.second.mapped);
+		current.dedicatedStaging.push_back(dedicated);
+		buffer = dedicated.first;
+		offset = 0;
+	}
+
+	/**
+	* Queue a copy of host data into a buffer
+	*
+	* @param buffer Destination buffer (needs VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+	* @param data Pointer to the data to upload, copied into staging memory before the function returns
+	* @param size Size of the data in bytes
+	* @param dstOffset (Optional) Offset into the destination buffer
+	*
+	* @note The copy is executed with the next flush
+	*/
+	void UploadManager::uploadBuffer(VkBuffer buffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		VkBuffer srcBuffer;
+		VkDeviceSize srcOffset;
+		stage(size, [data, size](void* staging) { memcpy(staging, data, size); }, srcBuffer, srcOffset);
+		VkBufferCopy copyRegion{ .srcOffset = srcOffset, .dstOffset = dstOffset, .size = size };
+		vkCmdCopyBuffer(current.transferCommandBuffer, srcBuffer, buffer, 1, &copyRegion);
+		if (ownershipTransfer) {
+			// Release on the transfer queue and acquire on the graphics queue, the buffer must be created with exclusive sharing mode
+			VkBufferMemoryBarrier bufferMemoryBarrier{
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = 0,
+				.srcQueueFamilyIndex = transferQueueFamilyIndex,
+				.dstQueueFamilyIndex = graphicsQueueFamilyIndex,
+				.buffer = buffer,
+				.offset = dstOffset,
+				.size = size
+			};
+			vkCmdPipelineBarrier(current.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+			bufferMemoryBarrier.srcAccessMask = 0;
+			bufferMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			vkCmdPipelineBarrier(current.graphicsCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+		}
+		current.bufferUploads = true;
+	}
+
+	/**
+	* Queue a copy of host data into an image
+	*
+	* @param image Destination image (needs VK_IMAGE_USAGE_TRANSFER_DST_BIT), the contents of subresourceRange are discarded
+	* @param data Pointer to the data to upload, copied into staging memory before the function returns
+	* @param size Size of the data in bytes
+	* @param regions Copy regions with buffer offsets relative to data
+	* @param subresourceRange Subresources of the image that are uploaded
+	* @param finalLayout Layout the subresources are transitioned to after the copy
+	* @param graphicsCommands (Optional) Commands that need a graphics queue (e.g. mip map generation by blitting) recorded once the image is owned by the graphics queue
+	*
+	* @note The copy is executed with the next flush
+	*/
+	void UploadManager::uploadImage(VkImage image, const void* data, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, std::function<void(VkCommandBuffer)> graphicsCommands)
+	{
+		uploadImage(image, size, [data, size](void* staging) { memcpy(staging, data, size); }, regions, subresourceRange, finalLayout, graphicsCommands);
+	}
+
+	/**
+	* Queue a copy into an image with data that's written straight into staging memory, e.g. read from a file, without an intermediate copy on the heap
+	*
+	* @param image Destination image (needs VK_IMAGE_USAGE_TRANSFER_DST_BIT), the contents of subresourceRange are discarded
+	* @param size Size of the data in bytes
+	* @param writer Called once before the function returns with a pointer to size bytes of mapped staging memory it has to fill, must not call into the upload manager
+	* @param regions Copy regions with buffer offsets relative to the start of the written data
+	* @param subresourceRange Subresources of the image that are uploaded
+	* @param finalLayout Layout the subresources are transitioned to after the copy
+	* @param graphicsCommands (Optional) Commands that need a graphics queue (e.g. mip map generation by blitting) recorded once the image is owned by the graphics queue
+	*
+	* @note The copy is executed with the next flush
+	*/
+	void UploadManager::uploadImage(VkImage image, VkDeviceSize size, const StagingWriter& writer, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, std::function<void(VkCommandBuffer)> graphicsCommands)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		VkBuffer srcBuffer;
+		VkDeviceSize srcOffset;
+		stage(size, writer, srcBuffer, srcOffset);
+		VkImageMemoryBarrier imageMemoryBarrier{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = 0,
+			.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = image,
+			.subresourceRange = subresourceRange
+		};
+		vkCmdPipelineBarrier(current.transferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+		std::vector<VkBufferImageCopy> copyRegions(regions);
+		for (auto& copyRegion : copyRegions) {
+			copyRegion.bufferOffset += srcOffset;
+		}
+		vkCmdCopyBufferToImage(current.transferCommandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+		imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		imageMemoryBarrier.newLayout = finalLayout;
+		if (ownershipTransfer) {
+			// The layout transition is part of the release/acquire pair and has to be specified identically on both queues
+			imageMemoryBarrier.dstAccessMask = 0;
+			imageMemoryBarrier.srcQueueFamilyIndex = transferQueueFamilyIndex;
+			imageMemoryBarrier.dstQueueFamilyIndex = graphicsQueueFamilyIndex;
+			vkCmdPipelineBarrier(current.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+			imageMemoryBarrier.srcAccessMask = 0;
+			imageMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			vkCmdPipelineBarrier(current.graphicsCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+		} else {
+			imageMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			vkCmdPipelineBarrier(current.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+		}
+		if (graphicsCommands) {
+			graphicsCommands(ownershipTransfer ? current.graphicsCommandBuffer : current.transferCommandBuffer);
+		}
+	}
+
+	/**
+	* Submit all uploads queued since the last flush
+	*
+	* @return Token that can be passed to isComplete and wait, uploads are visible to commands submitted to the graphics queue after this call without waiting on the host
+	*/
+	UploadManager::Token UploadManager::flush()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return submitBatch();
+	}
+
+	/** @brief Returns true if the batch with the given token has finished executing, doesn't block */
+	bool UploadManager::isComplete(Token token)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pollBatches();
+		return token <= completedToken;
+	}
+
+	/** @brief Block until the batch with the given token has finished executing */
+	void UploadManager::wait(Token token)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		while ((completedToken < token) && !inFlight.empty()) {
+			VK_CHECK_RESULT(vkWaitForFences(device->logicalDevice, 1, &inFlight.front().fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+			retireBatch();
+		}
+	}
+
+	/** @brief Submit pending uploads and wait for all of them to finish */
+	void UploadManager::waitIdle()
+	{
+		wait(flush());
+	}
+}
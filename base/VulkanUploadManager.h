@@ -0,0 +1,94 @@
+/*
+* Vulkan upload manager
+*
+* Batches buffer and image uploads through a persistently mapped staging ring into few submits on the transfer queue
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanMemoryAllocator.h"
+
+namespace vks
+{
+	struct VulkanDevice;
+
+	/**
+	* @brief Records staging copies into batches that are submitted to the device's transfer queue
+	* @note If the transfer queue belongs to a different queue family than the graphics queue, uploaded resources are released by the transfer queue and acquired by the graphics queue
+	*/
+	class UploadManager
+	{
+	public:
+		/** @brief Completion token of a submitted batch, batches complete in submission order */
+		typedef uint64_t Token;
+		/** @brief Writes the data of an upload directly into the mapped staging memory it's passed */
+		typedef std::function<void(void*)> StagingWriter;
+	private:
+		struct Batch
+		{
+			Token token{ 0 };
+			VkCommandBuffer transferCommandBuffer{ VK_NULL_HANDLE };
+			/** @brief Queue family ownership acquire (and graphics only commands), only used if the transfer queue is from a different family */
+			VkCommandBuffer graphicsCommandBuffer{ VK_NULL_HANDLE };
+			VkSemaphore ownershipSemaphore{ VK_NULL_HANDLE };
+			VkFence fence{ VK_NULL_HANDLE };
+			/** @brief Staging ring position after this batch, the ring space up to here can be reused once the batch has completed */
+			VkDeviceSize stagingEnd{ 0 };
+			bool bufferUploads{ false };
+			/** @brief Staging buffers for uploads that didn't fit into the ring */
+			std::vector<std::pair<VkBuffer, MemoryAllocation>> dedicatedStaging;
+		};
+		VulkanDevice* device{ nullptr };
+		VkQueue transferQueue{ VK_NULL_HANDLE };
+		VkQueue graphicsQueue{ VK_NULL_HANDLE };
+		uint32_t transferQueueFamilyIndex{ 0 };
+		uint32_t graphicsQueueFamilyIndex{ 0 };
+		bool ownershipTransfer{ false };
+		VkCommandPool transferCommandPool{ VK_NULL_HANDLE };
+		VkCommandPool graphicsCommandPool{ VK_NULL_HANDLE };
+		VkBuffer stagingBuffer{ VK_NULL_HANDLE };
+		MemoryAllocation stagingAllocation{};
+		VkDeviceSize stagingHead{ 0 };
+		VkDeviceSize stagingTail{ 0 };
+		VkDeviceSize stagingAlignment{ 16 };
+		Batch current{};
+		bool recording{ false };
+		std::deque<Batch> inFlight;
+		std::vector<Batch> freeBatches;
+		Token nextToken{ 1 };
+		Token completedToken{ 0 };
+		std::mutex mutex;
+		void beginBatch();
+		Token submitBatch();
+		void retireBatch();
+		bool pollBatches();
+		bool allocateStaging(VkDeviceSize size, VkDeviceSize& offset);
+		void stage(VkDeviceSize size, const StagingWriter& writer, VkBuffer& buffer, VkDeviceSize& offset);
+	public:
+		/** @brief Size of the persistently mapped staging ring, uploads larger than this get a dedicated staging buffer */
+		VkDeviceSize stagingBufferSize{ 32 * 1024 * 1024 };
+		/** @brief Number of batches submitted so far */
+		uint32_t submitCount{ 0 };
+
+		void create(VulkanDevice* device, VkQueue transferQueue, VkQueue graphicsQueue);
+		void destroy();
+		void uploadBuffer(VkBuffer buffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+		void uploadImage(VkImage image, const void* data, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, std::function<void(VkCommandBuffer)> graphicsCommands = nullptr);
+		void uploadImage(VkImage image, VkDeviceSize size, const StagingWriter& writer, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, std::function<void(VkCommandBuffer)> graphicsCommands = nullptr);
+		Token flush();
+		bool isComplete(Token token);
+		void wait(Token token);
+		void waitIdle();
+	};
+}
@@ -18,14 +18,41 @@
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 
 #include "VulkanglTFModel.h"
+#include "profiler.hpp"
+#include "jobsystem.hpp"
+#include "indexoptimizer.hpp"
+
+#include <span>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+#include <type_traits>
+#include <algorithm>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 VkDescriptorSetLayout vkglTF::descriptorSetLayoutImage = VK_NULL_HANDLE;
 VkDescriptorSetLayout vkglTF::descriptorSetLayoutUbo = VK_NULL_HANDLE;
+VkDescriptorSetLayout vkglTF::descriptorSetLayoutNodes = VK_NULL_HANDLE;
+VkDescriptorSetLayout vkglTF::descriptorSetLayoutBindless = VK_NULL_HANDLE;
+uint32_t vkglTF::maxBindlessTextures = 4096;
+uint32_t vkglTF::nodeBufferCount = 2;
 VkMemoryPropertyFlags vkglTF::memoryPropertyFlags = 0;
 uint32_t vkglTF::descriptorBindingFlags = vkglTF::DescriptorBindingFlags::ImageBaseColor;
+bool vkglTF::modelCacheEnabled = false;
+std::string vkglTF::modelCacheDir = "";
+bool vkglTF::printLoadStatistics = false;
 
 /*
 	We use a custom image loading function with tinyglTF, so we can do custom stuff loading ktx textures
+	If set, userData points to a vector of encoded images the data is stored in instead of decoding it right away, so the images can be decoded in parallel later on (see Model::loadImages)
 */
 bool loadImageDataFunc(tinygltf::Image* image, const int imageIndex, std::string* error, std::string* warning, int req_width, int req_height, const unsigned char* bytes, int size, void* userData)
 {
@@ -36,6 +63,15 @@ bool loadImageDataFunc(tinygltf::Image* image, const int imageIndex, std::string
 		}
 	}
 
+	if (userData) {
+		std::vector<std::vector<unsigned char>>& encodedImages = *static_cast<std::vector<std::vector<unsigned char>>*>(userData);
+		if (encodedImages.size() <= static_cast<size_t>(imageIndex)) {
+			encodedImages.resize(imageIndex + 1);
+		}
+		encodedImages[imageIndex].assign(bytes, bytes + size);
+		return true;
+	}
+
 	return tinygltf::LoadImageData(image, imageIndex, error, warning, req_width, req_height, bytes, size, userData);
 }
 
@@ -63,7 +99,11 @@ void vkglTF::Texture::destroy()
 	{
 		vkDestroyImageView(device->logicalDevice, view, nullptr);
 		vkDestroyImage(device->logicalDevice, image, nullptr);
-		vkFreeMemory(device->logicalDevice, deviceMemory, nullptr);
+		if (allocation.valid()) {
+			device->freeMemory(allocation);
+		} else {
+			vkFreeMemory(device->logicalDevice, deviceMemory, nullptr);
+		}
 		vkDestroySampler(device->logicalDevice, sampler, nullptr);
 	}
 }
@@ -121,30 +161,6 @@ void vkglTF::Texture::fromglTfImage(tinygltf::Image &gltfimage, std::string path
 		assert(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT);
 		assert(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT);
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingMemory;
-
-		VkBufferCreateInfo bufferCreateInfo{
-			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-			.size = bufferSize,
-			.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
-		};
-		VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-		VkMemoryRequirements memReqs{};
-		vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer, &memReqs);
-		VkMemoryAllocateInfo memAllocInfo{
-			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-			.allocationSize = memReqs.size,
-			.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
-		};
-		VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-		VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-		uint8_t* data{nullptr};
-		VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void**)&data));
-		memcpy(data, buffer, bufferSize);
-		vkUnmapMemory(device->logicalDevice, stagingMemory);
-
 		VkImageCreateInfo imageCreateInfo{
 			.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
 			.imageType = VK_IMAGE_TYPE_2D,
@@ -159,26 +175,13 @@ void vkglTF::Texture::fromglTfImage(tinygltf::Image &gltfimage, std::string path
 			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
 		};
 		VK_CHECK_RESULT(vkCreateImage(device->logicalDevice, &imageCreateInfo, nullptr, &image));
+		VkMemoryRequirements memReqs{};
 		vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
-		memAllocInfo.allocationSize = memReqs.size;
-		memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &deviceMemory));
-		VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, deviceMemory, 0));
+		VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &allocation, false));
+		deviceMemory = allocation.memory;
+		VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, deviceMemory, allocation.offset));
 
-		VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
 		VkImageSubresourceRange subresourceRange{ .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .levelCount = 1, .layerCount = 1 };
-		{
-			VkImageMemoryBarrier imageMemoryBarrier{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-				.srcAccessMask = 0,
-				.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-				.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-				.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				.image = image,
-				.subresourceRange = subresourceRange,
-			};
-			vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-		}
 		VkBufferImageCopy bufferCopyRegion{
 			.imageSubresource = {
 				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -192,80 +195,63 @@ void vkglTF::Texture::fromglTfImage(tinygltf::Image &gltfimage, std::string path
 				.depth = 1
 			}
 		};
-		vkCmdCopyBufferToImage(copyCmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
-		{
-			VkImageMemoryBarrier imageMemoryBarrier{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-				.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
-				.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				.image = image,
-				.subresourceRange = subresourceRange,
-			};
-			vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-		}
-		device->flushCommandBuffer(copyCmd, copyQueue, true);
-
-		vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
-		vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
 
 		// Generate the mip chain (glTF uses jpg and png, so we need to create this manually)
-		VkCommandBuffer blitCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-		for (uint32_t i = 1; i < mipLevels; i++) {
-			VkImageBlit imageBlit{};
-			imageBlit.srcSubresource = {
-				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-				.mipLevel = i - 1,
-				.layerCount = 1,
-			};
-			imageBlit.srcOffsets[1] = {
-				.x = int32_t(width >> (i - 1)),
-				.y = int32_t(height >> (i - 1)),
-				.z = 1
-			};
-			imageBlit.dstSubresource = {
-				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-				.mipLevel = i,
-				.layerCount = 1,
-			};
-			imageBlit.dstOffsets[1] = {
-				.x = int32_t(width >> i),
-				.y = int32_t(height >> i),
-				.z = 1
-			};
-
-			VkImageSubresourceRange mipSubRange{ .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = i, .levelCount = 1, .layerCount = 1 };
-			{
-				VkImageMemoryBarrier imageMemoryBarrier{
-					.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-					.srcAccessMask = 0,
-					.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-					.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-					.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					.image = image,
-					.subresourceRange = mipSubRange
+		// Blitting requires a graphics queue, so this is recorded once the upload manager has handed the first mip level over to it
+		imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		auto generateMipmaps = [image = image, width = width, height = height, mipLevels = mipLevels](VkCommandBuffer blitCmd) {
+			for (uint32_t i = 1; i < mipLevels; i++) {
+				VkImageBlit imageBlit{};
+				imageBlit.srcSubresource = {
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.mipLevel = i - 1,
+					.layerCount = 1,
 				};
-				vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-			}
-			vkCmdBlitImage(blitCmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit, VK_FILTER_LINEAR);
-			{
-				VkImageMemoryBarrier imageMemoryBarrier{
-					.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-					.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-					.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
-					.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-					.image = image,
-					.subresourceRange = mipSubRange
+				imageBlit.srcOffsets[1] = {
+					.x = int32_t(width >> (i - 1)),
+					.y = int32_t(height >> (i - 1)),
+					.z = 1
+				};
+				imageBlit.dstSubresource = {
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.mipLevel = i,
+					.layerCount = 1,
+				};
+				imageBlit.dstOffsets[1] = {
+					.x = int32_t(width >> i),
+					.y = int32_t(height >> i),
+					.z = 1
 				};
-				vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+
+				VkImageSubresourceRange mipSubRange{ .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = i, .levelCount = 1, .layerCount = 1 };
+				{
+					VkImageMemoryBarrier imageMemoryBarrier{
+						.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+						.srcAccessMask = 0,
+						.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+						.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+						.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						.image = image,
+						.subresourceRange = mipSubRange
+					};
+					vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+				}
+				vkCmdBlitImage(blitCmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit, VK_FILTER_LINEAR);
+				{
+					VkImageMemoryBarrier imageMemoryBarrier{
+						.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+						.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+						.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+						.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						.image = image,
+						.subresourceRange = mipSubRange
+					};
+					vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+				}
 			}
-		}
 
-		subresourceRange.levelCount = mipLevels;
-		imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		{
+			VkImageSubresourceRange subresourceRange{ .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .levelCount = mipLevels, .layerCount = 1 };
 			VkImageMemoryBarrier imageMemoryBarrier{
 				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
 				.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
@@ -276,12 +262,14 @@ void vkglTF::Texture::fromglTfImage(tinygltf::Image &gltfimage, std::string path
 				.subresourceRange = subresourceRange
 			};
 			vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-		}
-        if (deleteBuffer) {
-            delete[] buffer;
-        }
+		};
 
-		device->flushCommandBuffer(blitCmd, copyQueue, true);
+		// The first mip level ends up as the source for the blits, the upload is submitted along with the rest of the model
+		device->uploadManager.uploadImage(image, buffer, bufferSize, { bufferCopyRegion }, subresourceRange, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, generateMipmaps);
+
+		if (deleteBuffer) {
+			delete[] buffer;
+		}
 	}
 	else {
 		// Texture is stored in an external ktx file
@@ -323,33 +311,6 @@ void vkglTF::Texture::fromglTfImage(tinygltf::Image &gltfimage, std::string path
 		VkFormatProperties formatProperties;
 		vkGetPhysicalDeviceFormatProperties(device->physicalDevice, format, &formatProperties);
 
-		VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingMemory;
-
-		VkBufferCreateInfo bufferCreateInfo{
-			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-			.size = ktxTextureSize,
-			.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			.sharingMode = VK_SHARING_MODE_EXCLUSIVE
-		};
-		VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-
-		VkMemoryRequirements memReqs;
-		vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer, &memReqs);
-		VkMemoryAllocateInfo memAllocInfo{
-			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-			.allocationSize = memReqs.size,
-			.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
-		};
-		VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-		VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-		uint8_t* data{ nullptr };
-		VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void**)&data));
-		memcpy(data, ktxTextureData, ktxTextureSize);
-		vkUnmapMemory(device->logicalDevice, stagingMemory);
-
 		std::vector<VkBufferImageCopy> bufferCopyRegions;
 		for (uint32_t i = 0; i < mipLevels; i++)
 		{
@@ -389,22 +350,17 @@ void vkglTF::Texture::fromglTfImage(tinygltf::Image &gltfimage, std::string path
 		};
 		VK_CHECK_RESULT(vkCreateImage(device->logicalDevice, &imageCreateInfo, nullptr, &image));
 
+		VkMemoryRequirements memReqs;
 		vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
-		memAllocInfo.allocationSize = memReqs.size;
-		memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &deviceMemory));
-		VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, deviceMemory, 0));
+		VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &allocation, false));
+		deviceMemory = allocation.memory;
+		VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, deviceMemory, allocation.offset));
 
 		VkImageSubresourceRange subresourceRange{ .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = 0, .levelCount = mipLevels, .layerCount = 1 };
-		vks::tools::setImageLayout(copyCmd, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
-		vkCmdCopyBufferToImage(copyCmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(bufferCopyRegions.size()), bufferCopyRegions.data());
-		vks::tools::setImageLayout(copyCmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
-		device->flushCommandBuffer(copyCmd, copyQueue);
+		// All mip levels are stored in the file, so this is a plain copy that is submitted along with the rest of the model
+		device->uploadManager.uploadImage(image, ktxTextureData, ktxTextureSize, bufferCopyRegions, subresourceRange, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 		this->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-		vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
-		vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
-
 		ktxTexture_Destroy(ktxTexture);
 	}
 
@@ -497,20 +453,25 @@ void vkglTF::Primitive::setDimensions(glm::vec3 min, glm::vec3 max) {
 vkglTF::Mesh::Mesh(vks::VulkanDevice *device, glm::mat4 matrix) {
 	this->device = device;
 	this->uniformBlock.matrix = matrix;
+};
+
+void vkglTF::Mesh::createUniformBuffer() {
 	VK_CHECK_RESULT(device->createBuffer(
 		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 		sizeof(uniformBlock),
 		&uniformBuffer.buffer,
-		&uniformBuffer.memory,
+		&uniformBuffer.allocation,
 		&uniformBlock));
-	VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, uniformBuffer.memory, 0, sizeof(uniformBlock), 0, &uniformBuffer.mapped));
+	uniformBuffer.mapped = uniformBuffer.allocation.mapped;
 	uniformBuffer.descriptor = { uniformBuffer.buffer, 0, sizeof(uniformBlock) };
-};
+}
 
 vkglTF::Mesh::~Mesh() {
-	vkDestroyBuffer(device->logicalDevice, uniformBuffer.buffer, nullptr);
-	vkFreeMemory(device->logicalDevice, uniformBuffer.memory, nullptr);
+	if (uniformBuffer.buffer != VK_NULL_HANDLE) {
+		vkDestroyBuffer(device->logicalDevice, uniformBuffer.buffer, nullptr);
+		device->freeMemory(uniformBuffer.allocation);
+	}
     for(auto primitive : primitives)
     {
         delete primitive;
@@ -541,15 +502,18 @@ void vkglTF::Node::update() {
 			mesh->uniformBlock.matrix = m;
 			// Update join matrices
 			glm::mat4 inverseTransform = glm::inverse(m);
-			for (size_t i = 0; i < skin->joints.size(); i++) {
+			const size_t jointCount = std::min(skin->joints.size(), static_cast<size_t>(Mesh::maxUniformJoints));
+			for (size_t i = 0; i < jointCount; i++) {
 				vkglTF::Node *jointNode = skin->joints[i];
 				glm::mat4 jointMat = jointNode->getMatrix() * skin->inverseBindMatrices[i];
 				jointMat = inverseTransform * jointMat;
 				mesh->uniformBlock.jointMatrix[i] = jointMat;
 			}
-			mesh->uniformBlock.jointcount = (float)skin->joints.size();
-			memcpy(mesh->uniformBuffer.mapped, &mesh->uniformBlock, sizeof(mesh->uniformBlock));
-		} else {
+			mesh->uniformBlock.jointcount = (float)jointCount;
+			if (mesh->uniformBuffer.mapped) {
+				memcpy(mesh->uniformBuffer.mapped, &mesh->uniformBlock, sizeof(mesh->uniformBlock));
+			}
+		} else if (mesh->uniformBuffer.mapped) {
 			memcpy(mesh->uniformBuffer.mapped, &m, sizeof(glm::mat4));
 		}
 	}
@@ -644,31 +608,6 @@ void vkglTF::Model::createEmptyTexture(VkQueue transferQueue)
 	unsigned char* buffer = new unsigned char[bufferSize];
 	memset(buffer, 0, bufferSize);
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingMemory;
-	VkBufferCreateInfo bufferCreateInfo{
-		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-		.size = bufferSize,
-		.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	};
-	VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-
-	VkMemoryRequirements memReqs;
-	vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer, &memReqs);
-	VkMemoryAllocateInfo memAllocInfo{
-		.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-		.allocationSize = memReqs.size,
-		.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
-	};
-	VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-	VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-	// Copy texture data into staging buffer
-	uint8_t* data{ nullptr };
-	VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void**)&data));
-	memcpy(data, buffer, bufferSize);
-	vkUnmapMemory(device->logicalDevice, stagingMemory);
-
 	// Create optimal tiled target image
 	VkImageCreateInfo imageCreateInfo{
 		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
@@ -685,27 +624,20 @@ void vkglTF::Model::createEmptyTexture(VkQueue transferQueue)
 	};
 	VK_CHECK_RESULT(vkCreateImage(device->logicalDevice, &imageCreateInfo, nullptr, &emptyTexture.image));
 
+	VkMemoryRequirements memReqs;
 	vkGetImageMemoryRequirements(device->logicalDevice, emptyTexture.image, &memReqs);
-	memAllocInfo.allocationSize = memReqs.size;
-	memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &emptyTexture.deviceMemory));
-	VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, emptyTexture.image, emptyTexture.deviceMemory, 0));
+	VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &emptyTexture.allocation, false));
+	emptyTexture.deviceMemory = emptyTexture.allocation.memory;
+	VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, emptyTexture.image, emptyTexture.deviceMemory, emptyTexture.allocation.offset));
 
 	VkBufferImageCopy bufferCopyRegion{
 		.imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .layerCount = 1 },
 		.imageExtent = {.width = emptyTexture.width, .height = emptyTexture.height, .depth = 1 }
 	};
 	VkImageSubresourceRange subresourceRange{ .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = 0, .levelCount = 1, .layerCount = 1 };
-	VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-	vks::tools::setImageLayout(copyCmd, emptyTexture.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
-	vkCmdCopyBufferToImage(copyCmd, stagingBuffer, emptyTexture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
-	vks::tools::setImageLayout(copyCmd, emptyTexture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
-	device->flushCommandBuffer(copyCmd, transferQueue);
+	device->uploadManager.uploadImage(emptyTexture.image, buffer, bufferSize, { bufferCopyRegion }, subresourceRange, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	emptyTexture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-	// Clean up staging resources
-	vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
-	vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
+	delete[] buffer;
 
 	VkSamplerCreateInfo samplerCreateInfo{
 		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
@@ -740,9 +672,15 @@ void vkglTF::Model::createEmptyTexture(VkQueue transferQueue)
 vkglTF::Model::~Model()
 {
 	vkDestroyBuffer(device->logicalDevice, vertices.buffer, nullptr);
-	vkFreeMemory(device->logicalDevice, vertices.memory, nullptr);
+	device->freeMemory(vertices.allocation);
+	for (NodeBuffer& nodeBuffer : nodeBuffers) {
+		vkDestroyBuffer(device->logicalDevice, nodeBuffer.buffer, nullptr);
+		device->freeMemory(nodeBuffer.allocation);
+	}
+	vkDestroyBuffer(device->logicalDevice, bindlessMaterials.buffer, nullptr);
+	device->freeMemory(bindlessMaterials.allocation);
 	vkDestroyBuffer(device->logicalDevice, indices.buffer, nullptr);
-	vkFreeMemory(device->logicalDevice, indices.memory, nullptr);
+	device->freeMemory(indices.allocation);
 	for (auto& texture : textures) {
 		texture.destroy();
 	}
@@ -756,6 +694,14 @@ vkglTF::Model::~Model()
 		vkDestroyDescriptorSetLayout(device->logicalDevice, descriptorSetLayoutUbo, nullptr);
 		descriptorSetLayoutUbo = VK_NULL_HANDLE;
 	}
+	if (descriptorSetLayoutNodes != VK_NULL_HANDLE) {
+		vkDestroyDescriptorSetLayout(device->logicalDevice, descriptorSetLayoutNodes, nullptr);
+		descriptorSetLayoutNodes = VK_NULL_HANDLE;
+	}
+	if (descriptorSetLayoutBindless != VK_NULL_HANDLE) {
+		vkDestroyDescriptorSetLayout(device->logicalDevice, descriptorSetLayoutBindless, nullptr);
+		descriptorSetLayoutBindless = VK_NULL_HANDLE;
+	}
 	if (descriptorSetLayoutImage != VK_NULL_HANDLE) {
 		vkDestroyDescriptorSetLayout(device->logicalDevice, descriptorSetLayoutImage, nullptr);
 		descriptorSetLayoutImage = VK_NULL_HANDLE;
@@ -764,6 +710,15 @@ vkglTF::Model::~Model()
 	emptyTexture.destroy();
 }
 
+const unsigned char* vkglTF::Model::getBufferData(const tinygltf::Model& model, int bufferIndex) const
+{
+	// The binary chunk of a .glb file is the first buffer and has no uri
+	if (binaryChunk && (bufferIndex == 0) && model.buffers[0].uri.empty()) {
+		return binaryChunk;
+	}
+	return model.buffers[bufferIndex].data.data();
+}
+
 void vkglTF::Model::loadNode(vkglTF::Node *parent, const tinygltf::Node &node, uint32_t nodeIndex, const tinygltf::Model &model, std::vector<uint32_t>& indexBuffer, std::vector<Vertex>& vertexBuffer, float globalscale)
 {
 	vkglTF::Node *newNode = new Node{};
@@ -808,7 +763,18 @@ void vkglTF::Model::loadNode(vkglTF::Node *parent, const tinygltf::Node &node, u
 		const tinygltf::Mesh mesh = model.meshes[node.mesh];
 		Mesh *newMesh = new Mesh(device, newNode->matrix);
 		newMesh->name = mesh.name;
-		for (size_t j = 0; j < mesh.primitives.size(); j++) {
+		// Nodes referring to a mesh that has already been loaded share its geometry, only the transform is stored per node
+		const auto sharedMesh = meshGeometry.find(node.mesh);
+		const bool sharesGeometry = (sharedMesh != meshGeometry.end());
+		if (sharesGeometry) {
+			for (const Primitive* primitive : sharedMesh->second->primitives) {
+				newMesh->primitives.push_back(new Primitive(*primitive));
+			}
+		} else {
+			meshGeometry[node.mesh] = newMesh;
+		}
+		const size_t primitiveCount = sharesGeometry ? 0 : mesh.primitives.size();
+		for (size_t j = 0; j < primitiveCount; j++) {
 			const tinygltf::Primitive &primitive = mesh.primitives[j];
 			if (primitive.indices < 0) {
 				continue;
@@ -836,20 +802,20 @@ void vkglTF::Model::loadNode(vkglTF::Node *parent, const tinygltf::Node &node, u
 
 				const tinygltf::Accessor &posAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
 				const tinygltf::BufferView &posView = model.bufferViews[posAccessor.bufferView];
-				bufferPos = reinterpret_cast<const float *>(&(model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
+				bufferPos = reinterpret_cast<const float *>(getBufferData(model, posView.buffer) + posAccessor.byteOffset + posView.byteOffset);
 				posMin = glm::vec3(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
 				posMax = glm::vec3(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
 
 				if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
 					const tinygltf::Accessor &normAccessor = model.accessors[primitive.attributes.find("NORMAL")->second];
 					const tinygltf::BufferView &normView = model.bufferViews[normAccessor.bufferView];
-					bufferNormals = reinterpret_cast<const float *>(&(model.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]));
+					bufferNormals = reinterpret_cast<const float *>(getBufferData(model, normView.buffer) + normAccessor.byteOffset + normView.byteOffset);
 				}
 
 				if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
 					const tinygltf::Accessor &uvAccessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
 					const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
-					bufferTexCoords = reinterpret_cast<const float *>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+					bufferTexCoords = reinterpret_cast<const float *>(getBufferData(model, uvView.buffer) + uvAccessor.byteOffset + uvView.byteOffset);
 				}
 
 				if (primitive.attributes.find("COLOR_0") != primitive.attributes.end())
@@ -858,14 +824,14 @@ void vkglTF::Model::loadNode(vkglTF::Node *parent, const tinygltf::Node &node, u
 					const tinygltf::BufferView& colorView = model.bufferViews[colorAccessor.bufferView];
 					// Color buffer are either of type vec3 or vec4
 					numColorComponents = colorAccessor.type == TINYGLTF_PARAMETER_TYPE_FLOAT_VEC3 ? 3 : 4;
-					bufferColors = reinterpret_cast<const float*>(&(model.buffers[colorView.buffer].data[colorAccessor.byteOffset + colorView.byteOffset]));
+					bufferColors = reinterpret_cast<const float*>(getBufferData(model, colorView.buffer) + colorAccessor.byteOffset + colorView.byteOffset);
 				}
 
 				if (primitive.attributes.find("TANGENT") != primitive.attributes.end())
 				{
 					const tinygltf::Accessor &tangentAccessor = model.accessors[primitive.attributes.find("TANGENT")->second];
 					const tinygltf::BufferView &tangentView = model.bufferViews[tangentAccessor.bufferView];
-					bufferTangents = reinterpret_cast<const float *>(&(model.buffers[tangentView.buffer].data[tangentAccessor.byteOffset + tangentView.byteOffset]));
+					bufferTangents = reinterpret_cast<const float *>(getBufferData(model, tangentView.buffer) + tangentAccessor.byteOffset + tangentView.byteOffset);
 				}
 
 				// Skinning
@@ -873,13 +839,13 @@ void vkglTF::Model::loadNode(vkglTF::Node *parent, const tinygltf::Node &node, u
 				if (primitive.attributes.find("JOINTS_0") != primitive.attributes.end()) {
 					const tinygltf::Accessor &jointAccessor = model.accessors[primitive.attributes.find("JOINTS_0")->second];
 					const tinygltf::BufferView &jointView = model.bufferViews[jointAccessor.bufferView];
-					bufferJoints = reinterpret_cast<const uint16_t *>(&(model.buffers[jointView.buffer].data[jointAccessor.byteOffset + jointView.byteOffset]));
+					bufferJoints = reinterpret_cast<const uint16_t *>(getBufferData(model, jointView.buffer) + jointAccessor.byteOffset + jointView.byteOffset);
 				}
 
 				if (primitive.attributes.find("WEIGHTS_0") != primitive.attributes.end()) {
 					const tinygltf::Accessor &uvAccessor = model.accessors[primitive.attributes.find("WEIGHTS_0")->second];
 					const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
-					bufferWeights = reinterpret_cast<const float *>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+					bufferWeights = reinterpret_cast<const float *>(getBufferData(model, uvView.buffer) + uvAccessor.byteOffset + uvView.byteOffset);
 				}
 
 				hasSkin = (bufferJoints && bufferWeights);
@@ -914,14 +880,14 @@ void vkglTF::Model::loadNode(vkglTF::Node *parent, const tinygltf::Node &node, u
 			{
 				const tinygltf::Accessor &accessor = model.accessors[primitive.indices];
 				const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
-				const tinygltf::Buffer &buffer = model.buffers[bufferView.buffer];
+				const unsigned char* bufferData = getBufferData(model, bufferView.buffer);
 
 				indexCount = static_cast<uint32_t>(accessor.count);
 
 				switch (accessor.componentType) {
 				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
 					uint32_t *buf = new uint32_t[accessor.count];
-					memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint32_t));
+					memcpy(buf, bufferData + accessor.byteOffset + bufferView.byteOffset, accessor.count * sizeof(uint32_t));
 					for (size_t index = 0; index < accessor.count; index++) {
 						indexBuffer.push_back(buf[index] + vertexStart);
 					}
@@ -930,7 +896,7 @@ void vkglTF::Model::loadNode(vkglTF::Node *parent, const tinygltf::Node &node, u
 				}
 				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
 					uint16_t *buf = new uint16_t[accessor.count];
-					memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint16_t));
+					memcpy(buf, bufferData + accessor.byteOffset + bufferView.byteOffset, accessor.count * sizeof(uint16_t));
 					for (size_t index = 0; index < accessor.count; index++) {
 						indexBuffer.push_back(buf[index] + vertexStart);
 					}
@@ -939,7 +905,7 @@ void vkglTF::Model::loadNode(vkglTF::Node *parent, const tinygltf::Node &node, u
 				}
 				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
 					uint8_t *buf = new uint8_t[accessor.count];
-					memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint8_t));
+					memcpy(buf, bufferData + accessor.byteOffset + bufferView.byteOffset, accessor.count * sizeof(uint8_t));
 					for (size_t index = 0; index < accessor.count; index++) {
 						indexBuffer.push_back(buf[index] + vertexStart);
 					}
@@ -990,9 +956,9 @@ void vkglTF::Model::loadSkins(tinygltf::Model &gltfModel)
 		if (source.inverseBindMatrices > -1) {
 			const tinygltf::Accessor &accessor = gltfModel.accessors[source.inverseBindMatrices];
 			const tinygltf::BufferView &bufferView = gltfModel.bufferViews[accessor.bufferView];
-			const tinygltf::Buffer &buffer = gltfModel.buffers[bufferView.buffer];
+			const unsigned char* bufferData = getBufferData(gltfModel, bufferView.buffer);
 			newSkin->inverseBindMatrices.resize(accessor.count);
-			memcpy(newSkin->inverseBindMatrices.data(), &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(glm::mat4));
+			memcpy(newSkin->inverseBindMatrices.data(), bufferData + accessor.byteOffset + bufferView.byteOffset, accessor.count * sizeof(glm::mat4));
 		}
 
 		skins.push_back(newSkin);
@@ -1001,12 +967,52 @@ void vkglTF::Model::loadSkins(tinygltf::Model &gltfModel)
 
 void vkglTF::Model::loadImages(tinygltf::Model &gltfModel, vks::VulkanDevice *device, VkQueue transferQueue)
 {
-	for (tinygltf::Image &image : gltfModel.images) {
+	// Images that have been passed in encoded form (see loadImageDataFunc) are decoded by a job per image on all cores
+	// Textures are created in order on the calling thread as soon as their image has been decoded, which overlaps with decoding the remaining images
+	// Uploads and mip generation of all textures are recorded into the upload manager's current batch and submitted along with the rest of the model
+	const size_t imageCount = gltfModel.images.size();
+	encodedImages.resize(imageCount);
+	std::vector<vks::JobCounter> decoded(imageCount);
+	std::vector<std::string> decodeErrors(imageCount);
+	const size_t encodedCount = std::count_if(encodedImages.begin(), encodedImages.end(), [](const std::vector<unsigned char>& data) { return !data.empty(); });
+	vks::JobSystem jobSystem;
+	if (encodedCount > 1) {
+		jobSystem.create();
+	}
+	for (size_t i = 0; i < imageCount; i++) {
+		if (encodedImages[i].empty()) {
+			continue;
+		}
+		auto decode = [&gltfModel, &encodedImages = encodedImages, &decodeErrors, i]() {
+			std::string warning;
+			if (!tinygltf::LoadImageData(&gltfModel.images[i], static_cast<int>(i), &decodeErrors[i], &warning, 0, 0, encodedImages[i].data(), static_cast<int>(encodedImages[i].size()), nullptr) && decodeErrors[i].empty()) {
+				decodeErrors[i] = "Could not decode image";
+			}
+			std::vector<unsigned char>().swap(encodedImages[i]);
+		};
+		if (jobSystem.workerCount() > 0) {
+			jobSystem.run(decoded[i], decode);
+		} else {
+			decode();
+		}
+	}
+	for (size_t i = 0; i < imageCount; i++) {
+		auto tStart = std::chrono::high_resolution_clock::now();
+		// Executes other decode jobs while waiting
+		jobSystem.wait(decoded[i]);
+		auto tDecoded = std::chrono::high_resolution_clock::now();
+		loadStatistics.imageDecode += std::chrono::duration<double, std::milli>(tDecoded - tStart).count();
+		if (!decodeErrors[i].empty()) {
+			vks::tools::exitFatal("Could not load image \"" + gltfModel.images[i].uri + "\": " + decodeErrors[i], -1);
+			return;
+		}
 		vkglTF::Texture texture;
-		texture.fromglTfImage(image, path, device, transferQueue);
+		texture.fromglTfImage(gltfModel.images[i], path, device, transferQueue);
 		texture.index = static_cast<uint32_t>(textures.size());
 		textures.push_back(texture);
+		loadStatistics.upload += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tDecoded).count();
 	}
+	encodedImages.clear();
 	// Create an empty texture to be used for empty material images
 	createEmptyTexture(transferQueue);
 }
@@ -1088,12 +1094,12 @@ void vkglTF::Model::loadAnimations(tinygltf::Model &gltfModel)
 			{
 				const tinygltf::Accessor &accessor = gltfModel.accessors[samp.input];
 				const tinygltf::BufferView &bufferView = gltfModel.bufferViews[accessor.bufferView];
-				const tinygltf::Buffer &buffer = gltfModel.buffers[bufferView.buffer];
+				const unsigned char* bufferData = getBufferData(gltfModel, bufferView.buffer);
 
 				assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
 
 				float *buf = new float[accessor.count];
-				memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(float));
+				memcpy(buf, bufferData + accessor.byteOffset + bufferView.byteOffset, accessor.count * sizeof(float));
 				for (size_t index = 0; index < accessor.count; index++) {
 					sampler.inputs.push_back(buf[index]);
 				}
@@ -1112,14 +1118,14 @@ void vkglTF::Model::loadAnimations(tinygltf::Model &gltfModel)
 			{
 				const tinygltf::Accessor &accessor = gltfModel.accessors[samp.output];
 				const tinygltf::BufferView &bufferView = gltfModel.bufferViews[accessor.bufferView];
-				const tinygltf::Buffer &buffer = gltfModel.buffers[bufferView.buffer];
+				const unsigned char* bufferData = getBufferData(gltfModel, bufferView.buffer);
 
 				assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
 
 				switch (accessor.type) {
 				case TINYGLTF_TYPE_VEC3: {
 					glm::vec3 *buf = new glm::vec3[accessor.count];
-					memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(glm::vec3));
+					memcpy(buf, bufferData + accessor.byteOffset + bufferView.byteOffset, accessor.count * sizeof(glm::vec3));
 					for (size_t index = 0; index < accessor.count; index++) {
 						sampler.outputsVec4.push_back(glm::vec4(buf[index], 0.0f));
 					}
@@ -1128,7 +1134,7 @@ void vkglTF::Model::loadAnimations(tinygltf::Model &gltfModel)
 				}
 				case TINYGLTF_TYPE_VEC4: {
 					glm::vec4 *buf = new glm::vec4[accessor.count];
-					memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(glm::vec4));
+					memcpy(buf, bufferData + accessor.byteOffset + bufferView.byteOffset, accessor.count * sizeof(glm::vec4));
 					for (size_t index = 0; index < accessor.count; index++) {
 						sampler.outputsVec4.push_back(buf[index]);
 					}
@@ -1175,189 +1181,1143 @@ void vkglTF::Model::loadAnimations(tinygltf::Model &gltfModel)
 	}
 }
 
-void vkglTF::Model::loadFromFile(std::string filename, vks::VulkanDevice *device, VkQueue transferQueue, uint32_t fileLoadingFlags, float scale)
+/*
+	Cooked model cache
+
+	The cache stores the final vertex and index buffers along with the node hierarchy, materials, skins and animations of a loaded model,
+	so later runs can skip glTF parsing and the vertex pre-processing. All sections are flat arrays of plain structs, so the file can be
+	memory mapped and the vertex and index data are copied straight from the mapping into the upload manager's staging memory.
+	A cache is only used if it was written for the same loading flags and scale and all source files (glTF and external buffers) still have the same size and modification time.
+	Images are not part of the cache (apart from images embedded into the glTF file), they're still loaded from their source files.
+*/
+
+namespace
 {
-	tinygltf::Model gltfModel;
-	tinygltf::TinyGLTF gltfContext;
-	if (fileLoadingFlags & FileLoadingFlags::DontLoadImages) {
-		gltfContext.SetImageLoader(loadImageDataFuncEmpty, nullptr);
-	} else {
-		gltfContext.SetImageLoader(loadImageDataFunc, nullptr);
+	const char modelCacheMagic[8] = { 'V', 'K', 'G', 'L', 'T', 'F', 'C', '\0' };
+	// Increase whenever the layout of the cache or any of the cached structures (including vkglTF::Vertex) changes
+	const uint32_t modelCacheVersion = 2;
+	const uint64_t modelCacheAlignment = 16;
+	const int32_t cachedTextureNone = -1;
+	const int32_t cachedTextureEmpty = -2;
+
+	enum CacheSection : uint32_t {
+		Strings, Dependencies, Images, ImageData, Materials, Nodes, Meshes, Primitives, Skins, Joints, InverseBindMatrices,
+		Animations, AnimationSamplers, AnimationChannels, AnimationInputs, AnimationOutputs, Vertices, Indices, SectionCount
+	};
+
+	struct CacheSectionRange {
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct CacheHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize;
+		uint64_t sourceSize;
+		int64_t sourceModifiedTime;
+		uint32_t fileLoadingFlags;
+		float scale;
+		uint32_t vertexSize;
+		uint32_t metallicRoughnessWorkflow;
+		CacheSectionRange sections[CacheSection::SectionCount];
+	};
+
+	struct CacheString {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	// External file the model data depends on (e.g. a .bin buffer)
+	struct CachedDependency {
+		CacheString uri;
+		uint64_t size;
+		int64_t modifiedTime;
+	};
+
+	// Images with an external file are stored by uri, embedded images with their decoded pixels
+	struct CachedImage {
+		CacheString uri;
+		CacheString name;
+		uint32_t width;
+		uint32_t height;
+		uint32_t component;
+		uint32_t bits;
+		uint64_t dataOffset;
+		uint64_t dataSize;
+	};
+
+	struct CachedMaterial {
+		uint32_t alphaMode;
+		float alphaCutoff;
+		float metallicFactor;
+		float roughnessFactor;
+		float baseColorFactor[4];
+		// Base color, metallic roughness, normal, occlusion, emissive
+		int32_t textures[5];
+	};
+
+	// Nodes are stored in the order of Model::linearNodes, children always come before their parent
+	struct CachedNode {
+		int32_t parent;
+		uint32_t index;
+		int32_t skinIndex;
+		int32_t mesh;
+		CacheString name;
+		float translation[3];
+		float scale[3];
+		float rotation[4];
+		float matrix[16];
+	};
+
+	struct CachedMesh {
+		CacheString name;
+		uint32_t firstPrimitive;
+		uint32_t primitiveCount;
+	};
+
+	struct CachedPrimitive {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		uint32_t material;
+		float min[3];
+		float max[3];
+	};
+
+	struct CachedSkin {
+		CacheString name;
+		int32_t skeletonRoot;
+		uint32_t firstJoint;
+		uint32_t jointCount;
+		uint32_t firstInverseBindMatrix;
+		uint32_t inverseBindMatrixCount;
+	};
+
+	struct CachedAnimation {
+		CacheString name;
+		float start;
+		float end;
+		uint32_t firstSampler;
+		uint32_t samplerCount;
+		uint32_t firstChannel;
+		uint32_t channelCount;
+	};
+
+	struct CachedAnimationSampler {
+		uint32_t interpolation;
+		uint32_t firstInput;
+		uint32_t inputCount;
+		uint32_t firstOutput;
+		uint32_t outputCount;
+	};
+
+	struct CachedAnimationChannel {
+		uint32_t path;
+		uint32_t node;
+		uint32_t samplerIndex;
+	};
+
+	uint64_t hashData(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL)
+	{
+		// 64 bit FNV-1a
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+		}
+		return hash;
 	}
-#if defined(__ANDROID__)
-	// On Android all assets are packed with the apk in a compressed form, so we need to open them using the asset manager
-	// We let tinygltf handle this, by passing the asset manager of our app
-	tinygltf::asset_manager = androidApp->activity->assetManager;
+
+	/** @brief Read-only memory mapping of a whole file */
+	class MappedFile {
+	private:
+#if defined(_WIN32)
+		HANDLE file{ INVALID_HANDLE_VALUE };
+		HANDLE mapping{ nullptr };
 #endif
-	size_t pos = filename.find_last_of('/');
-	path = filename.substr(0, pos);
+	public:
+		const uint8_t* data{ nullptr };
+		size_t size{ 0 };
 
-	std::string error, warning;
+		bool open(const std::string& filename)
+		{
+#if defined(_WIN32)
+			file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+			LARGE_INTEGER fileSize{};
+			if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0)) {
+				return false;
+			}
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping) {
+				return false;
+			}
+			data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			size = data ? static_cast<size_t>(fileSize.QuadPart) : 0;
+#else
+			const int fd = ::open(filename.c_str(), O_RDONLY);
+			if (fd < 0) {
+				return false;
+			}
+			struct stat fileStat{};
+			if ((fstat(fd, &fileStat) == 0) && (fileStat.st_size > 0)) {
+				void* mapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (mapped != MAP_FAILED) {
+					data = static_cast<const uint8_t*>(mapped);
+					size = static_cast<size_t>(fileStat.st_size);
+				}
+			}
+			// The mapping stays valid after closing the descriptor
+			::close(fd);
+#endif
+			return data != nullptr;
+		}
 
-	this->device = device;
+		~MappedFile()
+		{
+#if defined(_WIN32)
+			if (data) {
+				UnmapViewOfFile(data);
+			}
+			if (mapping) {
+				CloseHandle(mapping);
+			}
+			if (file != INVALID_HANDLE_VALUE) {
+				CloseHandle(file);
+			}
+#else
+			if (data) {
+				munmap(const_cast<uint8_t*>(data), size);
+			}
+#endif
+		}
+	};
 
-#if defined(__ANDROID__)
-	// On Android all assets are packed with the apk in a compressed form, so we need to open them using the asset manager
-	// We let tinygltf handle this, by passing the asset manager of our app
-	tinygltf::asset_manager = androidApp->activity->assetManager;
+	/** @brief Gets the size and last modification time of a file, used to detect changed source files without reading them */
+	bool getFileStamp(const std::string& filename, uint64_t& size, int64_t& modifiedTime)
+	{
+#if defined(_WIN32)
+		WIN32_FILE_ATTRIBUTE_DATA attributes{};
+		if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &attributes)) {
+			return false;
+		}
+		size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+		modifiedTime = static_cast<int64_t>((static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime);
+#else
+		struct stat fileStat{};
+		if (stat(filename.c_str(), &fileStat) != 0) {
+			return false;
+		}
+		size = static_cast<uint64_t>(fileStat.st_size);
+#if defined(__APPLE__)
+		modifiedTime = static_cast<int64_t>(fileStat.st_mtimespec.tv_sec) * 1000000000 + fileStat.st_mtimespec.tv_nsec;
+#else
+		modifiedTime = static_cast<int64_t>(fileStat.st_mtim.tv_sec) * 1000000000 + fileStat.st_mtim.tv_nsec;
+#endif
 #endif
-	bool fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, filename);
+		return true;
+	}
 
-	std::vector<uint32_t> indexBuffer;
-	std::vector<Vertex> vertexBuffer;
+	/** @brief Collects the cache sections in memory, sections are aligned so they can be accessed in place from a mapped file */
+	struct CacheWriter {
+		std::vector<uint8_t> data;
+		std::vector<char> strings;
+		CacheHeader header{};
 
-	if (fileLoaded) {
-		if (!(fileLoadingFlags & FileLoadingFlags::DontLoadImages)) {
-			loadImages(gltfModel, device, transferQueue);
+		CacheWriter()
+		{
+			data.resize(sizeof(CacheHeader));
 		}
-		loadMaterials(gltfModel);
-		const tinygltf::Scene &scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
-		for (size_t i = 0; i < scene.nodes.size(); i++) {
-			const tinygltf::Node node = gltfModel.nodes[scene.nodes[i]];
-			loadNode(nullptr, node, scene.nodes[i], gltfModel, indexBuffer, vertexBuffer, scale);
+
+		CacheString addString(const std::string& value)
+		{
+			CacheString cacheString{ .offset = static_cast<uint32_t>(strings.size()), .length = static_cast<uint32_t>(value.size()) };
+			strings.insert(strings.end(), value.begin(), value.end());
+			return cacheString;
 		}
-		if (gltfModel.animations.size() > 0) {
-			loadAnimations(gltfModel);
+
+		template<typename T>
+		void addSection(CacheSection section, const T* items, size_t count)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			data.resize((data.size() + modelCacheAlignment - 1) & ~(modelCacheAlignment - 1));
+			header.sections[section] = { .offset = data.size(), .size = count * sizeof(T) };
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(items);
+			data.insert(data.end(), bytes, bytes + count * sizeof(T));
 		}
-		loadSkins(gltfModel);
 
-		for (auto node : linearNodes) {
-			// Assign skins
-			if (node->skinIndex > -1) {
-				node->skin = skins[node->skinIndex];
-			}
-			// Initial pose
-			if (node->mesh) {
-				node->update();
+		template<typename T>
+		void addSection(CacheSection section, const std::vector<T>& items)
+		{
+			addSection(section, items.data(), items.size());
+		}
+	};
+
+	/** @brief Read access to the sections of a mapped cache file, the section ranges must have been validated */
+	struct CacheReader {
+		const uint8_t* data;
+		const CacheHeader* header;
+
+		template<typename T>
+		std::span<const T> section(CacheSection section) const
+		{
+			const CacheSectionRange& range = header->sections[section];
+			return std::span<const T>(reinterpret_cast<const T*>(data + range.offset), range.size / sizeof(T));
+		}
+
+		std::string string(const CacheString& cacheString) const
+		{
+			const std::span<const char> strings = section<char>(CacheSection::Strings);
+			if (static_cast<uint64_t>(cacheString.offset) + cacheString.length > strings.size()) {
+				return "";
 			}
+			return std::string(strings.data() + cacheString.offset, cacheString.length);
 		}
+	};
+
+	double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 	}
-	else {
-		vks::tools::exitFatal("Could not load glTF file \"" + filename + "\": " + error, -1);
-		return;
+
+	/** @brief Returns the start of the BIN chunk of a binary glTF file, or nullptr if there is none */
+	const unsigned char* getBinaryChunk(const uint8_t* data, size_t size)
+	{
+		// 12 byte header, followed by the JSON chunk and the (optional) BIN chunk, each with a length and type
+		uint32_t jsonLength{ 0 };
+		memcpy(&jsonLength, data + 12, sizeof(uint32_t));
+		const uint64_t binHeader = 20ULL + jsonLength;
+		if (binHeader + 8 > size) {
+			return nullptr;
+		}
+		uint32_t binLength{ 0 };
+		uint32_t binType{ 0 };
+		memcpy(&binLength, data + binHeader, sizeof(uint32_t));
+		memcpy(&binType, data + binHeader + 4, sizeof(uint32_t));
+		// 0x004E4942 = "BIN"
+		if ((binType != 0x004E4942) || (binHeader + 8 + binLength > size)) {
+			return nullptr;
+		}
+		return data + binHeader + 8;
 	}
 
-	// Pre-Calculations for requested features
-	if ((fileLoadingFlags & FileLoadingFlags::PreTransformVertices) || (fileLoadingFlags & FileLoadingFlags::PreMultiplyVertexColors) || (fileLoadingFlags & FileLoadingFlags::FlipY)) {
-		const bool preTransform = fileLoadingFlags & FileLoadingFlags::PreTransformVertices;
-		const bool preMultiplyColor = fileLoadingFlags & FileLoadingFlags::PreMultiplyVertexColors;
-		const bool flipY = fileLoadingFlags & FileLoadingFlags::FlipY;
-		for (Node* node : linearNodes) {
-			if (node->mesh) {
-				const glm::mat4 localMatrix = node->getMatrix();
-				for (Primitive* primitive : node->mesh->primitives) {
-					for (uint32_t i = 0; i < primitive->vertexCount; i++) {
-						Vertex& vertex = vertexBuffer[primitive->firstVertex + i];
-						// Pre-transform vertex positions by node-hierarchy
-						if (preTransform) {
-							vertex.pos = glm::vec3(localMatrix * glm::vec4(vertex.pos, 1.0f));
-							vertex.normal = glm::normalize(glm::mat3(localMatrix) * vertex.normal);
-						}
-						// Flip Y-Axis of vertex positions
-						if (flipY) {
-							vertex.pos.y *= -1.0f;
-							vertex.normal.y *= -1.0f;
-						}
-						// Pre-Multiply vertex colors with material base color
-						if (preMultiplyColor) {
-							vertex.color = primitive->material.baseColorFactor * vertex.color;
-						}
-					}
-				}
-			}
+	std::string getModelCacheFileName(const std::string& filename, uint32_t fileLoadingFlags, float scale)
+	{
+		// The same file may be loaded with different flags, each combination gets its own cache file
+		uint64_t key = hashData(filename.data(), filename.size());
+		key = hashData(&fileLoadingFlags, sizeof(fileLoadingFlags), key);
+		key = hashData(&scale, sizeof(scale), key);
+		std::string name = filename.substr(filename.find_last_of("/\\") + 1);
+		name = name.substr(0, name.find_last_of('.'));
+		std::stringstream fileName;
+		fileName << vkglTF::modelCacheDir;
+		if (!vkglTF::modelCacheDir.empty() && vkglTF::modelCacheDir.back() != '/' && vkglTF::modelCacheDir.back() != '\\') {
+			fileName << "/";
 		}
+		fileName << name << "_" << std::hex << std::setw(16) << std::setfill('0') << key << ".modelcache";
+		return fileName.str();
 	}
+}
 
-	for (auto& extension : gltfModel.extensionsUsed) {
-		if (extension == "KHR_materials_pbrSpecularGlossiness") {
-			std::cout << "Required extension: " << extension;
-			metallicRoughnessWorkflow = false;
+/**
+* Reorder the triangles of every primitive for vertex cache locality (and optionally overdraw) and its vertices for fetch locality
+*
+* @param indexBuffer Indices of all primitives, reordered in place
+* @param vertexBuffer Vertices of all primitives, reordered in place within each primitive's vertex range
+* @param fileLoadingFlags Flags the model is loaded with
+*/
+void vkglTF::Model::optimizeIndices(std::vector<uint32_t>& indexBuffer, std::vector<Vertex>& vertexBuffer, uint32_t fileLoadingFlags)
+{
+	VKS_PROFILE_ZONE("glTF index optimization");
+	vks::VertexCacheStatistics before{};
+	vks::VertexCacheStatistics after{};
+	auto accumulate = [](vks::VertexCacheStatistics& total, const vks::VertexCacheStatistics& statistics) {
+		total.triangleCount += statistics.triangleCount;
+		total.vertexCount += statistics.vertexCount;
+		total.transformedVertices += statistics.transformedVertices;
+	};
+	// Geometry shared by multiple nodes is only optimized once
+	std::unordered_set<uint32_t> optimized;
+	for (Node* node : linearNodes) {
+		if (!node->mesh) {
+			continue;
+		}
+		for (Primitive* primitive : node->mesh->primitives) {
+			if ((primitive->indexCount == 0) || (primitive->vertexCount == 0) || !optimized.insert(primitive->firstIndex).second) {
+				continue;
+			}
+			// The optimizer works on indices relative to the first vertex of the primitive
+			uint32_t* indices = indexBuffer.data() + primitive->firstIndex;
+			for (uint32_t i = 0; i < primitive->indexCount; i++) {
+				indices[i] -= primitive->firstVertex;
+			}
+			accumulate(before, vks::IndexOptimizer::analyzeVertexCache(indices, primitive->indexCount, primitive->vertexCount));
+			std::vector<uint32_t> clusters;
+			vks::IndexOptimizer::optimizeVertexCache(indices, primitive->indexCount, primitive->vertexCount, vks::IndexOptimizer::defaultCacheSize, &clusters);
+			if (fileLoadingFlags & FileLoadingFlags::OptimizeOverdraw) {
+				vks::IndexOptimizer::optimizeOverdraw(indices, primitive->indexCount, &vertexBuffer[primitive->firstVertex].pos.x, sizeof(Vertex), primitive->vertexCount, clusters);
+			}
+			const std::vector<uint32_t> remap = vks::IndexOptimizer::optimizeVertexFetch(indices, primitive->indexCount, primitive->vertexCount);
+			if (!remap.empty()) {
+				vks::IndexOptimizer::remapVertices(vertexBuffer.data() + primitive->firstVertex, remap);
+			}
+			accumulate(after, vks::IndexOptimizer::analyzeVertexCache(indices, primitive->indexCount, primitive->vertexCount));
+			for (uint32_t i = 0; i < primitive->indexCount; i++) {
+				indices[i] += primitive->firstVertex;
+			}
 		}
 	}
+	if (before.triangleCount > 0) {
+		loadStatistics.acmrBefore = static_cast<float>(before.transformedVertices) / before.triangleCount;
+		loadStatistics.atvrBefore = static_cast<float>(before.transformedVertices) / before.vertexCount;
+		loadStatistics.acmrAfter = static_cast<float>(after.transformedVertices) / after.triangleCount;
+		loadStatistics.atvrAfter = static_cast<float>(after.transformedVertices) / after.vertexCount;
+	}
+}
 
-	size_t vertexBufferSize = vertexBuffer.size() * sizeof(Vertex);
-	size_t indexBufferSize = indexBuffer.size() * sizeof(uint32_t);
-	indices.count = static_cast<uint32_t>(indexBuffer.size());
-	vertices.count = static_cast<uint32_t>(vertexBuffer.size());
+void vkglTF::Model::createBuffers(const void* vertexData, uint32_t vertexCount, const void* indexData, uint32_t indexCount)
+{
+	size_t vertexBufferSize = static_cast<size_t>(vertexCount) * sizeof(Vertex);
+	size_t indexBufferSize = indexCount * sizeof(uint32_t);
+	loadStatistics.vertexBufferSize = vertexBufferSize;
+	indices.count = indexCount;
+	vertices.count = vertexCount;
 
 	assert((vertexBufferSize > 0) && (indexBufferSize > 0));
 
-	struct StagingBuffer {
-		VkBuffer buffer;
-		VkDeviceMemory memory;
-	} vertexStaging{}, indexStaging{};
-
-	// Create staging buffers
-	// Vertex data
-	VK_CHECK_RESULT(device->createBuffer(
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		vertexBufferSize,
-		&vertexStaging.buffer,
-		&vertexStaging.memory,
-		vertexBuffer.data()));
-	// Index data
-	VK_CHECK_RESULT(device->createBuffer(
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		indexBufferSize,
-		&indexStaging.buffer,
-		&indexStaging.memory,
-		indexBuffer.data()));
-
-	// Create device local buffers
+	// Create device local buffers, data is uploaded through the device's upload manager
 	// Vertex buffer
 	VK_CHECK_RESULT(device->createBuffer(
 	    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | memoryPropertyFlags,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		vertexBufferSize,
 		&vertices.buffer,
-		&vertices.memory));
+		&vertices.allocation));
 	// Index buffer
 	VK_CHECK_RESULT(device->createBuffer(
 	    VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | memoryPropertyFlags,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		indexBufferSize,
 		&indices.buffer,
-		&indices.memory));
-
-	// Copy from staging buffers
-	VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-	VkBufferCopy copyRegion = {};
+		&indices.allocation));
 
-	copyRegion.size = vertexBufferSize;
-	vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, vertices.buffer, 1, &copyRegion);
+	device->uploadManager.uploadBuffer(vertices.buffer, vertexData, vertexBufferSize);
+	device->uploadManager.uploadBuffer(indices.buffer, indexData, indexBufferSize);
+}
 
-	copyRegion.size = indexBufferSize;
-	vkCmdCopyBuffer(copyCmd, indexStaging.buffer, indices.buffer, 1, &copyRegion);
+/**
+* Write the cooked representation of the just loaded model to a cache file
+*
+* @param cacheFile Name of the cache file
+* @param filename Name of the glTF source file
+* @param fileLoadingFlags Flags the model has been loaded with
+* @param scale Scale the model has been loaded with
+* @param gltfModel Parsed glTF model, used for the source dependencies and images
+* @param vertexBuffer Final (pre-processed) vertices
+* @param indexBuffer Final indices
+*/
+void vkglTF::Model::saveToCache(const std::string& cacheFile, const std::string& filename, uint32_t fileLoadingFlags, float scale, const tinygltf::Model& gltfModel, const std::vector<Vertex>& vertexBuffer, const std::vector<uint32_t>& indexBuffer)
+{
+	VKS_PROFILE_ZONE("glTF cache write");
+	CacheWriter writer;
+	CacheHeader& header = writer.header;
+	memcpy(header.magic, modelCacheMagic, sizeof(modelCacheMagic));
+	header.version = modelCacheVersion;
+	header.headerSize = sizeof(CacheHeader);
+	header.fileLoadingFlags = fileLoadingFlags;
+	header.scale = scale;
+	header.vertexSize = sizeof(Vertex);
+	header.metallicRoughnessWorkflow = metallicRoughnessWorkflow ? 1 : 0;
+	if (!getFileStamp(filename, header.sourceSize, header.sourceModifiedTime)) {
+		return;
+	}
 
-	device->flushCommandBuffer(copyCmd, transferQueue, true);
+	std::vector<CachedDependency> dependencies;
+	for (const tinygltf::Buffer& buffer : gltfModel.buffers) {
+		if (!buffer.uri.empty() && !tinygltf::IsDataURI(buffer.uri)) {
+			CachedDependency dependency{ .uri = writer.addString(buffer.uri) };
+			if (!getFileStamp(path + "/" + buffer.uri, dependency.size, dependency.modifiedTime)) {
+				return;
+			}
+			dependencies.push_back(dependency);
+		}
+	}
 
-	vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
-	vkFreeMemory(device->logicalDevice, vertexStaging.memory, nullptr);
-	vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
-	vkFreeMemory(device->logicalDevice, indexStaging.memory, nullptr);
+	std::vector<CachedImage> images;
+	std::vector<uint8_t> imageData;
+	if (!(fileLoadingFlags & FileLoadingFlags::DontLoadImages)) {
+		for (const tinygltf::Image& image : gltfModel.images) {
+			CachedImage cachedImage{ .name = writer.addString(image.name) };
+			if (!image.uri.empty() && !tinygltf::IsDataURI(image.uri)) {
+				cachedImage.uri = writer.addString(image.uri);
+			} else {
+				cachedImage.width = static_cast<uint32_t>(image.width);
+				cachedImage.height = static_cast<uint32_t>(image.height);
+				cachedImage.component = static_cast<uint32_t>(image.component);
+				cachedImage.bits = static_cast<uint32_t>(image.bits);
+				cachedImage.dataOffset = imageData.size();
+				cachedImage.dataSize = image.image.size();
+				imageData.insert(imageData.end(), image.image.begin(), image.image.end());
+			}
+			images.push_back(cachedImage);
+		}
+	}
 
-	getSceneDimensions();
+	auto textureIndex = [this](const Texture* texture) -> int32_t {
+		if (texture == nullptr) {
+			return cachedTextureNone;
+		}
+		if (texture == &emptyTexture) {
+			return cachedTextureEmpty;
+		}
+		return static_cast<int32_t>(texture - textures.data());
+	};
+	std::vector<CachedMaterial> cachedMaterials;
+	for (const Material& material : materials) {
+		CachedMaterial cachedMaterial{
+			.alphaMode = static_cast<uint32_t>(material.alphaMode),
+			.alphaCutoff = material.alphaCutoff,
+			.metallicFactor = material.metallicFactor,
+			.roughnessFactor = material.roughnessFactor,
+			.textures = {
+				textureIndex(material.baseColorTexture),
+				textureIndex(material.metallicRoughnessTexture),
+				textureIndex(material.normalTexture),
+				textureIndex(material.occlusionTexture),
+				textureIndex(material.emissiveTexture)
+			}
+		};
+		memcpy(cachedMaterial.baseColorFactor, glm::value_ptr(material.baseColorFactor), sizeof(cachedMaterial.baseColorFactor));
+		cachedMaterials.push_back(cachedMaterial);
+	}
 
-	// Setup descriptors
-	uint32_t uboCount{ 0 };
-	uint32_t imageCount{ 0 };
-	for (auto& node : linearNodes) {
+	std::unordered_map<const Node*, uint32_t> nodeIndices;
+	for (size_t i = 0; i < linearNodes.size(); i++) {
+		nodeIndices[linearNodes[i]] = static_cast<uint32_t>(i);
+	}
+	std::vector<CachedNode> cachedNodes;
+	std::vector<CachedMesh> cachedMeshes;
+	std::vector<CachedPrimitive> cachedPrimitives;
+	for (const Node* node : linearNodes) {
+		CachedNode cachedNode{
+			.parent = node->parent ? static_cast<int32_t>(nodeIndices[node->parent]) : -1,
+			.index = node->index,
+			.skinIndex = node->skinIndex,
+			.mesh = -1,
+			.name = writer.addString(node->name),
+			.rotation = { node->rotation.x, node->rotation.y, node->rotation.z, node->rotation.w }
+		};
+		memcpy(cachedNode.translation, glm::value_ptr(node->translation), sizeof(cachedNode.translation));
+		memcpy(cachedNode.scale, glm::value_ptr(node->scale), sizeof(cachedNode.scale));
+		memcpy(cachedNode.matrix, glm::value_ptr(node->matrix), sizeof(cachedNode.matrix));
 		if (node->mesh) {
-			uboCount++;
+			cachedNode.mesh = static_cast<int32_t>(cachedMeshes.size());
+			cachedMeshes.push_back({ .name = writer.addString(node->mesh->name), .firstPrimitive = static_cast<uint32_t>(cachedPrimitives.size()), .primitiveCount = static_cast<uint32_t>(node->mesh->primitives.size()) });
+			for (const Primitive* primitive : node->mesh->primitives) {
+				CachedPrimitive cachedPrimitive{
+					.firstIndex = primitive->firstIndex,
+					.indexCount = primitive->indexCount,
+					.firstVertex = primitive->firstVertex,
+					.vertexCount = primitive->vertexCount,
+					.material = static_cast<uint32_t>(&primitive->material - materials.data()),
+				};
+				memcpy(cachedPrimitive.min, glm::value_ptr(primitive->dimensions.min), sizeof(cachedPrimitive.min));
+				memcpy(cachedPrimitive.max, glm::value_ptr(primitive->dimensions.max), sizeof(cachedPrimitive.max));
+				cachedPrimitives.push_back(cachedPrimitive);
+			}
 		}
+		cachedNodes.push_back(cachedNode);
 	}
-	for (auto& material : materials) {
-		if (material.baseColorTexture != nullptr) {
-			imageCount++;
+
+	std::vector<CachedSkin> cachedSkins;
+	std::vector<uint32_t> joints;
+	std::vector<glm::mat4> inverseBindMatrices;
+	for (const Skin* skin : skins) {
+		cachedSkins.push_back({
+			.name = writer.addString(skin->name),
+			.skeletonRoot = skin->skeletonRoot ? static_cast<int32_t>(nodeIndices[skin->skeletonRoot]) : -1,
+			.firstJoint = static_cast<uint32_t>(joints.size()),
+			.jointCount = static_cast<uint32_t>(skin->joints.size()),
+			.firstInverseBindMatrix = static_cast<uint32_t>(inverseBindMatrices.size()),
+			.inverseBindMatrixCount = static_cast<uint32_t>(skin->inverseBindMatrices.size())
+		});
+		for (const Node* joint : skin->joints) {
+			joints.push_back(nodeIndices[joint]);
 		}
+		inverseBindMatrices.insert(inverseBindMatrices.end(), skin->inverseBindMatrices.begin(), skin->inverseBindMatrices.end());
 	}
-	std::vector<VkDescriptorPoolSize> poolSizes = {
-		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uboCount },
-	};
-	if (imageCount > 0) {
+
+	std::vector<CachedAnimation> cachedAnimations;
+	std::vector<CachedAnimationSampler> cachedSamplers;
+	std::vector<CachedAnimationChannel> cachedChannels;
+	std::vector<float> inputs;
+	std::vector<glm::vec4> outputs;
+	for (const Animation& animation : animations) {
+		cachedAnimations.push_back({
+			.name = writer.addString(animation.name),
+			.start = animation.start,
+			.end = animation.end,
+			.firstSampler = static_cast<uint32_t>(cachedSamplers.size()),
+			.samplerCount = static_cast<uint32_t>(animation.samplers.size()),
+			.firstChannel = static_cast<uint32_t>(cachedChannels.size()),
+			.channelCount = static_cast<uint32_t>(animation.channels.size())
+		});
+		for (const AnimationSampler& sampler : animation.samplers) {
+			cachedSamplers.push_back({
+				.interpolation = static_cast<uint32_t>(sampler.interpolation),
+				.firstInput = static_cast<uint32_t>(inputs.size()),
+				.inputCount = static_cast<uint32_t>(sampler.inputs.size()),
+				.firstOutput = static_cast<uint32_t>(outputs.size()),
+				.outputCount = static_cast<uint32_t>(sampler.outputsVec4.size())
+			});
+			inputs.insert(inputs.end(), sampler.inputs.begin(), sampler.inputs.end());
+			outputs.insert(outputs.end(), sampler.outputsVec4.begin(), sampler.outputsVec4.end());
+		}
+		for (const AnimationChannel& channel : animation.channels) {
+			cachedChannels.push_back({ .path = static_cast<uint32_t>(channel.path), .node = nodeIndices[channel.node], .samplerIndex = channel.samplerIndex });
+		}
+	}
+
+	writer.addSection(CacheSection::Dependencies, dependencies);
+	writer.addSection(CacheSection::Images, images);
+	writer.addSection(CacheSection::ImageData, imageData);
+	writer.addSection(CacheSection::Materials, cachedMaterials);
+	writer.addSection(CacheSection::Nodes, cachedNodes);
+	writer.addSection(CacheSection::Meshes, cachedMeshes);
+	writer.addSection(CacheSection::Primitives, cachedPrimitives);
+	writer.addSection(CacheSection::Skins, cachedSkins);
+	writer.addSection(CacheSection::Joints, joints);
+	writer.addSection(CacheSection::InverseBindMatrices, inverseBindMatrices);
+	writer.addSection(CacheSection::Animations, cachedAnimations);
+	writer.addSection(CacheSection::AnimationSamplers, cachedSamplers);
+	writer.addSection(CacheSection::AnimationChannels, cachedChannels);
+	writer.addSection(CacheSection::AnimationInputs, inputs);
+	writer.addSection(CacheSection::AnimationOutputs, outputs);
+	writer.addSection(CacheSection::Vertices, vertexBuffer);
+	writer.addSection(CacheSection::Indices, indexBuffer);
+	// Strings are added last, as all other sections reference them
+	writer.addSection(CacheSection::Strings, writer.strings);
+	memcpy(writer.data.data(), &header, sizeof(CacheHeader));
+
+	std::ofstream os(cacheFile, std::ios::binary | std::ios::out | std::ios::trunc);
+	if (!os.is_open()) {
+		std::cerr << "Error: Could not write model cache to \"" << cacheFile << "\"\n";
+		return;
+	}
+	os.write(reinterpret_cast<const char*>(writer.data.data()), writer.data.size());
+}
+
+/**
+* Load the model from a cache file written by a previous run
+* @note Nothing is created if the cache can't be used, so loading can fall back to the glTF file
+*
+* @param cacheFile Name of the cache file
+* @param filename Name of the glTF source file the cache must match
+* @param fileLoadingFlags Flags the cache must have been written with
+* @param scale Scale the cache must have been written with
+* @param transferQueue Queue used for the image uploads
+* @param missReason Set to the reason if the cache couldn't be used
+* @return True if the model has been loaded from the cache
+*/
+bool vkglTF::Model::loadFromCache(const std::string& cacheFile, const std::string& filename, uint32_t fileLoadingFlags, float scale, VkQueue transferQueue, std::string& missReason)
+{
+	MappedFile file;
+	if (!file.open(cacheFile)) {
+		missReason = "no cache file";
+		return false;
+	}
+	const CacheHeader* header = reinterpret_cast<const CacheHeader*>(file.data);
+	if ((file.size < sizeof(CacheHeader)) || (memcmp(header->magic, modelCacheMagic, sizeof(modelCacheMagic)) != 0) || (header->version != modelCacheVersion) || (header->headerSize != sizeof(CacheHeader)) || (header->vertexSize != sizeof(Vertex))) {
+		missReason = "invalid header";
+		return false;
+	}
+	for (const CacheSectionRange& range : header->sections) {
+		if ((range.offset % modelCacheAlignment != 0) || (range.offset > file.size) || (range.size > file.size - range.offset)) {
+			missReason = "invalid section";
+			return false;
+		}
+	}
+	if ((header->fileLoadingFlags != fileLoadingFlags) || (header->scale != scale)) {
+		missReason = "loading flags mismatch";
+		return false;
+	}
+	const CacheReader cache{ .data = file.data, .header = header };
+
+	// The cache is only valid as long as none of the source files have been changed
+	uint64_t sourceSize{ 0 };
+	int64_t sourceModifiedTime{ 0 };
+	if (!getFileStamp(filename, sourceSize, sourceModifiedTime) || (sourceSize != header->sourceSize) || (sourceModifiedTime != header->sourceModifiedTime)) {
+		missReason = "source file changed";
+		return false;
+	}
+	for (const CachedDependency& dependency : cache.section<CachedDependency>(CacheSection::Dependencies)) {
+		uint64_t size{ 0 };
+		int64_t modifiedTime{ 0 };
+		if (!getFileStamp(path + "/" + cache.string(dependency.uri), size, modifiedTime) || (size != dependency.size) || (modifiedTime != dependency.modifiedTime)) {
+			missReason = "buffer file changed";
+			return false;
+		}
+	}
+
+	const std::span<const CachedNode> cachedNodes = cache.section<CachedNode>(CacheSection::Nodes);
+	const std::span<const CachedMesh> cachedMeshes = cache.section<CachedMesh>(CacheSection::Meshes);
+	const std::span<const CachedPrimitive> cachedPrimitives = cache.section<CachedPrimitive>(CacheSection::Primitives);
+	const std::span<const CachedMaterial> cachedMaterials = cache.section<CachedMaterial>(CacheSection::Materials);
+	const std::span<const Vertex> cachedVertices = cache.section<Vertex>(CacheSection::Vertices);
+	const std::span<const uint32_t> cachedIndices = cache.section<uint32_t>(CacheSection::Indices);
+	if (cachedMaterials.empty() || cachedVertices.empty() || cachedIndices.empty()) {
+		missReason = "invalid section";
+		return false;
+	}
+
+	// Read the images up front, so nothing needs to be cleaned up if one of them is missing, they're decoded in parallel by loadImages
+	tinygltf::Model imageModel;
+	encodedImages.clear();
+	const std::span<const uint8_t> imageData = cache.section<uint8_t>(CacheSection::ImageData);
+	for (const CachedImage& cachedImage : cache.section<CachedImage>(CacheSection::Images)) {
+		tinygltf::Image image;
+		image.name = cache.string(cachedImage.name);
+		image.uri = cache.string(cachedImage.uri);
+		if (image.uri.empty()) {
+			if (cachedImage.dataOffset + cachedImage.dataSize > imageData.size()) {
+				missReason = "invalid section";
+				encodedImages.clear();
+				return false;
+			}
+			image.width = static_cast<int>(cachedImage.width);
+			image.height = static_cast<int>(cachedImage.height);
+			image.component = static_cast<int>(cachedImage.component);
+			image.bits = static_cast<int>(cachedImage.bits);
+			image.image.assign(imageData.data() + cachedImage.dataOffset, imageData.data() + cachedImage.dataOffset + cachedImage.dataSize);
+		} else if (image.uri.substr(image.uri.find_last_of('.') + 1) != "ktx") {
+			// KTX files are loaded by the texture itself
+			MappedFile imageFile;
+			if (!imageFile.open(path + "/" + image.uri)) {
+				missReason = "could not load image \"" + image.uri + "\"";
+				encodedImages.clear();
+				return false;
+			}
+			encodedImages.resize(imageModel.images.size() + 1);
+			encodedImages.back().assign(imageFile.data, imageFile.data + imageFile.size);
+		}
+		imageModel.images.push_back(image);
+	}
+	if (!(fileLoadingFlags & FileLoadingFlags::DontLoadImages)) {
+		VKS_PROFILE_ZONE("glTF images");
+		loadImages(imageModel, device, transferQueue);
+	}
+
+	auto tSceneStart = std::chrono::high_resolution_clock::now();
+	auto getCachedTexture = [this](int32_t index) -> Texture* {
+		return (index == cachedTextureEmpty) ? &emptyTexture : ((index == cachedTextureNone) ? nullptr : getTexture(static_cast<uint32_t>(index)));
+	};
+	for (const CachedMaterial& cachedMaterial : cachedMaterials) {
+		Material material(device);
+		material.alphaMode = static_cast<Material::AlphaMode>(cachedMaterial.alphaMode);
+		material.alphaCutoff = cachedMaterial.alphaCutoff;
+		material.metallicFactor = cachedMaterial.metallicFactor;
+		material.roughnessFactor = cachedMaterial.roughnessFactor;
+		material.baseColorFactor = glm::make_vec4(cachedMaterial.baseColorFactor);
+		material.baseColorTexture = getCachedTexture(cachedMaterial.textures[0]);
+		material.metallicRoughnessTexture = getCachedTexture(cachedMaterial.textures[1]);
+		material.normalTexture = getCachedTexture(cachedMaterial.textures[2]);
+		material.occlusionTexture = getCachedTexture(cachedMaterial.textures[3]);
+		material.emissiveTexture = getCachedTexture(cachedMaterial.textures[4]);
+		materials.push_back(material);
+	}
+
+	// Nodes are linked after all of them have been created, as children are stored before their parents
+	for (const CachedNode& cachedNode : cachedNodes) {
+		Node* node = new Node{};
+		node->index = cachedNode.index;
+		node->name = cache.string(cachedNode.name);
+		node->skinIndex = cachedNode.skinIndex;
+		node->translation = glm::make_vec3(cachedNode.translation);
+		node->scale = glm::make_vec3(cachedNode.scale);
+		node->rotation = glm::quat(cachedNode.rotation[3], cachedNode.rotation[0], cachedNode.rotation[1], cachedNode.rotation[2]);
+		node->matrix = glm::make_mat4x4(cachedNode.matrix);
+		if ((cachedNode.mesh > -1) && (static_cast<size_t>(cachedNode.mesh) < cachedMeshes.size())) {
+			const CachedMesh& cachedMesh = cachedMeshes[cachedNode.mesh];
+			Mesh* mesh = new Mesh(device, node->matrix);
+			mesh->name = cache.string(cachedMesh.name);
+			for (uint32_t i = 0; (i < cachedMesh.primitiveCount) && (cachedMesh.firstPrimitive + i < cachedPrimitives.size()); i++) {
+				const CachedPrimitive& cachedPrimitive = cachedPrimitives[cachedMesh.firstPrimitive + i];
+				Primitive* primitive = new Primitive(cachedPrimitive.firstIndex, cachedPrimitive.indexCount, materials[std::min(static_cast<size_t>(cachedPrimitive.material), materials.size() - 1)]);
+				primitive->firstVertex = cachedPrimitive.firstVertex;
+				primitive->vertexCount = cachedPrimitive.vertexCount;
+				primitive->setDimensions(glm::make_vec3(cachedPrimitive.min), glm::make_vec3(cachedPrimitive.max));
+				mesh->primitives.push_back(primitive);
+			}
+			node->mesh = mesh;
+		}
+		linearNodes.push_back(node);
+	}
+	for (size_t i = 0; i < cachedNodes.size(); i++) {
+		const int32_t parent = cachedNodes[i].parent;
+		if ((parent > -1) && (static_cast<size_t>(parent) < linearNodes.size())) {
+			linearNodes[i]->parent = linearNodes[parent];
+			linearNodes[parent]->children.push_back(linearNodes[i]);
+		} else {
+			nodes.push_back(linearNodes[i]);
+		}
+	}
+	auto getCachedNode = [this](int64_t index) -> Node* {
+		return ((index > -1) && (static_cast<size_t>(index) < linearNodes.size())) ? linearNodes[index] : nullptr;
+	};
+
+	const std::span<const uint32_t> joints = cache.section<uint32_t>(CacheSection::Joints);
+	const std::span<const glm::mat4> inverseBindMatrices = cache.section<glm::mat4>(CacheSection::InverseBindMatrices);
+	for (const CachedSkin& cachedSkin : cache.section<CachedSkin>(CacheSection::Skins)) {
+		Skin* skin = new Skin{};
+		skin->name = cache.string(cachedSkin.name);
+		skin->skeletonRoot = getCachedNode(cachedSkin.skeletonRoot);
+		for (uint32_t i = 0; (i < cachedSkin.jointCount) && (cachedSkin.firstJoint + i < joints.size()); i++) {
+			Node* joint = getCachedNode(joints[cachedSkin.firstJoint + i]);
+			if (joint) {
+				skin->joints.push_back(joint);
+			}
+		}
+		if (static_cast<size_t>(cachedSkin.firstInverseBindMatrix) + cachedSkin.inverseBindMatrixCount <= inverseBindMatrices.size()) {
+			skin->inverseBindMatrices.assign(inverseBindMatrices.begin() + cachedSkin.firstInverseBindMatrix, inverseBindMatrices.begin() + cachedSkin.firstInverseBindMatrix + cachedSkin.inverseBindMatrixCount);
+		}
+		skins.push_back(skin);
+	}
+
+	const std::span<const CachedAnimationSampler> cachedSamplers = cache.section<CachedAnimationSampler>(CacheSection::AnimationSamplers);
+	const std::span<const CachedAnimationChannel> cachedChannels = cache.section<CachedAnimationChannel>(CacheSection::AnimationChannels);
+	const std::span<const float> inputs = cache.section<float>(CacheSection::AnimationInputs);
+	const std::span<const glm::vec4> outputs = cache.section<glm::vec4>(CacheSection::AnimationOutputs);
+	for (const CachedAnimation& cachedAnimation : cache.section<CachedAnimation>(CacheSection::Animations)) {
+		Animation animation{};
+		animation.name = cache.string(cachedAnimation.name);
+		animation.start = cachedAnimation.start;
+		animation.end = cachedAnimation.end;
+		for (uint32_t i = 0; (i < cachedAnimation.samplerCount) && (cachedAnimation.firstSampler + i < cachedSamplers.size()); i++) {
+			const CachedAnimationSampler& cachedSampler = cachedSamplers[cachedAnimation.firstSampler + i];
+			AnimationSampler sampler{};
+			sampler.interpolation = static_cast<AnimationSampler::InterpolationType>(cachedSampler.interpolation);
+			if ((static_cast<size_t>(cachedSampler.firstInput) + cachedSampler.inputCount <= inputs.size()) && (static_cast<size_t>(cachedSampler.firstOutput) + cachedSampler.outputCount <= outputs.size())) {
+				sampler.inputs.assign(inputs.begin() + cachedSampler.firstInput, inputs.begin() + cachedSampler.firstInput + cachedSampler.inputCount);
+				sampler.outputsVec4.assign(outputs.begin() + cachedSampler.firstOutput, outputs.begin() + cachedSampler.firstOutput + cachedSampler.outputCount);
+			}
+			animation.samplers.push_back(sampler);
+		}
+		for (uint32_t i = 0; (i < cachedAnimation.channelCount) && (cachedAnimation.firstChannel + i < cachedChannels.size()); i++) {
+			const CachedAnimationChannel& cachedChannel = cachedChannels[cachedAnimation.firstChannel + i];
+			AnimationChannel channel{};
+			channel.path = static_cast<AnimationChannel::PathType>(cachedChannel.path);
+			channel.node = getCachedNode(cachedChannel.node);
+			channel.samplerIndex = cachedChannel.samplerIndex;
+			if (channel.node) {
+				animation.channels.push_back(channel);
+			}
+		}
+		animations.push_back(animation);
+	}
+
+	metallicRoughnessWorkflow = (header->metallicRoughnessWorkflow != 0);
+	loadStatistics.scene = millisecondsSince(tSceneStart);
+
+	// Vertex and index data are copied from the mapped file to the staging memory
+	auto tStart = std::chrono::high_resolution_clock::now();
+	createBuffers(cachedVertices.data(), static_cast<uint32_t>(cachedVertices.size()), cachedIndices.data(), static_cast<uint32_t>(cachedIndices.size()));
+	loadStatistics.upload += millisecondsSince(tStart);
+	return true;
+}
+
+void vkglTF::Model::loadFromFile(std::string filename, vks::VulkanDevice *device, VkQueue transferQueue, uint32_t fileLoadingFlags, float scale)
+{
+	VKS_PROFILE_ZONE("glTF load");
+	auto tStart = std::chrono::high_resolution_clock::now();
+	size_t pos = filename.find_last_of('/');
+	path = filename.substr(0, pos);
+
+	this->device = device;
+	loadStatistics = {};
+
+#if defined(__ANDROID__)
+	// Assets are packed into the apk on Android, so there are no source files that could be mapped and checked for changes
+	const bool useCache = false;
+#else
+	const bool useCache = modelCacheEnabled;
+#endif
+	// Binary glTF files are detected by their magic, so they're loaded correctly regardless of the file extension
+	// The file is memory mapped and the binary chunk is read in place, so it doesn't have to be read into memory first
+	MappedFile sourceFile;
+#if defined(__ANDROID__)
+	loadStatistics.binary = (filename.substr(filename.find_last_of('.') + 1) == "glb");
+#else
+	if (sourceFile.open(filename)) {
+		loadStatistics.binary = (sourceFile.size >= 12) && (memcmp(sourceFile.data, "glTF", 4) == 0);
+	}
+#endif
+
+	std::string cacheFile;
+	std::string cacheMissReason;
+	bool cacheHit = false;
+	if (useCache) {
+		VKS_PROFILE_ZONE("glTF cache load");
+		auto tCacheStart = std::chrono::high_resolution_clock::now();
+		cacheFile = getModelCacheFileName(filename, fileLoadingFlags, scale);
+		const bool binary = loadStatistics.binary;
+		cacheHit = loadFromCache(cacheFile, filename, fileLoadingFlags, scale, transferQueue, cacheMissReason);
+		if (cacheHit) {
+			// Everything that isn't image decoding, scene setup or upload is reading and validating the cache
+			loadStatistics.parse = millisecondsSince(tCacheStart) - loadStatistics.imageDecode - loadStatistics.scene - loadStatistics.upload;
+		} else {
+			loadStatistics = { .binary = binary };
+		}
+	}
+
+	if (!cacheHit) {
+		tinygltf::Model gltfModel;
+		tinygltf::TinyGLTF gltfContext;
+		encodedImages.clear();
+		if (fileLoadingFlags & FileLoadingFlags::DontLoadImages) {
+			gltfContext.SetImageLoader(loadImageDataFuncEmpty, nullptr);
+		} else {
+			gltfContext.SetImageLoader(loadImageDataFunc, &encodedImages);
+		}
+#if defined(__ANDROID__)
+		// On Android all assets are packed with the apk in a compressed form, so we need to open them using the asset manager
+		// We let tinygltf handle this, by passing the asset manager of our app
+		tinygltf::asset_manager = androidApp->activity->assetManager;
+#endif
+		std::string error, warning;
+
+		bool fileLoaded = false;
+		{
+			// Includes decoding of the images
+			VKS_PROFILE_ZONE("glTF parse");
+			auto tParseStart = std::chrono::high_resolution_clock::now();
+			if (loadStatistics.binary && sourceFile.data) {
+				fileLoaded = gltfContext.LoadBinaryFromMemory(&gltfModel, &error, &warning, sourceFile.data, static_cast<unsigned int>(sourceFile.size), path);
+				binaryChunk = fileLoaded ? getBinaryChunk(sourceFile.data, sourceFile.size) : nullptr;
+				if (binaryChunk && !gltfModel.buffers.empty() && gltfModel.buffers[0].uri.empty()) {
+					// tinygltf keeps its own copy of the binary chunk, which is no longer needed as images have been decoded at this point and all buffer views are read from the mapped file
+					std::vector<unsigned char>().swap(gltfModel.buffers[0].data);
+				}
+			} else if (loadStatistics.binary) {
+				fileLoaded = gltfContext.LoadBinaryFromFile(&gltfModel, &error, &warning, filename);
+			} else {
+				fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, filename);
+			}
+			loadStatistics.parse = millisecondsSince(tParseStart) - loadStatistics.imageDecode;
+		}
+
+		std::vector<uint32_t> indexBuffer;
+		std::vector<Vertex> vertexBuffer;
+
+		auto tSceneStart = std::chrono::high_resolution_clock::now();
+		if (fileLoaded) {
+			if (!(fileLoadingFlags & FileLoadingFlags::DontLoadImages)) {
+				VKS_PROFILE_ZONE("glTF images");
+				loadImages(gltfModel, device, transferQueue);
+				tSceneStart = std::chrono::high_resolution_clock::now();
+			}
+			VKS_PROFILE_ZONE("glTF scene");
+			loadMaterials(gltfModel);
+			const tinygltf::Scene &scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
+			for (size_t i = 0; i < scene.nodes.size(); i++) {
+				const tinygltf::Node node = gltfModel.nodes[scene.nodes[i]];
+				loadNode(nullptr, node, scene.nodes[i], gltfModel, indexBuffer, vertexBuffer, scale);
+			}
+			meshGeometry.clear();
+			if (gltfModel.animations.size() > 0) {
+				loadAnimations(gltfModel);
+			}
+			loadSkins(gltfModel);
+		}
+		else {
+			vks::tools::exitFatal("Could not load glTF file \"" + filename + "\": " + error, -1);
+			return;
+		}
+
+		// Pre-Calculations for requested features
+		if ((fileLoadingFlags & FileLoadingFlags::PreTransformVertices) || (fileLoadingFlags & FileLoadingFlags::PreMultiplyVertexColors) || (fileLoadingFlags & FileLoadingFlags::FlipY)) {
+			VKS_PROFILE_ZONE("glTF vertex processing");
+			const bool preTransform = fileLoadingFlags & FileLoadingFlags::PreTransformVertices;
+			const bool preMultiplyColor = fileLoadingFlags & FileLoadingFlags::PreMultiplyVertexColors;
+			const bool flipY = fileLoadingFlags & FileLoadingFlags::FlipY;
+			// Pre-transformed vertices depend on the node, so nodes that share geometry get their own copy of it
+			std::unordered_map<uint32_t, uint32_t> geometryUsers;
+			if (preTransform) {
+				for (Node* node : linearNodes) {
+					if (!node->mesh) {
+						continue;
+					}
+					for (Primitive* primitive : node->mesh->primitives) {
+						if (geometryUsers[primitive->firstIndex]++ == 0) {
+							continue;
+						}
+						const uint32_t firstVertex = static_cast<uint32_t>(vertexBuffer.size());
+						const uint32_t firstIndex = static_cast<uint32_t>(indexBuffer.size());
+						vertexBuffer.reserve(vertexBuffer.size() + primitive->vertexCount);
+						for (uint32_t i = 0; i < primitive->vertexCount; i++) {
+							vertexBuffer.push_back(vertexBuffer[primitive->firstVertex + i]);
+						}
+						indexBuffer.reserve(indexBuffer.size() + primitive->indexCount);
+						for (uint32_t i = 0; i < primitive->indexCount; i++) {
+							indexBuffer.push_back(indexBuffer[primitive->firstIndex + i] - primitive->firstVertex + firstVertex);
+						}
+						primitive->firstVertex = firstVertex;
+						primitive->firstIndex = firstIndex;
+					}
+				}
+			}
+			// Shared geometry is only processed once
+			std::unordered_set<uint32_t> processed;
+			for (Node* node : linearNodes) {
+				if (node->mesh) {
+					const glm::mat4 localMatrix = node->getMatrix();
+					for (Primitive* primitive : node->mesh->primitives) {
+						if (!processed.insert(primitive->firstIndex).second) {
+							continue;
+						}
+						for (uint32_t i = 0; i < primitive->vertexCount; i++) {
+							Vertex& vertex = vertexBuffer[primitive->firstVertex + i];
+							// Pre-transform vertex positions by node-hierarchy
+							if (preTransform) {
+								vertex.pos = glm::vec3(localMatrix * glm::vec4(vertex.pos, 1.0f));
+								vertex.normal = glm::normalize(glm::mat3(localMatrix) * vertex.normal);
+							}
+							// Flip Y-Axis of vertex positions
+							if (flipY) {
+								vertex.pos.y *= -1.0f;
+								vertex.normal.y *= -1.0f;
+							}
+							// Pre-Multiply vertex colors with material base color
+							if (preMultiplyColor) {
+								vertex.color = primitive->material.baseColorFactor * vertex.color;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		for (auto& extension : gltfModel.extensionsUsed) {
+			if (extension == "KHR_materials_pbrSpecularGlossiness") {
+				std::cout << "Required extension: " << extension;
+				metallicRoughnessWorkflow = false;
+			}
+		}
+
+		// Optimized before writing the cache, so later runs get the optimized buffers for free
+		if (fileLoadingFlags & FileLoadingFlags::OptimizeIndices) {
+			optimizeIndices(indexBuffer, vertexBuffer, fileLoadingFlags);
+		}
+
+		binaryChunk = nullptr;
+		loadStatistics.scene = millisecondsSince(tSceneStart);
+
+		auto tUploadStart = std::chrono::high_resolution_clock::now();
+		createBuffers(vertexBuffer.data(), static_cast<uint32_t>(vertexBuffer.size()), indexBuffer.data(), static_cast<uint32_t>(indexBuffer.size()));
+		loadStatistics.upload += millisecondsSince(tUploadStart);
+
+		if (useCache) {
+			saveToCache(cacheFile, filename, fileLoadingFlags, scale, gltfModel, vertexBuffer, indexBuffer);
+		}
+	}
+
+	for (auto node : linearNodes) {
+		// Assign skins
+		if ((node->skinIndex > -1) && (static_cast<size_t>(node->skinIndex) < skins.size())) {
+			node->skin = skins[node->skinIndex];
+		}
+	}
+	if (fileLoadingFlags & FileLoadingFlags::NodeUniformBuffers) {
+		for (Node* node : linearNodes) {
+			if (node->mesh) {
+				node->mesh->createUniformBuffer();
+				loadStatistics.nodeUniformBufferCount++;
+			}
+		}
+	}
+	prepareTransforms();
+	prepareDrawBatches();
+	if (fileLoadingFlags & FileLoadingFlags::NodeStorageBuffers) {
+		prepareNodeBuffers();
+	}
+	buildDrawList();
+	if (fileLoadingFlags & FileLoadingFlags::BindlessMaterials) {
+		prepareBindlessMaterials();
+	}
+	// Initial pose
+	updateTransforms();
+	for (uint32_t i = 0; i < static_cast<uint32_t>(nodeBuffers.size()); i++) {
+		updateNodeBuffer(i);
+	}
+
+	// Submit all textures and buffers of the model as one batch
+	{
+		VKS_PROFILE_ZONE("glTF upload");
+		auto tUploadStart = std::chrono::high_resolution_clock::now();
+		device->uploadManager.wait(device->uploadManager.flush());
+		loadStatistics.upload += millisecondsSince(tUploadStart);
+	}
+
+	loadStatistics.cacheHit = cacheHit;
+	loadStatistics.total = millisecondsSince(tStart);
+	if (printLoadStatistics) {
+		std::stringstream summary;
+		summary << std::fixed << std::setprecision(1);
+		summary << "Model \"" << filename << "\" (" << (loadStatistics.binary ? "glb" : "gltf");
+		if (useCache) {
+			summary << ", cache " << (cacheHit ? "hit" : "miss: " + cacheMissReason);
+		}
+		summary << ") loaded in " << loadStatistics.total << " ms (parse " << loadStatistics.parse << " ms, image decode " << loadStatistics.imageDecode << " ms, scene " << loadStatistics.scene << " ms, upload " << loadStatistics.upload << " ms), ";
+		summary << "vertex data " << loadStatistics.vertexBufferSize / 1024.0 << " KiB";
+		if (loadStatistics.drawCount != loadStatistics.nodeDrawCount) {
+			summary << ", shared geometry " << loadStatistics.sharedGeometrySize / 1024.0 << " KiB, " << loadStatistics.drawCount << " instanced draws instead of " << loadStatistics.nodeDrawCount;
+		}
+		if (bindlessMaterials.buffer != VK_NULL_HANDLE) {
+			// All materials are accessed through one descriptor set, material changes only push an index
+			summary << ", bindless materials (" << materials.size() << " materials, " << bindlessMaterials.textureCount << " textures), 1 instead of " << drawListStatistics.descriptorBinds << " material binds for " << drawListStatistics.draws << " draws";
+		} else if (drawListStatistics.descriptorBinds != drawListStatistics.unsortedDescriptorBinds) {
+			summary << ", " << drawListStatistics.descriptorBinds << " material binds for " << drawListStatistics.draws << " draws instead of " << drawListStatistics.unsortedDescriptorBinds;
+		}
+		if (loadStatistics.nodeBufferSize > 0) {
+			// Per-mesh uniform buffers need a descriptor set bind per node draw, the node storage buffer is bound once
+			summary << ", node data " << loadStatistics.nodeBufferSize / 1024.0 << " KiB in " << nodeBuffers.size() << " storage buffers vs. " << loadStatistics.nodeUniformBufferSize / 1024.0 << " KiB in " << instanceNodes.size() << " per-mesh uniform buffers, 1 instead of " << loadStatistics.nodeDrawCount << " descriptor set binds per frame";
+		}
+		if (loadStatistics.acmrBefore > 0.0f) {
+			summary << std::setprecision(3) << ", ACMR " << loadStatistics.acmrBefore << " -> " << loadStatistics.acmrAfter << ", ATVR " << loadStatistics.atvrBefore << " -> " << loadStatistics.atvrAfter;
+		}
+		summary << "\n";
+		std::cout << summary.str();
+	}
+
+	getSceneDimensions();
+
+	// Setup descriptors
+	VKS_PROFILE_ZONE("glTF descriptors");
+	const uint32_t uboCount = loadStatistics.nodeUniformBufferCount;
+	const uint32_t nodeBufferSetCount = static_cast<uint32_t>(nodeBuffers.size());
+	const uint32_t bindlessSetCount = (bindlessMaterials.buffer != VK_NULL_HANDLE) ? 1 : 0;
+	uint32_t imageCount{ 0 };
+	if (bindlessSetCount == 0) {
+		for (auto& material : materials) {
+			if (material.baseColorTexture != nullptr) {
+				imageCount++;
+			}
+		}
+	}
+	std::vector<VkDescriptorPoolSize> poolSizes{};
+	if (uboCount > 0) {
+		poolSizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uboCount });
+	}
+	if (nodeBufferSetCount > 0) {
+		poolSizes.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nodeBufferSetCount * 2 });
+	}
+	if (bindlessSetCount > 0) {
+		poolSizes.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 });
+		poolSizes.push_back({ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, bindlessMaterials.textureCount });
+	}
+	if (imageCount > 0) {
 		if (descriptorBindingFlags & DescriptorBindingFlags::ImageBaseColor) {
 			poolSizes.push_back({ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageCount });
 		}
@@ -1367,7 +2327,7 @@ void vkglTF::Model::loadFromFile(std::string filename, vks::VulkanDevice *device
 	}
 	VkDescriptorPoolCreateInfo descriptorPoolCI{
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-		.maxSets = uboCount + imageCount,
+		.maxSets = std::max(uboCount + nodeBufferSetCount + bindlessSetCount + imageCount, 1u),
 		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
 		.pPoolSizes = poolSizes.data()
 	};
@@ -1381,13 +2341,70 @@ void vkglTF::Model::loadFromFile(std::string filename, vks::VulkanDevice *device
 			VkDescriptorSetLayoutCreateInfo descriptorLayoutCI{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, .bindingCount = 1, .pBindings = &setLayoutBinding };
 			VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device->logicalDevice, &descriptorLayoutCI, nullptr, &descriptorSetLayoutUbo));
 		}
-		for (auto node : nodes) {
-			prepareNodeDescriptor(node, descriptorSetLayoutUbo);
+		if (uboCount > 0) {
+			for (auto node : nodes) {
+				prepareNodeDescriptor(node, descriptorSetLayoutUbo);
+			}
+		}
+	}
+
+	// Descriptors for the node storage buffers
+	if (fileLoadingFlags & FileLoadingFlags::NodeStorageBuffers) {
+		// Layout is global, so only create if it hasn't already been created before
+		if (descriptorSetLayoutNodes == VK_NULL_HANDLE) {
+			const std::array<VkDescriptorSetLayoutBinding, 2> setLayoutBindings = {
+				VkDescriptorSetLayoutBinding{ .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_VERTEX_BIT },
+				VkDescriptorSetLayoutBinding{ .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_VERTEX_BIT },
+			};
+			VkDescriptorSetLayoutCreateInfo descriptorLayoutCI{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, .bindingCount = static_cast<uint32_t>(setLayoutBindings.size()), .pBindings = setLayoutBindings.data() };
+			VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device->logicalDevice, &descriptorLayoutCI, nullptr, &descriptorSetLayoutNodes));
+		}
+		for (NodeBuffer& nodeBuffer : nodeBuffers) {
+			VkDescriptorSetAllocateInfo descriptorSetAllocInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, .descriptorPool = descriptorPool, .descriptorSetCount = 1, .pSetLayouts = &descriptorSetLayoutNodes };
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(device->logicalDevice, &descriptorSetAllocInfo, &nodeBuffer.descriptorSet));
+			const VkDescriptorBufferInfo nodeDataInfo{ nodeBuffer.buffer, 0, nodeData.size() * sizeof(NodeData) };
+			const VkDescriptorBufferInfo jointMatricesInfo{ nodeBuffer.buffer, jointMatricesOffset, VK_WHOLE_SIZE };
+			const std::array<VkWriteDescriptorSet, 2> writeDescriptorSets = {
+				VkWriteDescriptorSet{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstSet = nodeBuffer.descriptorSet, .dstBinding = 0, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &nodeDataInfo },
+				VkWriteDescriptorSet{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstSet = nodeBuffer.descriptorSet, .dstBinding = 1, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &jointMatricesInfo },
+			};
+			vkUpdateDescriptorSets(device->logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+		}
+	}
+
+	// Descriptors for the bindless material table
+	if (bindlessSetCount > 0) {
+		// Layout is global, so only create if it hasn't already been created before
+		if (descriptorSetLayoutBindless == VK_NULL_HANDLE) {
+			const std::array<VkDescriptorSetLayoutBinding, 2> setLayoutBindings = {
+				VkDescriptorSetLayoutBinding{ .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT },
+				VkDescriptorSetLayoutBinding{ .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = maxBindlessTextures, .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT },
+			};
+			// The texture array is the last binding and sized per model at allocation time
+			const std::array<VkDescriptorBindingFlags, 2> bindingFlags = { 0, VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT };
+			VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCI{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO, .bindingCount = static_cast<uint32_t>(bindingFlags.size()), .pBindingFlags = bindingFlags.data() };
+			VkDescriptorSetLayoutCreateInfo descriptorLayoutCI{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, .pNext = &bindingFlagsCI, .bindingCount = static_cast<uint32_t>(setLayoutBindings.size()), .pBindings = setLayoutBindings.data() };
+			VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device->logicalDevice, &descriptorLayoutCI, nullptr, &descriptorSetLayoutBindless));
+		}
+		VkDescriptorSetVariableDescriptorCountAllocateInfo variableDescriptorCountAllocInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO, .descriptorSetCount = 1, .pDescriptorCounts = &bindlessMaterials.textureCount };
+		VkDescriptorSetAllocateInfo descriptorSetAllocInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, .pNext = &variableDescriptorCountAllocInfo, .descriptorPool = descriptorPool, .descriptorSetCount = 1, .pSetLayouts = &descriptorSetLayoutBindless };
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(device->logicalDevice, &descriptorSetAllocInfo, &bindlessMaterials.descriptorSet));
+		std::vector<VkDescriptorImageInfo> textureDescriptors{ emptyTexture.descriptor };
+		for (const Texture& texture : textures) {
+			textureDescriptors.push_back(texture.descriptor);
 		}
+		const VkDescriptorBufferInfo materialDataInfo{ bindlessMaterials.buffer, 0, VK_WHOLE_SIZE };
+		const std::array<VkWriteDescriptorSet, 2> writeDescriptorSets = {
+			VkWriteDescriptorSet{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstSet = bindlessMaterials.descriptorSet, .dstBinding = 0, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &materialDataInfo },
+			VkWriteDescriptorSet{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, .dstSet = bindlessMaterials.descriptorSet, .dstBinding = 1, .descriptorCount = static_cast<uint32_t>(textureDescriptors.size()), .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .pImageInfo = textureDescriptors.data() },
+		};
+		// Without images (not even the empty texture) the texture array stays unwritten, which the partially bound flag allows
+		const uint32_t writeCount = (fileLoadingFlags & FileLoadingFlags::DontLoadImages) ? 1 : 2;
+		vkUpdateDescriptorSets(device->logicalDevice, writeCount, writeDescriptorSets.data(), 0, nullptr);
 	}
 
 	// Descriptors for per-material images
-	{
+	if (bindlessSetCount == 0) {
 		// Layout is global, so only create if it hasn't already been created before
 		if (descriptorSetLayoutImage == VK_NULL_HANDLE) {
 			std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
@@ -1420,31 +2437,54 @@ void vkglTF::Model::bindBuffers(VkCommandBuffer commandBuffer)
 	buffersBound = true;
 }
 
+namespace
+{
+	// Filter primitives by the alpha mode selected with the render flags
+	bool skipPrimitive(const vkglTF::Primitive& primitive, uint32_t renderFlags)
+	{
+		bool skip = false;
+		const vkglTF::Material& material = primitive.material;
+		if (renderFlags & vkglTF::RenderFlags::RenderOpaqueNodes) {
+			skip = (material.alphaMode != vkglTF::Material::ALPHAMODE_OPAQUE);
+		}
+		if (renderFlags & vkglTF::RenderFlags::RenderAlphaMaskedNodes) {
+			skip = (material.alphaMode != vkglTF::Material::ALPHAMODE_MASK);
+		}
+		if (renderFlags & vkglTF::RenderFlags::RenderAlphaBlendedNodes) {
+			skip = (material.alphaMode != vkglTF::Material::ALPHAMODE_BLEND);
+		}
+		return skip;
+	}
+}
+
 void vkglTF::Model::drawNode(Node *node, VkCommandBuffer commandBuffer, uint32_t renderFlags, VkPipelineLayout pipelineLayout, uint32_t bindImageSet)
+{
+	// Bindless models bind all materials once for the whole node walk and select a material with a push constant
+	const bool bindless = (renderFlags & RenderFlags::BindImages) && (bindlessMaterials.descriptorSet != VK_NULL_HANDLE);
+	if (bindless) {
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, bindImageSet, 1, &bindlessMaterials.descriptorSet, 0, nullptr);
+	}
+	drawNodePrimitives(node, commandBuffer, renderFlags, pipelineLayout, bindImageSet, bindless);
+}
+
+void vkglTF::Model::drawNodePrimitives(Node* node, VkCommandBuffer commandBuffer, uint32_t renderFlags, VkPipelineLayout pipelineLayout, uint32_t bindImageSet, bool bindless)
 {
 	if (node->mesh) {
 		for (Primitive* primitive : node->mesh->primitives) {
-			bool skip = false;
 			const vkglTF::Material& material = primitive->material;
-			if (renderFlags & RenderFlags::RenderOpaqueNodes) {
-				skip = (material.alphaMode != Material::ALPHAMODE_OPAQUE);
-			}
-			if (renderFlags & RenderFlags::RenderAlphaMaskedNodes) {
-				skip = (material.alphaMode != Material::ALPHAMODE_MASK);
-			}
-			if (renderFlags & RenderFlags::RenderAlphaBlendedNodes) {
-				skip = (material.alphaMode != Material::ALPHAMODE_BLEND);
-			}
-			if (!skip) {
-				if (renderFlags & RenderFlags::BindImages) {
+			if (!skipPrimitive(*primitive, renderFlags)) {
+				if (bindless) {
+					const uint32_t materialIndex = static_cast<uint32_t>(&material - materials.data());
+					vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, materialPushConstantOffset, sizeof(uint32_t), &materialIndex);
+				} else if (renderFlags & RenderFlags::BindImages) {
 					vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, bindImageSet, 1, &material.descriptorSet, 0, nullptr);
 				}
-				vkCmdDrawIndexed(commandBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+				vkCmdDrawIndexed(commandBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, node->instanceIndex);
 			}
 		}
 	}
 	for (auto& child : node->children) {
-		drawNode(child, commandBuffer, renderFlags, pipelineLayout, bindImageSet);
+		drawNodePrimitives(child, commandBuffer, renderFlags, pipelineLayout, bindImageSet, bindless);
 	}
 }
 
@@ -1455,17 +2495,371 @@ void vkglTF::Model::draw(VkCommandBuffer commandBuffer, uint32_t renderFlags, Vk
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices.buffer, offsets);
 		vkCmdBindIndexBuffer(commandBuffer, indices.buffer, 0, VK_INDEX_TYPE_UINT32);
 	}
-	for (auto& node : nodes) {
-		drawNode(node, commandBuffer, renderFlags, pipelineLayout, bindImageSet);
+	auto tRecordStart = std::chrono::high_resolution_clock::now();
+	recordStatistics = {};
+	if (drawListDirty) {
+		buildDrawList();
+	}
+	// Bindless models bind all materials once and select a material with a push constant
+	const bool bindless = (renderFlags & RenderFlags::BindImages) && (bindlessMaterials.descriptorSet != VK_NULL_HANDLE);
+	if (bindless) {
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, bindImageSet, 1, &bindlessMaterials.descriptorSet, 0, nullptr);
+		recordStatistics.descriptorBinds++;
+	}
+	// Material descriptor sets are only bound when they change, the draw list is sorted to keep changes to a minimum
+	VkDescriptorSet boundDescriptorSet = VK_NULL_HANDLE;
+	uint32_t boundMaterial = ~0u;
+	auto drawCommands = [&](const std::vector<DrawCommand>& commands) {
+		for (const DrawCommand& command : commands) {
+			if (bindless) {
+				if (command.material != boundMaterial) {
+					vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, materialPushConstantOffset, sizeof(uint32_t), &command.material);
+					boundMaterial = command.material;
+					recordStatistics.pushConstants++;
+				}
+			} else if (renderFlags & RenderFlags::BindImages) {
+				const VkDescriptorSet descriptorSet = materials[command.material].descriptorSet;
+				if (descriptorSet != boundDescriptorSet) {
+					vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, bindImageSet, 1, &descriptorSet, 0, nullptr);
+					boundDescriptorSet = descriptorSet;
+					recordStatistics.descriptorBinds++;
+				}
+			}
+			// Nodes sharing geometry are drawn as instances, gl_InstanceIndex is the node's index into instanceNodes and the node storage buffers
+			vkCmdDrawIndexed(commandBuffer, command.indexCount, command.instanceCount, command.firstIndex, 0, command.firstInstance);
+			recordStatistics.draws++;
+		}
+	};
+	// Without alpha mode flags all primitives are drawn, opaque ones first and blended ones last
+	const bool allAlphaModes = !(renderFlags & (RenderFlags::RenderOpaqueNodes | RenderFlags::RenderAlphaMaskedNodes | RenderFlags::RenderAlphaBlendedNodes));
+	if (allAlphaModes || (renderFlags & RenderFlags::RenderOpaqueNodes)) {
+		drawCommands(drawList.opaque);
+	}
+	if (allAlphaModes || (renderFlags & RenderFlags::RenderAlphaMaskedNodes)) {
+		drawCommands(drawList.mask);
+	}
+	if (allAlphaModes || (renderFlags & RenderFlags::RenderAlphaBlendedNodes)) {
+		drawCommands(drawList.blend);
 	}
+	recordStatistics.cpuTime = millisecondsSince(tRecordStart);
+}
+
+void vkglTF::Model::buildDrawList()
+{
+	drawList = {};
+	blendCenters.clear();
+	drawListStatistics = {};
+	for (const DrawBatch& batch : drawBatches) {
+		for (const Primitive* primitive : batch.mesh->primitives) {
+			const DrawCommand command{
+				.firstIndex = primitive->firstIndex,
+				.indexCount = primitive->indexCount,
+				.firstInstance = batch.firstInstance,
+				.instanceCount = batch.instanceCount,
+				.material = static_cast<uint32_t>(&primitive->material - materials.data())
+			};
+			drawListStatistics.unsortedDraws++;
+			switch (primitive->material.alphaMode) {
+			case Material::ALPHAMODE_BLEND:
+				// Instances of blended primitives have to be ordered by depth, so they can't share a draw
+				for (uint32_t i = 0; i < batch.instanceCount; i++) {
+					drawList.blend.push_back(command);
+					drawList.blend.back().firstInstance = batch.firstInstance + i;
+					drawList.blend.back().instanceCount = 1;
+					blendCenters.push_back(primitive->dimensions.center);
+				}
+				break;
+			case Material::ALPHAMODE_MASK:
+				drawList.mask.push_back(command);
+				break;
+			default:
+				drawList.opaque.push_back(command);
+			}
+		}
+	}
+	drawListStatistics.unsortedDescriptorBinds = drawListStatistics.unsortedDraws;
+
+	auto materialOrder = [](const DrawCommand& a, const DrawCommand& b) {
+		if (a.material != b.material) {
+			return a.material < b.material;
+		}
+		if (a.firstIndex != b.firstIndex) {
+			return a.firstIndex < b.firstIndex;
+		}
+		return a.firstInstance < b.firstInstance;
+	};
+	std::sort(drawList.opaque.begin(), drawList.opaque.end(), materialOrder);
+	std::sort(drawList.mask.begin(), drawList.mask.end(), materialOrder);
+
+	uint32_t boundMaterial = ~0u;
+	for (const std::vector<DrawCommand>* commands : { &drawList.opaque, &drawList.mask, &drawList.blend }) {
+		for (const DrawCommand& command : *commands) {
+			if (command.material != boundMaterial) {
+				drawListStatistics.descriptorBinds++;
+				boundMaterial = command.material;
+			}
+		}
+		drawListStatistics.draws += static_cast<uint32_t>(commands->size());
+	}
+	drawListDirty = false;
+}
+
+void vkglTF::Model::sortBlendedDraws(const glm::vec3& viewPosition)
+{
+	if (drawListDirty) {
+		buildDrawList();
+	}
+	std::vector<std::pair<float, uint32_t>> order(drawList.blend.size());
+	for (uint32_t i = 0; i < static_cast<uint32_t>(drawList.blend.size()); i++) {
+		const glm::mat4& m = transforms.worldMatrices[instanceNodes[drawList.blend[i].firstInstance]->transformIndex];
+		const glm::vec3 center = glm::vec3(m * glm::vec4(blendCenters[i], 1.0f));
+		const glm::vec3 offset = center - viewPosition;
+		order[i] = { glm::dot(offset, offset), i };
+	}
+	std::sort(order.begin(), order.end(), [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; });
+	std::vector<DrawCommand> commands(order.size());
+	std::vector<glm::vec3> centers(order.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		commands[i] = drawList.blend[order[i].second];
+		centers[i] = blendCenters[order[i].second];
+	}
+	drawList.blend = std::move(commands);
+	blendCenters = std::move(centers);
+}
+
+/*
+	Group the nodes that share geometry into instanced draws, batches are ordered like a traversal of the node hierarchy would draw them
+*/
+void vkglTF::Model::prepareDrawBatches()
+{
+	drawBatches.clear();
+	instanceNodes.clear();
+	drawListDirty = true;
+	loadStatistics.sharedGeometrySize = 0;
+	loadStatistics.drawCount = 0;
+	loadStatistics.nodeDrawCount = 0;
+
+	std::vector<Node*> drawOrder;
+	std::vector<Node*> stack(nodes.rbegin(), nodes.rend());
+	while (!stack.empty()) {
+		Node* node = stack.back();
+		stack.pop_back();
+		if (node->mesh && !node->mesh->primitives.empty()) {
+			drawOrder.push_back(node);
+		}
+		stack.insert(stack.end(), node->children.rbegin(), node->children.rend());
+	}
+
+	// Geometry is identified by the first index of its first primitive
+	std::unordered_map<uint32_t, size_t> batchIndices;
+	std::unordered_set<uint32_t> storedGeometry;
+	std::vector<std::vector<Node*>> batchNodes;
+	for (Node* node : drawOrder) {
+		const Mesh* mesh = node->mesh;
+		loadStatistics.nodeDrawCount += static_cast<uint32_t>(mesh->primitives.size());
+		for (const Primitive* primitive : mesh->primitives) {
+			if (!storedGeometry.insert(primitive->firstIndex).second) {
+				loadStatistics.sharedGeometrySize += static_cast<VkDeviceSize>(primitive->vertexCount) * sizeof(Vertex) + static_cast<VkDeviceSize>(primitive->indexCount) * sizeof(uint32_t);
+			}
+		}
+		// Skinned nodes need their own joint matrices, so they are never instanced
+		const uint32_t geometry = mesh->primitives[0]->firstIndex;
+		auto batch = node->skin ? batchIndices.end() : batchIndices.find(geometry);
+		if (batch != batchIndices.end()) {
+			batchNodes[batch->second].push_back(node);
+			continue;
+		}
+		if (!node->skin) {
+			batchIndices[geometry] = batchNodes.size();
+		}
+		batchNodes.push_back({ node });
+	}
+
+	for (const std::vector<Node*>& batch : batchNodes) {
+		drawBatches.push_back({ .mesh = batch[0]->mesh, .firstInstance = static_cast<uint32_t>(instanceNodes.size()), .instanceCount = static_cast<uint32_t>(batch.size()) });
+		for (Node* node : batch) {
+			node->instanceIndex = static_cast<uint32_t>(instanceNodes.size());
+			instanceNodes.push_back(node);
+		}
+		loadStatistics.drawCount += static_cast<uint32_t>(batch[0]->mesh->primitives.size());
+	}
+}
+
+/*
+	Allocate one node storage buffer per frame in flight, holding the data of all nodes in instance order followed by the joint matrices of all skinned nodes
+*/
+void vkglTF::Model::prepareNodeBuffers()
+{
+	nodeData.assign(instanceNodes.size(), NodeData{});
+	uint32_t jointCount{ 0 };
+	for (size_t i = 0; i < instanceNodes.size(); i++) {
+		const Node* node = instanceNodes[i];
+		NodeData& data = nodeData[i];
+		data.matrix = node->mesh->uniformBlock.matrix;
+		if (node->skin) {
+			data.jointOffset = jointCount;
+			data.jointCount = static_cast<uint32_t>(node->skin->joints.size());
+			jointCount += data.jointCount;
+		}
+	}
+	jointMatrices.assign(jointCount, glm::mat4(1.0f));
+	loadStatistics.nodeUniformBufferSize = instanceNodes.size() * sizeof(Mesh::UniformBlock);
+	if (nodeData.empty()) {
+		return;
+	}
+
+	// The joint matrices are bound at an offset, which has to be aligned, and the range must not be empty
+	const VkDeviceSize alignment = std::max<VkDeviceSize>(device->properties.limits.minStorageBufferOffsetAlignment, 1);
+	jointMatricesOffset = (nodeData.size() * sizeof(NodeData) + alignment - 1) / alignment * alignment;
+	const VkDeviceSize bufferSize = jointMatricesOffset + std::max(jointCount, 1u) * sizeof(glm::mat4);
+	nodeBuffers.resize(std::max(nodeBufferCount, 1u));
+	for (NodeBuffer& nodeBuffer : nodeBuffers) {
+		VK_CHECK_RESULT(device->createBuffer(
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			bufferSize,
+			&nodeBuffer.buffer,
+			&nodeBuffer.allocation));
+	}
+	loadStatistics.nodeBufferSize = bufferSize * nodeBuffers.size();
+}
+
+/*
+	Write the parameters and texture indices of all materials to the material storage buffer of bindless models
+*/
+void vkglTF::Model::prepareBindlessMaterials()
+{
+	// The texture array is created without update-after-bind, so it has to fit into the regular per-stage and per-set sampler limits
+	const VkPhysicalDeviceLimits& limits = device->properties.limits;
+	maxBindlessTextures = std::min({ maxBindlessTextures, limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages, limits.maxDescriptorSetSampledImages });
+	bindlessMaterials.textureCount = static_cast<uint32_t>(textures.size()) + 1;
+	if (bindlessMaterials.textureCount > maxBindlessTextures) {
+		vks::tools::exitFatal("Model in \"" + path + "\" has " + std::to_string(textures.size()) + " textures, bindless materials support up to " + std::to_string(maxBindlessTextures - 1), -1);
+	}
+	// Index 0 of the texture array is the empty texture, model textures follow in order
+	auto textureIndex = [this](const Texture* texture) -> uint32_t {
+		if ((texture == nullptr) || (texture < textures.data()) || (texture >= textures.data() + textures.size())) {
+			return 0;
+		}
+		return static_cast<uint32_t>(texture - textures.data()) + 1;
+	};
+	std::vector<MaterialData> materialData(materials.size());
+	for (size_t i = 0; i < materials.size(); i++) {
+		const Material& material = materials[i];
+		materialData[i] = {
+			.baseColorFactor = material.baseColorFactor,
+			.metallicFactor = material.metallicFactor,
+			.roughnessFactor = material.roughnessFactor,
+			.alphaCutoff = material.alphaCutoff,
+			.alphaMode = static_cast<uint32_t>(material.alphaMode),
+			.baseColorTexture = textureIndex(material.baseColorTexture),
+			.metallicRoughnessTexture = textureIndex(material.metallicRoughnessTexture),
+			.normalTexture = textureIndex(material.normalTexture),
+			.occlusionTexture = textureIndex(material.occlusionTexture),
+			.emissiveTexture = textureIndex(material.emissiveTexture)
+		};
+	}
+	const VkDeviceSize bufferSize = materialData.size() * sizeof(MaterialData);
+	VK_CHECK_RESULT(device->createBuffer(
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		bufferSize,
+		&bindlessMaterials.buffer,
+		&bindlessMaterials.allocation));
+	device->uploadManager.uploadBuffer(bindlessMaterials.buffer, materialData.data(), bufferSize);
+}
+
+void vkglTF::Model::updateNodeBuffer(uint32_t frame)
+{
+	if ((frame >= nodeBuffers.size()) || (nodeBuffers[frame].version == nodeDataVersion)) {
+		return;
+	}
+	NodeBuffer& nodeBuffer = nodeBuffers[frame];
+	uint8_t* mapped = static_cast<uint8_t*>(nodeBuffer.allocation.mapped);
+	memcpy(mapped, nodeData.data(), nodeData.size() * sizeof(NodeData));
+	if (!jointMatrices.empty()) {
+		memcpy(mapped + jointMatricesOffset, jointMatrices.data(), jointMatrices.size() * sizeof(glm::mat4));
+	}
+	nodeBuffer.version = nodeDataVersion;
+}
+
+/*
+	Flatten the node hierarchy into the transform arrays, nodes are added in pre-order so every parent is stored before its children
+*/
+void vkglTF::Model::prepareTransforms()
+{
+	transforms.clear();
+	transforms.reserve(linearNodes.size());
+	std::vector<Node*> stack(nodes.rbegin(), nodes.rend());
+	while (!stack.empty()) {
+		Node* node = stack.back();
+		stack.pop_back();
+		const uint32_t parent = node->parent ? node->parent->transformIndex : vks::TransformHierarchy::noParent;
+		node->transformIndex = transforms.add(parent, node->translation, node->rotation, node->scale, node->matrix);
+		stack.insert(stack.end(), node->children.rbegin(), node->children.rend());
+	}
+}
+
+void vkglTF::Model::updateTransforms()
+{
+	if (transforms.update() == 0) {
+		return;
+	}
+	for (Node* node : linearNodes) {
+		Mesh* mesh = node->mesh;
+		if (!mesh) {
+			continue;
+		}
+		const glm::mat4& m = transforms.worldMatrices[node->transformIndex];
+		NodeData* data = (!mesh->primitives.empty() && (node->instanceIndex < nodeData.size())) ? &nodeData[node->instanceIndex] : nullptr;
+		if (node->skin) {
+			// Joints can be animated independently of the node the skin is attached to
+			bool jointsChanged = transforms.worldChanged(node->transformIndex);
+			for (size_t i = 0; (i < node->skin->joints.size()) && !jointsChanged; i++) {
+				jointsChanged = transforms.worldChanged(node->skin->joints[i]->transformIndex);
+			}
+			if (!jointsChanged) {
+				continue;
+			}
+			mesh->uniformBlock.matrix = m;
+			const glm::mat4 inverseTransform = glm::inverse(m);
+			const uint32_t jointCount = static_cast<uint32_t>(node->skin->joints.size());
+			for (uint32_t i = 0; i < jointCount; i++) {
+				const glm::mat4& jointMatrix = transforms.worldMatrices[node->skin->joints[i]->transformIndex];
+				const glm::mat4 skinMatrix = inverseTransform * jointMatrix * node->skin->inverseBindMatrices[i];
+				if (data) {
+					jointMatrices[data->jointOffset + i] = skinMatrix;
+				}
+				if (i < Mesh::maxUniformJoints) {
+					mesh->uniformBlock.jointMatrix[i] = skinMatrix;
+				}
+			}
+			mesh->uniformBlock.jointcount = (float)std::min(jointCount, Mesh::maxUniformJoints);
+			if (mesh->uniformBuffer.mapped) {
+				memcpy(mesh->uniformBuffer.mapped, &mesh->uniformBlock, sizeof(mesh->uniformBlock));
+			}
+		} else if (transforms.worldChanged(node->transformIndex)) {
+			mesh->uniformBlock.matrix = m;
+			if (mesh->uniformBuffer.mapped) {
+				memcpy(mesh->uniformBuffer.mapped, &m, sizeof(glm::mat4));
+			}
+		} else {
+			continue;
+		}
+		if (data) {
+			data->matrix = m;
+		}
+	}
+	nodeDataVersion++;
 }
 
 void vkglTF::Model::getNodeDimensions(Node *node, glm::vec3 &min, glm::vec3 &max)
 {
 	if (node->mesh) {
 		for (Primitive *primitive : node->mesh->primitives) {
-			glm::vec4 locMin = glm::vec4(primitive->dimensions.min, 1.0f) * node->getMatrix();
-			glm::vec4 locMax = glm::vec4(primitive->dimensions.max, 1.0f) * node->getMatrix();
+			const glm::mat4& m = transforms.worldMatrices[node->transformIndex];
+			glm::vec4 locMin = glm::vec4(primitive->dimensions.min, 1.0f) * m;
+			glm::vec4 locMax = glm::vec4(primitive->dimensions.max, 1.0f) * m;
 			if (locMin.x < min.x) { min.x = locMin.x; }
 			if (locMin.y < min.y) { min.y = locMin.y; }
 			if (locMin.z < min.z) { min.z = locMin.z; }
@@ -1501,49 +2895,66 @@ void vkglTF::Model::updateAnimation(uint32_t index, float time)
 
 	bool updated = false;
 	for (auto& channel : animation.channels) {
-		vkglTF::AnimationSampler &sampler = animation.samplers[channel.samplerIndex];
-		if (sampler.inputs.size() > sampler.outputsVec4.size()) {
+		const vkglTF::AnimationSampler &sampler = animation.samplers[channel.samplerIndex];
+		const size_t outputsPerInput = (sampler.interpolation == AnimationSampler::InterpolationType::CUBICSPLINE) ? 3 : 1;
+		if (sampler.inputs.empty() || (sampler.inputs.size() * outputsPerInput > sampler.outputsVec4.size())) {
 			continue;
 		}
 
-		for (auto i = 0; i < sampler.inputs.size() - 1; i++) {
-			if ((time >= sampler.inputs[i]) && (time <= sampler.inputs[i + 1])) {
-				float u = std::max(0.0f, time - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]);
-				if (u <= 1.0f) {
-					switch (channel.path) {
-					case vkglTF::AnimationChannel::PathType::TRANSLATION: {
-						glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-						channel.node->translation = glm::vec3(trans);
-						break;
-					}
-					case vkglTF::AnimationChannel::PathType::SCALE: {
-						glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-						channel.node->scale = glm::vec3(trans);
-						break;
-					}
-					case vkglTF::AnimationChannel::PathType::ROTATION: {
-						glm::quat q1;
-						q1.x = sampler.outputsVec4[i].x;
-						q1.y = sampler.outputsVec4[i].y;
-						q1.z = sampler.outputsVec4[i].z;
-						q1.w = sampler.outputsVec4[i].w;
-						glm::quat q2;
-						q2.x = sampler.outputsVec4[i + 1].x;
-						q2.y = sampler.outputsVec4[i + 1].y;
-						q2.z = sampler.outputsVec4[i + 1].z;
-						q2.w = sampler.outputsVec4[i + 1].w;
-						channel.node->rotation = glm::normalize(glm::slerp(q1, q2, u));
-						break;
-					}
-					}
-					updated = true;
-				}
-			}
+		vks::KeyframeSampler::Interpolation interpolation = vks::KeyframeSampler::Interpolation::Linear;
+		if (sampler.interpolation == AnimationSampler::InterpolationType::STEP) {
+			interpolation = vks::KeyframeSampler::Interpolation::Step;
+		}
+		if (sampler.interpolation == AnimationSampler::InterpolationType::CUBICSPLINE) {
+			interpolation = vks::KeyframeSampler::Interpolation::CubicSpline;
+		}
+		const bool rotation = (channel.path == vkglTF::AnimationChannel::PathType::ROTATION);
+		const glm::vec4 value = vks::KeyframeSampler::sample(interpolation, sampler.inputs.data(), sampler.outputsVec4.data(), static_cast<uint32_t>(sampler.inputs.size()), time, channel.cursor, rotation);
+
+		switch (channel.path) {
+		case vkglTF::AnimationChannel::PathType::TRANSLATION:
+			channel.node->translation = glm::vec3(value);
+			transforms.setTranslation(channel.node->transformIndex, channel.node->translation);
+			break;
+		case vkglTF::AnimationChannel::PathType::SCALE:
+			channel.node->scale = glm::vec3(value);
+			transforms.setScale(channel.node->transformIndex, channel.node->scale);
+			break;
+		case vkglTF::AnimationChannel::PathType::ROTATION:
+			channel.node->rotation = glm::quat(value.w, value.x, value.y, value.z);
+			transforms.setRotation(channel.node->transformIndex, channel.node->rotation);
+			break;
 		}
+		updated = true;
 	}
 	if (updated) {
-		for (auto &node : nodes) {
-			node->update();
+		updateTransforms();
+	}
+}
+
+void vkglTF::Model::updateAnimations(const std::vector<AnimationUpdate>& updates, vks::JobSystem* jobSystem)
+{
+	VKS_PROFILE_ZONE("glTF animations");
+	// Updates are grouped by model, so a model listed more than once is only ever updated by one job, in the order of the list
+	std::vector<std::vector<const AnimationUpdate*>> modelUpdates;
+	std::unordered_map<const Model*, size_t> modelIndices;
+	for (const AnimationUpdate& animationUpdate : updates) {
+		const auto [entry, inserted] = modelIndices.try_emplace(animationUpdate.model, modelUpdates.size());
+		if (inserted) {
+			modelUpdates.emplace_back();
+		}
+		modelUpdates[entry->second].push_back(&animationUpdate);
+	}
+	auto update = [&modelUpdates](uint32_t i) {
+		for (const AnimationUpdate* animationUpdate : modelUpdates[i]) {
+			animationUpdate->model->updateAnimation(animationUpdate->animation, animationUpdate->time);
+		}
+	};
+	if (jobSystem) {
+		jobSystem->parallelFor(static_cast<uint32_t>(modelUpdates.size()), update);
+	} else {
+		for (uint32_t i = 0; i < static_cast<uint32_t>(modelUpdates.size()); i++) {
+			update(i);
 		}
 	}
 }
@@ -19,6 +19,8 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <array>
+#include <unordered_map>
 
 #include "vulkan/vulkan.h"
 #include "VulkanDevice.h"
@@ -32,6 +34,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "transformhierarchy.hpp"
+#include "keyframesampler.hpp"
+
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 #ifdef VK_USE_PLATFORM_ANDROID_KHR
 #define TINYGLTF_ANDROID_LOAD_FROM_ASSETS
@@ -42,6 +47,11 @@
 #include <android/asset_manager.h>
 #endif
 
+namespace vks
+{
+	class JobSystem;
+}
+
 namespace vkglTF
 {
 	enum DescriptorBindingFlags {
@@ -51,8 +61,21 @@ namespace vkglTF
 
 	extern VkDescriptorSetLayout descriptorSetLayoutImage;
 	extern VkDescriptorSetLayout descriptorSetLayoutUbo;
+	extern VkDescriptorSetLayout descriptorSetLayoutNodes;
+	/** @brief Layout of Model::bindlessMaterials.descriptorSet, created for the first model loaded with FileLoadingFlags::BindlessMaterials */
+	extern VkDescriptorSetLayout descriptorSetLayoutBindless;
+	/** @brief Upper bound for the number of textures in the variable sized texture array of bindless models, clamped to the device's sampler limits when the first bindless model is loaded */
+	extern uint32_t maxBindlessTextures;
+	/** @brief Number of node storage buffers per model, one per frame in flight (see Model::updateNodeBuffer) */
+	extern uint32_t nodeBufferCount;
 	extern VkMemoryPropertyFlags memoryPropertyFlags;
 	extern uint32_t descriptorBindingFlags;
+	/** @brief Store cooked copies of loaded models and load from them on subsequent runs, skipping glTF parsing (disabled by default, enabled with -mc) */
+	extern bool modelCacheEnabled;
+	/** @brief Directory the cooked model caches are written to */
+	extern std::string modelCacheDir;
+	/** @brief Print the timings and statistics of each loaded model (see Model::loadStatistics) to stdout */
+	extern bool printLoadStatistics;
 
 	struct Node;
 
@@ -64,6 +87,7 @@ namespace vkglTF
 		VkImage image;
 		VkImageLayout imageLayout;
 		VkDeviceMemory deviceMemory;
+		vks::MemoryAllocation allocation{};
 		VkImageView view;
 		uint32_t width, height;
 		uint32_t mipLevels;
@@ -133,22 +157,26 @@ namespace vkglTF
 		std::vector<Primitive*> primitives;
 		std::string name;
 
+		/** @brief Only created for models loaded with FileLoadingFlags::NodeUniformBuffers, other models store all nodes in Model::nodeBuffers */
 		struct UniformBuffer {
-			VkBuffer buffer;
-			VkDeviceMemory memory;
-			VkDescriptorBufferInfo descriptor;
+			VkBuffer buffer{ VK_NULL_HANDLE };
+			vks::MemoryAllocation allocation;
+			VkDescriptorBufferInfo descriptor{};
 			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
-			void* mapped;
+			void* mapped{ nullptr };
 		} uniformBuffer;
 
+		/** @brief Number of joints that fit into the uniform block, skins with more joints are only fully available in the node storage buffers */
+		static constexpr uint32_t maxUniformJoints = 64;
 		struct UniformBlock {
 			glm::mat4 matrix;
-			glm::mat4 jointMatrix[64]{};
+			glm::mat4 jointMatrix[maxUniformJoints]{};
 			float jointcount{ 0 };
 		} uniformBlock;
 
 		Mesh(vks::VulkanDevice* device, glm::mat4 matrix);
 		~Mesh();
+		void createUniformBuffer();
 	};
 
 	/*
@@ -176,7 +204,12 @@ namespace vkglTF
 		glm::vec3 translation{};
 		glm::vec3 scale{ 1.0f };
 		glm::quat rotation{};
+		/** @brief Index of the node in Model::transforms */
+		uint32_t transformIndex{ 0 };
+		/** @brief Index of the node in Model::instanceNodes and its data in the node storage buffers (only valid for nodes with primitives) */
+		uint32_t instanceIndex{ 0 };
 		glm::mat4 localMatrix();
+		/** @brief Computes the world matrix by walking the parent chain, Model::transforms keeps the world matrices of all nodes up to date */
 		glm::mat4 getMatrix();
 		void update();
 		~Node();
@@ -190,6 +223,8 @@ namespace vkglTF
 		PathType path;
 		Node* node;
 		uint32_t samplerIndex;
+		/** @brief Keyframe interval of the last evaluation, the lookup starts from here (see vks::KeyframeSampler::findInterval) */
+		uint32_t cursor{ 0 };
 	};
 
 	/*
@@ -199,6 +234,7 @@ namespace vkglTF
 		enum InterpolationType { LINEAR, STEP, CUBICSPLINE };
 		InterpolationType interpolation;
 		std::vector<float> inputs;
+		// Cubic splines store three outputs per input: in-tangent, value and out-tangent
 		std::vector<glm::vec4> outputsVec4;
 	};
 
@@ -241,7 +277,18 @@ namespace vkglTF
 		PreTransformVertices = 0x00000001,
 		PreMultiplyVertexColors = 0x00000002,
 		FlipY = 0x00000004,
-		DontLoadImages = 0x00000008
+		DontLoadImages = 0x00000008,
+		// Reorder triangles for vertex cache locality and vertices for fetch locality
+		OptimizeIndices = 0x00000010,
+		// Additionally reorder triangle clusters to reduce overdraw (requires OptimizeIndices)
+		OptimizeOverdraw = 0x00000020,
+		// Create a uniform buffer and descriptor set per mesh (Mesh::uniformBuffer, limited to 64 joints) for shaders that read the per-mesh uniform block
+		NodeUniformBuffers = 0x00000040,
+		// Store all textures in one variable sized descriptor array and the materials in a storage buffer instead of creating a descriptor set per material (see Model::bindlessMaterials)
+		// Requires the runtimeDescriptorArray, descriptorBindingVariableDescriptorCount, descriptorBindingPartiallyBound and shaderSampledImageArrayNonUniformIndexing features
+		BindlessMaterials = 0x00000080,
+		// Create the node storage buffers and their descriptor sets (Model::nodeBuffers, one per frame in flight) for shaders that read the node data with gl_InstanceIndex, required by vks::GpuCulling
+		NodeStorageBuffers = 0x00000100
 	};
 
 	enum RenderFlags {
@@ -251,6 +298,36 @@ namespace vkglTF
 		RenderAlphaBlendedNodes = 0x00000008
 	};
 
+	/*
+		Per node data in the node storage buffers (std430 layout), the joint matrices of skinned nodes start at jointOffset
+	*/
+	struct NodeData {
+		glm::mat4 matrix;
+		uint32_t jointOffset{ 0 };
+		uint32_t jointCount{ 0 };
+		uint32_t padding[2]{};
+	};
+	static_assert(sizeof(NodeData) == 80, "NodeData has to match the std430 layout used by shaders");
+
+	/*
+		Per material data in the material storage buffer of bindless models (std430 layout)
+		Texture members are indices into the texture array, index 0 is an empty texture for materials without that texture
+	*/
+	struct MaterialData {
+		glm::vec4 baseColorFactor{ 1.0f };
+		float metallicFactor{ 1.0f };
+		float roughnessFactor{ 1.0f };
+		float alphaCutoff{ 1.0f };
+		uint32_t alphaMode{ 0 };
+		uint32_t baseColorTexture{ 0 };
+		uint32_t metallicRoughnessTexture{ 0 };
+		uint32_t normalTexture{ 0 };
+		uint32_t occlusionTexture{ 0 };
+		uint32_t emissiveTexture{ 0 };
+		uint32_t padding[3]{};
+	};
+	static_assert(sizeof(MaterialData) == 64, "MaterialData has to match the std430 layout used by shaders");
+
 	/*
 		glTF model loading and rendering class
 	*/
@@ -259,6 +336,31 @@ namespace vkglTF
 		vkglTF::Texture* getTexture(uint32_t index);
 		vkglTF::Texture emptyTexture;
 		void createEmptyTexture(VkQueue transferQueue);
+		void createBuffers(const void* vertexData, uint32_t vertexCount, const void* indexData, uint32_t indexCount);
+		void optimizeIndices(std::vector<uint32_t>& indexBuffer, std::vector<Vertex>& vertexBuffer, uint32_t fileLoadingFlags);
+		/** @brief Mesh that first loaded the geometry of a glTF mesh while loading, later nodes referring to the same glTF mesh share its primitives */
+		std::unordered_map<int, const Mesh*> meshGeometry;
+		void prepareDrawBatches();
+		void prepareTransforms();
+		void prepareNodeBuffers();
+		void prepareBindlessMaterials();
+		void drawNodePrimitives(Node* node, VkCommandBuffer commandBuffer, uint32_t renderFlags, VkPipelineLayout pipelineLayout, uint32_t bindImageSet, bool bindless);
+		/** @brief Set when the draw batches changed, draw rebuilds the draw list before recording */
+		bool drawListDirty{ true };
+		/** @brief Object space center of the primitive of every entry in drawList.blend, used for depth sorting */
+		std::vector<glm::vec3> blendCenters;
+		/** @brief CPU copy of the node storage buffer contents, written to the buffer of a frame by updateNodeBuffer */
+		std::vector<NodeData> nodeData;
+		std::vector<glm::mat4> jointMatrices;
+		VkDeviceSize jointMatricesOffset{ 0 };
+		uint64_t nodeDataVersion{ 0 };
+		bool loadFromCache(const std::string& cacheFile, const std::string& filename, uint32_t fileLoadingFlags, float scale, VkQueue transferQueue, std::string& missReason);
+		void saveToCache(const std::string& cacheFile, const std::string& filename, uint32_t fileLoadingFlags, float scale, const tinygltf::Model& gltfModel, const std::vector<Vertex>& vertexBuffer, const std::vector<uint32_t>& indexBuffer);
+		/** @brief Encoded image data collected while parsing, decoded in parallel by loadImages */
+		std::vector<std::vector<unsigned char>> encodedImages;
+		/** @brief Binary chunk of a .glb file, read in place from the mapped file while loading */
+		const unsigned char* binaryChunk{ nullptr };
+		const unsigned char* getBufferData(const tinygltf::Model& model, int bufferIndex) const;
 	public:
 		vks::VulkanDevice* device;
 		VkDescriptorPool descriptorPool;
@@ -266,16 +368,84 @@ namespace vkglTF
 		struct Vertices {
 			int count;
 			VkBuffer buffer;
-			VkDeviceMemory memory;
+			vks::MemoryAllocation allocation;
 		} vertices;
 		struct Indices {
 			int count;
 			VkBuffer buffer;
-			VkDeviceMemory memory;
+			vks::MemoryAllocation allocation;
 		} indices;
+		/** @brief Nodes sharing the same geometry that are drawn with one instanced draw per primitive */
+		struct DrawBatch {
+			const Mesh* mesh;
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+		};
+		std::vector<DrawBatch> drawBatches;
+		/** @brief Compact parameters of a single indexed draw in the draw list */
+		struct DrawCommand {
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+			uint32_t material;
+		};
+		/**
+		* Draws compiled from the draw batches, split by alpha mode (which selects the pipeline) and sorted by material and geometry
+		* Blended draws are split into single instances and sorted back to front by sortBlendedDraws
+		*/
+		struct DrawList {
+			std::vector<DrawCommand> opaque;
+			std::vector<DrawCommand> mask;
+			std::vector<DrawCommand> blend;
+		} drawList;
+		/** @brief Draws and material descriptor set binds of a draw call with RenderFlags::BindImages, compared to drawing the batches in hierarchy order */
+		struct DrawListStatistics {
+			uint32_t draws{ 0 };
+			uint32_t descriptorBinds{ 0 };
+			uint32_t unsortedDraws{ 0 };
+			uint32_t unsortedDescriptorBinds{ 0 };
+		} drawListStatistics;
+		/** @brief Nodes in instance order, draw passes firstInstance so gl_InstanceIndex selects the node */
+		std::vector<Node*> instanceNodes;
+		/**
+		* Persistently mapped storage buffer with the data of all nodes, one per frame in flight (see nodeBufferCount), only created for models loaded with FileLoadingFlags::NodeStorageBuffers
+		* Binding 0 of descriptorSet is the NodeData array indexed by gl_InstanceIndex, binding 1 the joint matrices of all skins:
+		* layout (set = n, binding = 0) readonly buffer Nodes { NodeData nodes[]; }; layout (set = n, binding = 1) readonly buffer Joints { mat4 jointMatrices[]; };
+		*/
+		struct NodeBuffer {
+			VkBuffer buffer{ VK_NULL_HANDLE };
+			vks::MemoryAllocation allocation;
+			VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+			// Node data version the buffer contains
+			uint64_t version{ 0 };
+		};
+		std::vector<NodeBuffer> nodeBuffers;
+		/**
+		* Material storage buffer and texture array of models loaded with FileLoadingFlags::BindlessMaterials, draw binds descriptorSet once instead of a set per material
+		* layout (set = n, binding = 0) readonly buffer Materials { MaterialData materials[]; }; layout (set = n, binding = 1) uniform sampler2D textures[];
+		* The material index of a draw is passed as a uint push constant for the fragment stage at materialPushConstantOffset
+		*/
+		struct BindlessMaterials {
+			VkBuffer buffer{ VK_NULL_HANDLE };
+			vks::MemoryAllocation allocation;
+			VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+			// Model textures plus the empty texture at index 0
+			uint32_t textureCount{ 0 };
+		} bindlessMaterials;
+		uint32_t materialPushConstantOffset{ 0 };
+		/** @brief Commands recorded by the last draw call and the CPU time spent recording them */
+		struct RecordStatistics {
+			uint32_t draws{ 0 };
+			uint32_t descriptorBinds{ 0 };
+			uint32_t pushConstants{ 0 };
+			double cpuTime{ 0.0 };
+		} recordStatistics;
 
 		std::vector<Node*> nodes;
 		std::vector<Node*> linearNodes;
+		/** @brief Local and world transforms of all nodes, parents are stored before their children (see Node::transformIndex) */
+		vks::TransformHierarchy transforms;
 
 		std::vector<Skin*> skins;
 
@@ -291,6 +461,31 @@ namespace vkglTF
 			float radius;
 		} dimensions;
 
+		/** @brief Time in ms spent in the stages of the last loadFromFile call and the size of the vertex data it created */
+		struct LoadStatistics {
+			bool binary{ false };
+			bool cacheHit{ false };
+			double parse{ 0.0 };
+			double imageDecode{ 0.0 };
+			double scene{ 0.0 };
+			double upload{ 0.0 };
+			double total{ 0.0 };
+			VkDeviceSize vertexBufferSize{ 0 };
+			// Vertex cache efficiency before and after FileLoadingFlags::OptimizeIndices (zero if the optimization didn't run, e.g. when loaded from the cache)
+			float acmrBefore{ 0.0f };
+			float acmrAfter{ 0.0f };
+			float atvrBefore{ 0.0f };
+			float atvrAfter{ 0.0f };
+			// Geometry shared by nodes referring to the same glTF mesh (not stored multiple times) and the draw calls it saves
+			VkDeviceSize sharedGeometrySize{ 0 };
+			uint32_t drawCount{ 0 };
+			uint32_t nodeDrawCount{ 0 };
+			// Size of all node storage buffers compared to the size per-mesh uniform buffers (FileLoadingFlags::NodeUniformBuffers) have
+			VkDeviceSize nodeBufferSize{ 0 };
+			VkDeviceSize nodeUniformBufferSize{ 0 };
+			uint32_t nodeUniformBufferCount{ 0 };
+		} loadStatistics;
+
 		bool metallicRoughnessWorkflow = true;
 		bool buffersBound = false;
 		std::string path;
@@ -306,9 +501,30 @@ namespace vkglTF
 		void bindBuffers(VkCommandBuffer commandBuffer);
 		void drawNode(Node* node, VkCommandBuffer commandBuffer, uint32_t renderFlags = 0, VkPipelineLayout pipelineLayout = VK_NULL_HANDLE, uint32_t bindImageSet = 1);
 		void draw(VkCommandBuffer commandBuffer, uint32_t renderFlags = 0, VkPipelineLayout pipelineLayout = VK_NULL_HANDLE, uint32_t bindImageSet = 1);
+		/** @brief Compile the draw batches into the sorted draw list, only required if the scene changed (draw does this automatically after loading) */
+		void buildDrawList();
+		/** @brief Sort the blended draws back to front for the given view position (in model space), call when the camera moves */
+		void sortBlendedDraws(const glm::vec3& viewPosition);
 		void getNodeDimensions(Node* node, glm::vec3& min, glm::vec3& max);
 		void getSceneDimensions();
 		void updateAnimation(uint32_t index, float time);
+		/** @brief Animation to apply to a model with updateAnimations */
+		struct AnimationUpdate {
+			Model* model;
+			uint32_t animation;
+			float time;
+		};
+		/**
+		* Update the animations of many models (e.g. animated characters) at once
+		*
+		* @param updates Animations to apply, multiple animations of the same model are applied one after another in list order
+		* @param jobSystem Optional job system to distribute the models over its workers
+		*/
+		static void updateAnimations(const std::vector<AnimationUpdate>& updates, vks::JobSystem* jobSystem = nullptr);
+		/** @brief Update the world matrices and joint matrices of nodes whose transform changed */
+		void updateTransforms();
+		/** @brief Write the current node data to the node storage buffer of the given frame in flight if it's outdated, call before recording the frame's draws */
+		void updateNodeBuffer(uint32_t frame);
 		Node* findNode(Node* parent, uint32_t index);
 		Node* nodeFromIndex(uint32_t index);
 		void prepareNodeDescriptor(vkglTF::Node* node, VkDescriptorSetLayout descriptorSetLayout);
@@ -13,26 +13,193 @@
 #include <functional>
 #include <chrono>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cmath>
 
 namespace vks
 {
+	/**
+	* @brief Streaming quantile sketch with logarithmically sized buckets (DDSketch)
+	* @note Quantiles have a guaranteed relative error, memory only depends on the range of the values and not on the number of values added
+	*/
+	class QuantileSketch {
+	private:
+		double gamma;
+		double logGamma;
+		std::vector<uint64_t> buckets;
+		int32_t firstIndex{ 0 };
+		uint64_t count{ 0 };
+		// Values below this are put into the lowest bucket
+		static constexpr double minValue = 1.0e-6;
+
+		int32_t getIndex(double value) const
+		{
+			return static_cast<int32_t>(std::ceil(std::log(std::max(value, minValue)) / logGamma));
+		}
+	public:
+		/** @param relativeAccuracy Max. relative error of the returned quantiles */
+		QuantileSketch(double relativeAccuracy = 0.005)
+		{
+			gamma = (1.0 + relativeAccuracy) / (1.0 - relativeAccuracy);
+			logGamma = std::log(gamma);
+		}
+
+		void add(double value)
+		{
+			const int32_t index = getIndex(value);
+			if (buckets.empty()) {
+				firstIndex = index;
+				buckets.push_back(0);
+			} else if (index < firstIndex) {
+				buckets.insert(buckets.begin(), static_cast<size_t>(firstIndex - index), 0);
+				firstIndex = index;
+			} else if (index - firstIndex >= static_cast<int32_t>(buckets.size())) {
+				buckets.resize(static_cast<size_t>(index - firstIndex) + 1, 0);
+			}
+			buckets[index - firstIndex]++;
+			count++;
+		}
+
+		/** @brief Representative value of a bucket (within the relative accuracy of all values in that bucket) */
+		double getBucketValue(size_t bucket) const
+		{
+			return 2.0 * std::pow(gamma, static_cast<double>(firstIndex + static_cast<int32_t>(bucket))) / (gamma + 1.0);
+		}
+
+		/** @brief Returns the value at quantile q (0.0 ... 1.0) */
+		double getQuantile(double q) const
+		{
+			if (count == 0) {
+				return 0.0;
+			}
+			const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1));
+			uint64_t cumulative = 0;
+			for (size_t i = 0; i < buckets.size(); i++) {
+				cumulative += buckets[i];
+				if (cumulative > rank) {
+					return getBucketValue(i);
+				}
+			}
+			return getBucketValue(buckets.size() - 1);
+		}
+
+		/** @brief Number of values larger than the threshold (within the relative accuracy) */
+		uint64_t getCountAbove(double threshold) const
+		{
+			uint64_t result = 0;
+			for (size_t i = 0; i < buckets.size(); i++) {
+				if (getBucketValue(i) > threshold) {
+					result += buckets[i];
+				}
+			}
+			return result;
+		}
+
+		const std::vector<uint64_t>& getBuckets() const { return buckets; }
+		uint64_t getCount() const { return count; }
+	};
+
 	class Benchmark {
 	private:
 		FILE* stream{ nullptr };
 		VkPhysicalDeviceProperties deviceProps{};
+		QuantileSketch frameTimeSketch;
+		// Running mean and variance (Welford)
+		double frameTimeMean{ 0.0 };
+		double frameTimeM2{ 0.0 };
+		double frameTimeMin{ std::numeric_limits<double>::max() };
+		double frameTimeMax{ 0.0 };
+
+		void addFrameTime(double frameTime)
+		{
+			frameTimeSketch.add(frameTime);
+			const double delta = frameTime - frameTimeMean;
+			frameTimeMean += delta / static_cast<double>(frameCount);
+			frameTimeM2 += delta * (frameTime - frameTimeMean);
+			frameTimeMin = std::min(frameTimeMin, frameTime);
+			frameTimeMax = std::max(frameTimeMax, frameTime);
+			if (outputFrameTimes) {
+				frameTimes.push_back(frameTime);
+			}
+		}
+
+		static std::string escapeJson(const std::string& value)
+		{
+			std::string result;
+			for (char c : value) {
+				switch (c) {
+				case '"': result += "\\\""; break;
+				case '\\': result += "\\\\"; break;
+				case '\n': result += "\\n"; break;
+				case '\t': result += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) >= 0x20) {
+						result += c;
+					}
+				}
+			}
+			return result;
+		}
 	public:
 		bool active = false;
 		bool outputFrameTimes = false;
 		int outputFrames = -1; // -1 means no frames limit
 		uint32_t warmup = 1;   // Default to 1 sec of warm-up
 		uint32_t duration = 10;
+		// Only filled if outputFrameTimes is set, statistics are gathered without storing all frame times
 		std::vector<double> frameTimes;
 		std::string filename = "";
+		std::string jsonFilename = "";
+		// Frames taking longer than this (in ms) count as hitches, 0 = twice the median frame time
+		double hitchThreshold = 0.0;
 
 		double runtime = 0.0;
 		uint32_t frameCount = 0;
+		/** @brief Device memory allocator statistics, to be filled by the caller */
+		vks::MemoryStatistics memoryStatistics{};
+		/** @brief GPU timings in ms of the profiled command buffer regions, filled by run() if a profiler is passed */
+		std::vector<vks::GpuProfiler::RegionStatistics> gpuTimings;
+		/** @brief Run information for the reports, to be filled by the caller */
+		std::string sampleName = "";
+		std::string shaderLanguage = "";
+		uint32_t width = 0;
+		uint32_t height = 0;
+
+		/** @brief Frame time statistics in ms */
+		struct Statistics {
+			double mean{ 0.0 };
+			double standardDeviation{ 0.0 };
+			double min{ 0.0 };
+			double max{ 0.0 };
+			double p50{ 0.0 };
+			double p90{ 0.0 };
+			double p99{ 0.0 };
+			double p999{ 0.0 };
+			double hitchThreshold{ 0.0 };
+			uint64_t hitchCount{ 0 };
+		};
+
+		Statistics getStatistics() const
+		{
+			Statistics statistics{};
+			if (frameCount == 0) {
+				return statistics;
+			}
+			statistics.mean = frameTimeMean;
+			statistics.standardDeviation = (frameCount > 1) ? std::sqrt(frameTimeM2 / static_cast<double>(frameCount - 1)) : 0.0;
+			statistics.min = frameTimeMin;
+			statistics.max = frameTimeMax;
+			statistics.p50 = frameTimeSketch.getQuantile(0.5);
+			statistics.p90 = frameTimeSketch.getQuantile(0.9);
+			statistics.p99 = frameTimeSketch.getQuantile(0.99);
+			statistics.p999 = frameTimeSketch.getQuantile(0.999);
+			statistics.hitchThreshold = (hitchThreshold > 0.0) ? hitchThreshold : statistics.p50 * 2.0;
+			statistics.hitchCount = frameTimeSketch.getCountAbove(statistics.hitchThreshold);
+			return statistics;
+		}
 
-		void run(std::function<void()> renderFunc, VkPhysicalDeviceProperties deviceProps) {
+		void run(std::function<void()> renderFunc, VkPhysicalDeviceProperties deviceProps, vks::GpuProfiler* gpuProfiler = nullptr) {
 			active = true;
 			this->deviceProps = deviceProps;
 #if defined(_WIN32)
@@ -54,6 +221,9 @@ namespace vks
 					auto tDiff = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
 					tMeasured += tDiff;
 				};
+				if (gpuProfiler) {
+					gpuProfiler->resetStatistics();
+				}
 			}
 
 			// Benchmark phase
@@ -63,38 +233,55 @@ namespace vks
 					renderFunc();
 					auto tDiff = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
 					runtime += tDiff;
-					frameTimes.push_back(tDiff);
 					frameCount++;
+					addFrameTime(tDiff);
 					if (outputFrames != -1 && outputFrames == frameCount) break;
 				};
+				if (gpuProfiler) {
+					gpuTimings = gpuProfiler->getStatistics();
+				}
+				const Statistics statistics = getStatistics();
 				std::cout << std::fixed << std::setprecision(3);
 				std::cout << "Benchmark finished\n";
 				std::cout << "device : " << deviceProps.deviceName << " (driver version: " << deviceProps.driverVersion << ")" << "\n";
 				std::cout << "runtime: " << (runtime / 1000.0) << "\n";
 				std::cout << "frames : " << frameCount << "\n";
 				std::cout << "fps    : " << frameCount / (runtime / 1000.0) << "\n";
+				std::cout << "frame  : " << statistics.mean << " ms avg, " << statistics.standardDeviation << " ms stddev, p50 " << statistics.p50 << " / p90 " << statistics.p90 << " / p99 " << statistics.p99 << " / p99.9 " << statistics.p999 << " ms" << "\n";
+				std::cout << "hitches: " << statistics.hitchCount << " frames > " << statistics.hitchThreshold << " ms" << "\n";
+				std::cout << "memory : " << memoryStatistics.usedBytes / (1024.0 * 1024.0) << " of " << memoryStatistics.blockBytes / (1024.0 * 1024.0) << " MB used, " << memoryStatistics.blockCount << " blocks (" << memoryStatistics.dedicatedBlockCount << " dedicated), " << memoryStatistics.allocationCount << " allocations, " << memoryStatistics.fragmentation * 100.0f << "% fragmentation" << "\n";
+				for (auto& timing : gpuTimings) {
+					std::cout << "gpu    : " << std::string(timing.depth * 2, ' ') << timing.name << " " << timing.average << " ms avg, " << timing.min << " ms min, " << timing.max << " ms max" << "\n";
+				}
 			}
 		}
 
 		void saveResults() {
 			std::ofstream result(filename, std::ios::out);
 			if (result.is_open()) {
+				const Statistics statistics = getStatistics();
 				result << std::fixed << std::setprecision(4);
 
-				result << "device,driverversion,duration (ms),frames,fps" << "\n";
-				result << deviceProps.deviceName << "," << deviceProps.driverVersion << "," << runtime << "," << frameCount << "," << frameCount / (runtime / 1000.0) << "\n";
+				result << "device,driverversion,duration (ms),frames,fps,frametime avg (ms),frametime stddev (ms),p50 (ms),p90 (ms),p99 (ms),p99.9 (ms),hitch threshold (ms),hitches,memory blocks,memory allocations,memory allocated (bytes),memory used (bytes),memory fragmentation" << "\n";
+				result << deviceProps.deviceName << "," << deviceProps.driverVersion << "," << runtime << "," << frameCount << "," << frameCount / (runtime / 1000.0) << ","
+					<< statistics.mean << "," << statistics.standardDeviation << "," << statistics.p50 << "," << statistics.p90 << "," << statistics.p99 << "," << statistics.p999 << "," << statistics.hitchThreshold << "," << statistics.hitchCount << ","
+					<< memoryStatistics.blockCount << "," << memoryStatistics.allocationCount << "," << memoryStatistics.blockBytes << "," << memoryStatistics.usedBytes << "," << memoryStatistics.fragmentation << "\n";
+
+				if (!gpuTimings.empty()) {
+					result << "\n" << "gpu region,depth,avg (ms),min (ms),max (ms),samples" << "\n";
+					for (auto& timing : gpuTimings) {
+						result << timing.name << "," << timing.depth << "," << timing.average << "," << timing.min << "," << timing.max << "," << timing.samples << "\n";
+					}
+				}
 
 				if (outputFrameTimes) {
 					result << "\n" << "frame,ms" << "\n";
 					for (size_t i = 0; i < frameTimes.size(); i++) {
 						result << i << "," << frameTimes[i] << "\n";
 					}
-					double tMin = *std::min_element(frameTimes.begin(), frameTimes.end());
-					double tMax = *std::max_element(frameTimes.begin(), frameTimes.end());
-					double tAvg = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0) / (double)frameTimes.size();
-					std::cout << "best   : " << (1000.0 / tMin) << " fps (" << tMin << " ms)" << "\n";
-					std::cout << "worst  : " << (1000.0 / tMax) << " fps (" << tMax << " ms)" << "\n";
-					std::cout << "avg    : " << (1000.0 / tAvg) << " fps (" << tAvg << " ms)" << "\n";
+					std::cout << "best   : " << (1000.0 / statistics.min) << " fps (" << statistics.min << " ms)" << "\n";
+					std::cout << "worst  : " << (1000.0 / statistics.max) << " fps (" << statistics.max << " ms)" << "\n";
+					std::cout << "avg    : " << (1000.0 / statistics.mean) << " fps (" << statistics.mean << " ms)" << "\n";
 					std::cout << "\n";
 				}
 
@@ -104,5 +291,71 @@ namespace vks
 #endif
 			}
 		}
+
+		/** @brief Writes the results including frame time percentiles and histogram as a JSON report */
+		void saveResultsJson() {
+			std::ofstream result(jsonFilename, std::ios::out);
+			if (!result.is_open()) {
+				std::cerr << "Could not write benchmark report to " << jsonFilename << "\n";
+				return;
+			}
+			const Statistics statistics = getStatistics();
+			result << std::fixed << std::setprecision(4);
+			result << "{\n";
+			result << "\t\"sample\": \"" << escapeJson(sampleName) << "\",\n";
+			result << "\t\"device\": {\n";
+			result << "\t\t\"name\": \"" << escapeJson(deviceProps.deviceName) << "\",\n";
+			result << "\t\t\"vendorID\": " << deviceProps.vendorID << ",\n";
+			result << "\t\t\"deviceID\": " << deviceProps.deviceID << ",\n";
+			result << "\t\t\"driverVersion\": " << deviceProps.driverVersion << ",\n";
+			result << "\t\t\"apiVersion\": \"" << VK_API_VERSION_MAJOR(deviceProps.apiVersion) << "." << VK_API_VERSION_MINOR(deviceProps.apiVersion) << "." << VK_API_VERSION_PATCH(deviceProps.apiVersion) << "\"\n";
+			result << "\t},\n";
+			result << "\t\"resolution\": { \"width\": " << width << ", \"height\": " << height << " },\n";
+			result << "\t\"shaderLanguage\": \"" << escapeJson(shaderLanguage) << "\",\n";
+			result << "\t\"warmup\": " << warmup << ",\n";
+			result << "\t\"runtime\": " << runtime << ",\n";
+			result << "\t\"frames\": " << frameCount << ",\n";
+			result << "\t\"fps\": " << ((runtime > 0.0) ? frameCount / (runtime / 1000.0) : 0.0) << ",\n";
+			result << "\t\"frameTime\": {\n";
+			result << "\t\t\"mean\": " << statistics.mean << ",\n";
+			result << "\t\t\"stddev\": " << statistics.standardDeviation << ",\n";
+			result << "\t\t\"min\": " << statistics.min << ",\n";
+			result << "\t\t\"max\": " << statistics.max << ",\n";
+			result << "\t\t\"p50\": " << statistics.p50 << ",\n";
+			result << "\t\t\"p90\": " << statistics.p90 << ",\n";
+			result << "\t\t\"p99\": " << statistics.p99 << ",\n";
+			result << "\t\t\"p99.9\": " << statistics.p999 << "\n";
+			result << "\t},\n";
+			result << "\t\"hitches\": { \"threshold\": " << statistics.hitchThreshold << ", \"count\": " << statistics.hitchCount << " },\n";
+			result << "\t\"memory\": {\n";
+			result << "\t\t\"blocks\": " << memoryStatistics.blockCount << ",\n";
+			result << "\t\t\"dedicatedBlocks\": " << memoryStatistics.dedicatedBlockCount << ",\n";
+			result << "\t\t\"allocations\": " << memoryStatistics.allocationCount << ",\n";
+			result << "\t\t\"allocatedBytes\": " << memoryStatistics.blockBytes << ",\n";
+			result << "\t\t\"usedBytes\": " << memoryStatistics.usedBytes << ",\n";
+			result << "\t\t\"fragmentation\": " << memoryStatistics.fragmentation << "\n";
+			result << "\t},\n";
+			// GPU time per profiled region in hierarchical order, depth 0 is the whole frame
+			result << "\t\"gpuTimings\": [";
+			for (size_t i = 0; i < gpuTimings.size(); i++) {
+				const auto& timing = gpuTimings[i];
+				result << ((i == 0) ? "\n" : ",\n") << "\t\t{ \"name\": \"" << escapeJson(timing.name) << "\", \"depth\": " << timing.depth << ", \"avg\": " << timing.average << ", \"min\": " << timing.min << ", \"max\": " << timing.max << ", \"samples\": " << timing.samples << " }";
+			}
+			result << (gpuTimings.empty() ? "],\n" : "\n\t],\n");
+			// Histogram of the non-empty sketch buckets, each entry is the bucket's representative frame time in ms and the number of frames
+			result << "\t\"histogram\": [";
+			const std::vector<uint64_t>& buckets = frameTimeSketch.getBuckets();
+			bool first = true;
+			for (size_t i = 0; i < buckets.size(); i++) {
+				if (buckets[i] == 0) {
+					continue;
+				}
+				result << (first ? "\n" : ",\n") << "\t\t{ \"ms\": " << frameTimeSketch.getBucketValue(i) << ", \"frames\": " << buckets[i] << " }";
+				first = false;
+			}
+			result << "\n\t]\n";
+			result << "}\n";
+			result.flush();
+		}
 	};
-}
\ No newline at end of file
+}
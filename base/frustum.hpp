@@ -1,22 +1,100 @@
 /*
 * View frustum culling class
 *
-* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+* Copyright (C) 2016-2025 by Sascha Willems - www.saschawillems.de
 *
 * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
 */
 
+#pragma once
+
 #include <array>
+#include <vector>
 #include <math.h>
+#include <stdint.h>
 #include <glm/glm.hpp>
 
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VKS_FRUSTUM_SSE 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+// AVX2 code is compiled into separate functions that are only called if the CPU supports it, so the project doesn't need to be built with AVX2 enabled
+#if defined(__GNUC__) || defined(__clang__)
+#define VKS_FRUSTUM_AVX2 1
+#define VKS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#elif defined(_MSC_VER)
+#define VKS_FRUSTUM_AVX2 1
+#define VKS_TARGET_AVX2
+#endif
+#endif
+
 namespace vks
 {
+	/** @brief Bounding spheres stored as structure of arrays for batched culling */
+	struct BoundingSpheres
+	{
+		std::vector<float> centerX, centerY, centerZ, radius;
+
+		size_t size() const { return radius.size(); }
+
+		void resize(size_t count)
+		{
+			centerX.resize(count);
+			centerY.resize(count);
+			centerZ.resize(count);
+			radius.resize(count);
+		}
+
+		void set(size_t index, const glm::vec3& center, float r)
+		{
+			centerX[index] = center.x;
+			centerY[index] = center.y;
+			centerZ[index] = center.z;
+			radius[index] = r;
+		}
+	};
+
+	/** @brief Axis aligned bounding boxes stored as structure of arrays (center and half extent) for batched culling */
+	struct BoundingBoxes
+	{
+		std::vector<float> centerX, centerY, centerZ, extentX, extentY, extentZ;
+
+		size_t size() const { return centerX.size(); }
+
+		void resize(size_t count)
+		{
+			centerX.resize(count);
+			centerY.resize(count);
+			centerZ.resize(count);
+			extentX.resize(count);
+			extentY.resize(count);
+			extentZ.resize(count);
+		}
+
+		void set(size_t index, const glm::vec3& min, const glm::vec3& max)
+		{
+			const glm::vec3 center = (min + max) * 0.5f;
+			const glm::vec3 extent = (max - min) * 0.5f;
+			centerX[index] = center.x;
+			centerY[index] = center.y;
+			centerZ[index] = center.z;
+			extentX[index] = extent.x;
+			extentY[index] = extent.y;
+			extentZ[index] = extent.z;
+		}
+	};
+
 	class Frustum
 	{
 	public:
 		enum side { LEFT = 0, RIGHT = 1, TOP = 2, BOTTOM = 3, BACK = 4, FRONT = 5 };
+		/** @brief Code paths for the batched culling functions */
+		enum class CullPath { Scalar, SSE, AVX2 };
 		std::array<glm::vec4, 6> planes;
+		/** @brief Code path used by the batched culling functions, defaults to the fastest one supported by the CPU */
+		CullPath cullPath{ getBestCullPath() };
 
 		void update(glm::mat4 matrix)
 		{
@@ -56,7 +134,7 @@ namespace vks
 				planes[i] /= length;
 			}
 		}
-		
+
 		bool checkSphere(glm::vec3 pos, float radius)
 		{
 			for (auto i = 0; i < planes.size(); i++)
@@ -68,5 +146,190 @@ namespace vks
 			}
 			return true;
 		}
+
+		/**
+		* Cull a batch of bounding spheres against the frustum
+		*
+		* @param spheres Spheres to test
+		* @param visibilityMask Receives one bit per sphere (bit i % 32 of word i / 32), set if the sphere is (partially) inside the frustum
+		*/
+		void cullSpheres(const BoundingSpheres& spheres, std::vector<uint32_t>& visibilityMask) const
+		{
+			cull(spheres.size(), spheres.centerX.data(), spheres.centerY.data(), spheres.centerZ.data(), spheres.radius.data(), nullptr, nullptr, visibilityMask);
+		}
+
+		/**
+		* Cull a batch of axis aligned bounding boxes against the frustum
+		*
+		* @param boxes Boxes to test
+		* @param visibilityMask Receives one bit per box (bit i % 32 of word i / 32), set if the box is (partially) inside the frustum
+		*/
+		void cullBoxes(const BoundingBoxes& boxes, std::vector<uint32_t>& visibilityMask) const
+		{
+			cull(boxes.size(), boxes.centerX.data(), boxes.centerY.data(), boxes.centerZ.data(), boxes.extentX.data(), boxes.extentY.data(), boxes.extentZ.data(), visibilityMask);
+		}
+
+		/**
+		* Convert a visibility mask into a compacted list of visible indices
+		*
+		* @param visibilityMask Mask as written by cullSpheres or cullBoxes
+		* @param count Number of objects the mask was generated for
+		* @param visibleIndices Receives the indices of all visible objects in ascending order
+		*/
+		static void compactVisible(const std::vector<uint32_t>& visibilityMask, size_t count, std::vector<uint32_t>& visibleIndices)
+		{
+			visibleIndices.resize(count);
+			size_t visibleCount = 0;
+			for (size_t word = 0; word < visibilityMask.size(); word++) {
+				uint32_t bits = visibilityMask[word];
+				while (bits != 0) {
+					visibleIndices[visibleCount++] = static_cast<uint32_t>(word * 32 + countTrailingZeros(bits));
+					bits &= bits - 1;
+				}
+			}
+			visibleIndices.resize(visibleCount);
+		}
+
+		/** @brief Returns the fastest batched culling code path supported by the CPU */
+		static CullPath getBestCullPath()
+		{
+#if defined(VKS_FRUSTUM_AVX2)
+			if (cpuSupportsAVX2()) {
+				return CullPath::AVX2;
+			}
+#endif
+#if defined(VKS_FRUSTUM_SSE)
+			return CullPath::SSE;
+#else
+			return CullPath::Scalar;
+#endif
+		}
+
+	private:
+		static uint32_t countTrailingZeros(uint32_t value)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			unsigned long index;
+			_BitScanForward(&index, value);
+			return static_cast<uint32_t>(index);
+#else
+			return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+		}
+
+#if defined(VKS_FRUSTUM_AVX2)
+		static bool cpuSupportsAVX2()
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+			int info[4];
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool fma = (info[2] & (1 << 12)) != 0;
+			if (!osxsave || !fma || ((_xgetbv(0) & 0x6) != 0x6)) {
+				return false;
+			}
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#endif
+		}
+#endif
+
+		// If extentY and extentZ are null, extentX holds sphere radii, otherwise the projected box extent along each plane normal is used as the radius
+		void cull(size_t count, const float* centerX, const float* centerY, const float* centerZ, const float* extentX, const float* extentY, const float* extentZ, std::vector<uint32_t>& visibilityMask) const
+		{
+			visibilityMask.assign((count + 31) / 32, 0);
+			size_t first = 0;
+#if defined(VKS_FRUSTUM_AVX2)
+			if (cullPath == CullPath::AVX2) {
+				first = cullAVX2(count, centerX, centerY, centerZ, extentX, extentY, extentZ, visibilityMask.data());
+			}
+#endif
+#if defined(VKS_FRUSTUM_SSE)
+			if (cullPath == CullPath::SSE) {
+				first = cullSSE(count, centerX, centerY, centerZ, extentX, extentY, extentZ, visibilityMask.data());
+			}
+#endif
+			// Scalar path and remaining objects that don't fill a whole SIMD register
+			for (size_t i = first; i < count; i++) {
+				bool visible = true;
+				for (const glm::vec4& plane : planes) {
+					const float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+					const float radius = extentY ? (extentX[i] * fabsf(plane.x) + extentY[i] * fabsf(plane.y) + extentZ[i] * fabsf(plane.z)) : extentX[i];
+					visible &= (distance > -radius);
+				}
+				visibilityMask[i / 32] |= uint32_t(visible) << (i % 32);
+			}
+		}
+
+#if defined(VKS_FRUSTUM_SSE)
+		size_t cullSSE(size_t count, const float* centerX, const float* centerY, const float* centerZ, const float* extentX, const float* extentY, const float* extentZ, uint32_t* visibilityMask) const
+		{
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			__m128 planeX[6], planeY[6], planeZ[6], planeW[6], planeAbsX[6], planeAbsY[6], planeAbsZ[6];
+			for (size_t p = 0; p < 6; p++) {
+				planeX[p] = _mm_set1_ps(planes[p].x);
+				planeY[p] = _mm_set1_ps(planes[p].y);
+				planeZ[p] = _mm_set1_ps(planes[p].z);
+				planeW[p] = _mm_set1_ps(planes[p].w);
+				planeAbsX[p] = _mm_andnot_ps(signMask, planeX[p]);
+				planeAbsY[p] = _mm_andnot_ps(signMask, planeY[p]);
+				planeAbsZ[p] = _mm_andnot_ps(signMask, planeZ[p]);
+			}
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				const __m128 cx = _mm_loadu_ps(centerX + i);
+				const __m128 cy = _mm_loadu_ps(centerY + i);
+				const __m128 cz = _mm_loadu_ps(centerZ + i);
+				const __m128 ex = _mm_loadu_ps(extentX + i);
+				const __m128 ey = extentY ? _mm_loadu_ps(extentY + i) : _mm_setzero_ps();
+				const __m128 ez = extentZ ? _mm_loadu_ps(extentZ + i) : _mm_setzero_ps();
+				__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (size_t p = 0; p < 6; p++) {
+					__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, planeX[p]), _mm_mul_ps(cy, planeY[p])), _mm_add_ps(_mm_mul_ps(cz, planeZ[p]), planeW[p]));
+					__m128 radius = extentY ? _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, planeAbsX[p]), _mm_mul_ps(ey, planeAbsY[p])), _mm_mul_ps(ez, planeAbsZ[p])) : ex;
+					visible = _mm_and_ps(visible, _mm_cmpgt_ps(distance, _mm_xor_ps(radius, signMask)));
+				}
+				visibilityMask[i / 32] |= uint32_t(_mm_movemask_ps(visible)) << (i % 32);
+			}
+			return i;
+		}
+#endif
+
+#if defined(VKS_FRUSTUM_AVX2)
+		VKS_TARGET_AVX2 size_t cullAVX2(size_t count, const float* centerX, const float* centerY, const float* centerZ, const float* extentX, const float* extentY, const float* extentZ, uint32_t* visibilityMask) const
+		{
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+			__m256 planeX[6], planeY[6], planeZ[6], planeW[6], planeAbsX[6], planeAbsY[6], planeAbsZ[6];
+			for (size_t p = 0; p < 6; p++) {
+				planeX[p] = _mm256_set1_ps(planes[p].x);
+				planeY[p] = _mm256_set1_ps(planes[p].y);
+				planeZ[p] = _mm256_set1_ps(planes[p].z);
+				planeW[p] = _mm256_set1_ps(planes[p].w);
+				planeAbsX[p] = _mm256_andnot_ps(signMask, planeX[p]);
+				planeAbsY[p] = _mm256_andnot_ps(signMask, planeY[p]);
+				planeAbsZ[p] = _mm256_andnot_ps(signMask, planeZ[p]);
+			}
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				const __m256 cx = _mm256_loadu_ps(centerX + i);
+				const __m256 cy = _mm256_loadu_ps(centerY + i);
+				const __m256 cz = _mm256_loadu_ps(centerZ + i);
+				const __m256 ex = _mm256_loadu_ps(extentX + i);
+				const __m256 ey = extentY ? _mm256_loadu_ps(extentY + i) : _mm256_setzero_ps();
+				const __m256 ez = extentZ ? _mm256_loadu_ps(extentZ + i) : _mm256_setzero_ps();
+				__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (size_t p = 0; p < 6; p++) {
+					__m256 distance = _mm256_fmadd_ps(cx, planeX[p], _mm256_fmadd_ps(cy, planeY[p], _mm256_fmadd_ps(cz, planeZ[p], planeW[p])));
+					__m256 radius = extentY ? _mm256_fmadd_ps(ex, planeAbsX[p], _mm256_fmadd_ps(ey, planeAbsY[p], _mm256_mul_ps(ez, planeAbsZ[p]))) : ex;
+					visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, _mm256_xor_ps(radius, signMask), _CMP_GT_OQ));
+				}
+				visibilityMask[i / 32] |= uint32_t(_mm256_movemask_ps(visible)) << (i % 32);
+			}
+			return i;
+		}
+#endif
 	};
 }
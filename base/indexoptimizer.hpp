@@ -0,0 +1,381 @@
+/*
+* Index buffer optimization
+*
+* Triangle reordering for post-transform vertex cache locality (Tipsify), cluster reordering to reduce overdraw
+* and vertex reordering for vertex fetch locality, all working on triangle lists with 32 bit indices
+* See "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Sander, Nehab, Barczak, 2007)
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+
+namespace vks
+{
+	/** @brief Post-transform vertex cache efficiency of an index buffer */
+	struct VertexCacheStatistics
+	{
+		/** @brief Average cache miss ratio: transformed vertices per triangle (0.5 is the optimum for large regular meshes, 3 the worst case) */
+		float acmr{ 0.0f };
+		/** @brief Average transform to vertex ratio: transformed vertices per referenced vertex (1 is the optimum) */
+		float atvr{ 0.0f };
+		uint32_t triangleCount{ 0 };
+		uint32_t vertexCount{ 0 };
+		uint32_t transformedVertices{ 0 };
+	};
+
+	/**
+	* @brief Reorders triangle list indices and vertices for GPU efficiency
+	* @note Indices passed to the functions are relative to the first vertex of the mesh, i.e. in the range [0, vertexCount)
+	*/
+	class IndexOptimizer
+	{
+	private:
+		/** @brief Simulates a FIFO post-transform cache, as used by most hardware */
+		class FifoCache
+		{
+		private:
+			std::vector<uint32_t> timestamps;
+			uint32_t time;
+			uint32_t cacheSize;
+		public:
+			FifoCache(uint32_t vertexCount, uint32_t cacheSize) : timestamps(vertexCount, 0), time(cacheSize + 1), cacheSize(cacheSize) {}
+
+			/** @brief Returns true if the vertex had to be transformed */
+			bool access(uint32_t vertex)
+			{
+				if (time - timestamps[vertex] > cacheSize) {
+					timestamps[vertex] = time++;
+					return true;
+				}
+				return false;
+			}
+
+			/** @brief Evict all vertices */
+			void flush()
+			{
+				time += cacheSize + 1;
+			}
+		};
+
+		struct Adjacency
+		{
+			std::vector<uint32_t> offsets;
+			std::vector<uint32_t> triangles;
+			std::vector<uint32_t> liveCount;
+
+			Adjacency(const uint32_t* indices, size_t indexCount, uint32_t vertexCount) : offsets(vertexCount + 1, 0), triangles(indexCount), liveCount(vertexCount, 0)
+			{
+				for (size_t i = 0; i < indexCount; i++) {
+					liveCount[indices[i]]++;
+				}
+				for (uint32_t v = 0; v < vertexCount; v++) {
+					offsets[v + 1] = offsets[v] + liveCount[v];
+				}
+				std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+				for (size_t i = 0; i < indexCount; i++) {
+					triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+				}
+			}
+		};
+
+		static bool validIndices(const uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+		{
+			return (indexCount % 3 == 0) && std::all_of(indices, indices + indexCount, [vertexCount](uint32_t index) { return index < vertexCount; });
+		}
+
+	public:
+		/** @brief Cache size used for the simulation and optimization, a conservative estimate for current hardware */
+		static constexpr uint32_t defaultCacheSize = 16;
+
+		/**
+		* Measure the post-transform vertex cache efficiency of an index buffer
+		*
+		* @param indices Triangle list indices
+		* @param indexCount Number of indices
+		* @param vertexCount Number of vertices the indices refer to
+		* @param cacheSize Number of entries of the simulated FIFO cache
+		*/
+		static VertexCacheStatistics analyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = defaultCacheSize)
+		{
+			VertexCacheStatistics statistics{};
+			if (!validIndices(indices, indexCount, vertexCount) || (indexCount == 0)) {
+				return statistics;
+			}
+			FifoCache cache(vertexCount, cacheSize);
+			std::vector<bool> referenced(vertexCount, false);
+			for (size_t i = 0; i < indexCount; i++) {
+				statistics.transformedVertices += cache.access(indices[i]) ? 1 : 0;
+				if (!referenced[indices[i]]) {
+					referenced[indices[i]] = true;
+					statistics.vertexCount++;
+				}
+			}
+			statistics.triangleCount = static_cast<uint32_t>(indexCount / 3);
+			statistics.acmr = static_cast<float>(statistics.transformedVertices) / statistics.triangleCount;
+			statistics.atvr = static_cast<float>(statistics.transformedVertices) / statistics.vertexCount;
+			return statistics;
+		}
+
+		/**
+		* Reorder the triangles for post-transform vertex cache locality (Tipsify)
+		*
+		* @param indices Triangle list indices, reordered in place
+		* @param indexCount Number of indices
+		* @param vertexCount Number of vertices the indices refer to
+		* @param cacheSize Number of entries of the cache that's optimized for
+		* @param clusters (Optional) Receives the index of the first triangle of every cluster, clusters start where the algorithm had to restart at a dead end
+		*/
+		static void optimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = defaultCacheSize, std::vector<uint32_t>* clusters = nullptr)
+		{
+			if (clusters) {
+				clusters->clear();
+			}
+			if (!validIndices(indices, indexCount, vertexCount) || (indexCount == 0)) {
+				return;
+			}
+			const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+			Adjacency adjacency(indices, indexCount, vertexCount);
+			std::vector<uint32_t>& liveCount = adjacency.liveCount;
+			std::vector<uint32_t> timestamps(vertexCount, 0);
+			std::vector<bool> emitted(triangleCount, false);
+			std::vector<uint32_t> deadEnds;
+			std::vector<uint32_t> candidates;
+			std::vector<uint32_t> result;
+			result.reserve(indexCount);
+
+			uint32_t time = cacheSize + 1;
+			uint32_t cursor = 0;
+			// Start with the first vertex of the first triangle
+			int64_t fanningVertex = indices[0];
+			bool restarted = true;
+			while (fanningVertex >= 0) {
+				const uint32_t f = static_cast<uint32_t>(fanningVertex);
+				candidates.clear();
+				// Emit all remaining triangles of the fanning vertex
+				for (uint32_t a = adjacency.offsets[f]; a < adjacency.offsets[f + 1]; a++) {
+					const uint32_t triangle = adjacency.triangles[a];
+					if (emitted[triangle]) {
+						continue;
+					}
+					if (restarted && clusters) {
+						clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+					}
+					restarted = false;
+					for (uint32_t c = 0; c < 3; c++) {
+						const uint32_t v = indices[triangle * 3 + c];
+						result.push_back(v);
+						deadEnds.push_back(v);
+						candidates.push_back(v);
+						liveCount[v]--;
+						if (time - timestamps[v] > cacheSize) {
+							timestamps[v] = time++;
+						}
+					}
+					emitted[triangle] = true;
+				}
+
+				// Select the next fanning vertex from the candidates: prefer vertices that will still be in the cache after emitting their triangles, and the oldest of those
+				fanningVertex = -1;
+				int64_t bestPriority = -1;
+				for (uint32_t v : candidates) {
+					if (liveCount[v] == 0) {
+						continue;
+					}
+					int64_t priority = 0;
+					if (time - timestamps[v] + 2 * liveCount[v] <= cacheSize) {
+						priority = time - timestamps[v];
+					}
+					if (priority > bestPriority) {
+						bestPriority = priority;
+						fanningVertex = v;
+					}
+				}
+
+				// Dead end, continue with a recently used vertex or the next vertex in input order
+				if (fanningVertex < 0) {
+					restarted = true;
+					while (!deadEnds.empty()) {
+						const uint32_t v = deadEnds.back();
+						deadEnds.pop_back();
+						if (liveCount[v] > 0) {
+							fanningVertex = v;
+							break;
+						}
+					}
+					if (fanningVertex < 0) {
+						while (cursor < vertexCount) {
+							if (liveCount[cursor] > 0) {
+								fanningVertex = cursor;
+								break;
+							}
+							cursor++;
+						}
+					}
+				}
+			}
+			memcpy(indices, result.data(), indexCount * sizeof(uint32_t));
+		}
+
+		/**
+		* Reorder clusters of triangles so that triangles likely to occlude others are drawn first, should be called after optimizeVertexCache
+		* Clusters facing away from the center of the mesh are moved to the front, cluster boundaries are chosen so the vertex cache efficiency stays within the threshold
+		*
+		* @param indices Triangle list indices, reordered in place
+		* @param indexCount Number of indices
+		* @param positions Pointer to the first vertex position (three floats)
+		* @param positionStride Distance between two vertex positions in bytes
+		* @param vertexCount Number of vertices the indices refer to
+		* @param clusters Index of the first triangle of every hard cluster as returned by optimizeVertexCache (empty = every triangle can start a cluster)
+		* @param threshold Maximum allowed increase of the ACMR (e.g. 1.05 = 5 percent)
+		* @param cacheSize Number of entries of the cache that's optimized for
+		*/
+		static void optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, uint32_t vertexCount, const std::vector<uint32_t>& clusters, float threshold = 1.05f, uint32_t cacheSize = defaultCacheSize)
+		{
+			if (!validIndices(indices, indexCount, vertexCount) || (indexCount == 0)) {
+				return;
+			}
+			const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+			auto position = [positions, positionStride](uint32_t vertex) {
+				return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+			};
+
+			// Soft cluster boundaries: split a hard cluster wherever the ACMR of the part so far stays within the threshold of the overall ACMR
+			const float acmr = analyzeVertexCache(indices, indexCount, vertexCount, cacheSize).acmr;
+			std::vector<bool> hardBoundary(triangleCount + 1, clusters.empty());
+			for (uint32_t cluster : clusters) {
+				if (cluster < triangleCount) {
+					hardBoundary[cluster] = true;
+				}
+			}
+			std::vector<uint32_t> boundaries;
+			{
+				FifoCache cache(vertexCount, cacheSize);
+				uint32_t clusterStart = 0;
+				uint32_t clusterMisses = 0;
+				for (uint32_t t = 0; t < triangleCount; t++) {
+					if (hardBoundary[t]) {
+						// A hard boundary is a cache restart, simulate it to keep the clusters independent of the order they end up in
+						cache.flush();
+						if ((t == 0) || (static_cast<float>(clusterMisses) / (t - clusterStart) <= acmr * threshold)) {
+							boundaries.push_back(t);
+							clusterStart = t;
+							clusterMisses = 0;
+						}
+					}
+					for (uint32_t c = 0; c < 3; c++) {
+						clusterMisses += cache.access(indices[t * 3 + c]) ? 1 : 0;
+					}
+				}
+			}
+			boundaries.push_back(triangleCount);
+			const size_t clusterCount = boundaries.size() - 1;
+			if (clusterCount < 2) {
+				return;
+			}
+
+			// Center of the bounds of the mesh
+			float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (size_t i = 0; i < indexCount; i++) {
+				const float* p = position(indices[i]);
+				for (uint32_t c = 0; c < 3; c++) {
+					boundsMin[c] = std::min(boundsMin[c], p[c]);
+					boundsMax[c] = std::max(boundsMax[c], p[c]);
+				}
+			}
+			const float center[3] = { (boundsMin[0] + boundsMax[0]) * 0.5f, (boundsMin[1] + boundsMax[1]) * 0.5f, (boundsMin[2] + boundsMax[2]) * 0.5f };
+
+			// Sort key of a cluster: area weighted normal dotted with the direction from the mesh center to the area weighted cluster centroid
+			std::vector<float> sortKeys(clusterCount);
+			for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+				float normal[3] = { 0.0f, 0.0f, 0.0f };
+				float centroid[3] = { 0.0f, 0.0f, 0.0f };
+				float area = 0.0f;
+				for (uint32_t t = boundaries[cluster]; t < boundaries[cluster + 1]; t++) {
+					const float* p0 = position(indices[t * 3 + 0]);
+					const float* p1 = position(indices[t * 3 + 1]);
+					const float* p2 = position(indices[t * 3 + 2]);
+					const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+					const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+					const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+					const float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+					for (uint32_t c = 0; c < 3; c++) {
+						normal[c] += n[c];
+						centroid[c] += (p0[c] + p1[c] + p2[c]) / 3.0f * triangleArea;
+					}
+					area += triangleArea;
+				}
+				if (area > 0.0f) {
+					for (uint32_t c = 0; c < 3; c++) {
+						centroid[c] /= area;
+					}
+				}
+				sortKeys[cluster] = (centroid[0] - center[0]) * normal[0] + (centroid[1] - center[1]) * normal[1] + (centroid[2] - center[2]) * normal[2];
+			}
+
+			std::vector<uint32_t> order(clusterCount);
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+			std::vector<uint32_t> result;
+			result.reserve(indexCount);
+			for (uint32_t cluster : order) {
+				result.insert(result.end(), indices + boundaries[cluster] * 3, indices + boundaries[cluster + 1] * 3);
+			}
+			memcpy(indices, result.data(), indexCount * sizeof(uint32_t));
+		}
+
+		/**
+		* Compute a vertex order for vertex fetch locality: vertices are numbered in the order they are first referenced, unreferenced vertices are moved to the end
+		*
+		* @param indices Triangle list indices, rewritten to the new vertex order
+		* @param indexCount Number of indices
+		* @param vertexCount Number of vertices the indices refer to
+		*
+		* @return Remap table, new location of every vertex (empty if the indices are invalid)
+		*/
+		static std::vector<uint32_t> optimizeVertexFetch(uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+		{
+			if (!validIndices(indices, indexCount, vertexCount)) {
+				return {};
+			}
+			constexpr uint32_t unassigned = ~0u;
+			std::vector<uint32_t> remap(vertexCount, unassigned);
+			uint32_t next = 0;
+			for (size_t i = 0; i < indexCount; i++) {
+				if (remap[indices[i]] == unassigned) {
+					remap[indices[i]] = next++;
+				}
+				indices[i] = remap[indices[i]];
+			}
+			for (uint32_t& target : remap) {
+				if (target == unassigned) {
+					target = next++;
+				}
+			}
+			return remap;
+		}
+
+		/** @brief Move elements to the locations given by a remap table returned from optimizeVertexFetch */
+		template<typename T>
+		static void remapVertices(T* vertices, const std::vector<uint32_t>& remap)
+		{
+			std::vector<T> source(vertices, vertices + remap.size());
+			for (size_t i = 0; i < remap.size(); i++) {
+				vertices[remap[i]] = source[i];
+			}
+		}
+	};
+}
@@ -0,0 +1,458 @@
+/*
+* Work stealing job system
+*
+* Every worker owns a lock-free deque (Chase-Lev) it pushes to and pops from, idle workers steal from the other end of the other workers' deques
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "profiler.hpp"
+
+namespace vks
+{
+	/** @brief Counts the outstanding jobs of a group, pass it to JobSystem::wait to wait for all jobs started with it */
+	class JobCounter
+	{
+		friend class JobSystem;
+	private:
+		std::atomic<uint32_t> pending{ 0 };
+	public:
+		bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	/** @brief Type erased job, small callables are stored inline so scheduling a job doesn't allocate */
+	struct Job
+	{
+		static constexpr size_t inlineSize = 64;
+		alignas(std::max_align_t) unsigned char storage[inlineSize];
+		void* callable{ nullptr };
+		void (*invokeFunc)(void*) { nullptr };
+		void (*destroyFunc)(void*) { nullptr };
+		JobCounter* counter{ nullptr };
+
+		template<typename F>
+		void set(F&& func)
+		{
+			using T = std::decay_t<F>;
+			if constexpr (sizeof(T) <= inlineSize && alignof(T) <= alignof(std::max_align_t)) {
+				callable = new (storage) T(std::forward<F>(func));
+				destroyFunc = [](void* p) { static_cast<T*>(p)->~T(); };
+			} else {
+				callable = new T(std::forward<F>(func));
+				destroyFunc = [](void* p) { delete static_cast<T*>(p); };
+			}
+			invokeFunc = [](void* p) { (*static_cast<T*>(p))(); };
+		}
+
+		void execute()
+		{
+			invokeFunc(callable);
+			destroyFunc(callable);
+			callable = nullptr;
+		}
+	};
+
+	/**
+	* @brief Fixed size lock-free work stealing deque
+	* @note push and pop may only be called by the owning thread, steal may be called from any thread
+	*/
+	class WorkStealingQueue
+	{
+	private:
+		static constexpr int64_t capacity = 4096;
+		static constexpr int64_t mask = capacity - 1;
+		alignas(64) std::atomic<int64_t> top{ 0 };
+		alignas(64) std::atomic<int64_t> bottom{ 0 };
+		std::atomic<Job*> buffer[capacity];
+	public:
+		/** @brief Returns false if the queue is full */
+		bool push(Job* job)
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed);
+			const int64_t t = top.load(std::memory_order_acquire);
+			if (b - t >= capacity) {
+				return false;
+			}
+			buffer[b & mask].store(job, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_release);
+			return true;
+		}
+
+		Job* pop()
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+			Job* job = nullptr;
+			if (t <= b) {
+				job = buffer[b & mask].load(std::memory_order_relaxed);
+				if (t == b) {
+					// Last job, race against thieves
+					if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+						job = nullptr;
+					}
+					bottom.store(b + 1, std::memory_order_relaxed);
+				}
+			} else {
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+
+		Job* steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t b = bottom.load(std::memory_order_acquire);
+			if (t < b) {
+				Job* job = buffer[t & mask].load(std::memory_order_relaxed);
+				if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					return job;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	/**
+	* @brief Work stealing job scheduler with one worker per hardware thread
+	* @note The thread that creates the job system is worker 0 and executes jobs while it waits
+	*/
+	class JobSystem
+	{
+	private:
+		struct Worker
+		{
+			WorkStealingQueue queue;
+			std::thread thread;
+		};
+		/** @brief Job objects are recycled through a per-thread cache, so after warm up no allocations happen */
+		struct JobCache
+		{
+			static constexpr size_t maxSize = 4096;
+			std::vector<Job*> jobs;
+			~JobCache()
+			{
+				for (Job* job : jobs) {
+					delete job;
+				}
+			}
+		};
+		static inline thread_local JobSystem* currentSystem{ nullptr };
+		static inline thread_local uint32_t currentIndex{ 0 };
+
+		std::vector<std::unique_ptr<Worker>> workers;
+		/** @brief Jobs scheduled from threads that aren't workers or that didn't fit into a worker's queue */
+		std::deque<Job*> globalQueue;
+		std::mutex globalQueueMutex;
+		std::atomic<bool> globalQueueEmpty{ true };
+		/** @brief Number of jobs that have been scheduled but not yet picked up, sleeping workers wait for this to become non-zero */
+		std::atomic<int64_t> queuedJobs{ 0 };
+		std::atomic<uint32_t> sleepingWorkers{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+		std::atomic<bool> stopping{ false };
+		/** @brief Job system the creating thread belonged to before, restored on destruction so job systems can be nested (e.g. for loading assets) */
+		JobSystem* previousSystem{ nullptr };
+		uint32_t previousIndex{ 0 };
+
+		static JobCache& jobCache()
+		{
+			static thread_local JobCache cache;
+			return cache;
+		}
+
+		static Job* allocateJob()
+		{
+			JobCache& cache = jobCache();
+			if (cache.jobs.empty()) {
+				return new Job();
+			}
+			Job* job = cache.jobs.back();
+			cache.jobs.pop_back();
+			return job;
+		}
+
+		static void releaseJob(Job* job)
+		{
+			JobCache& cache = jobCache();
+			if (cache.jobs.size() < JobCache::maxSize) {
+				cache.jobs.push_back(job);
+			} else {
+				delete job;
+			}
+		}
+
+		void enqueue(Job* job)
+		{
+			if ((currentSystem != this) || !workers[currentIndex]->queue.push(job)) {
+				std::lock_guard<std::mutex> lock(globalQueueMutex);
+				globalQueue.push_back(job);
+				globalQueueEmpty.store(false, std::memory_order_relaxed);
+			}
+			queuedJobs.fetch_add(1);
+		}
+
+		void wakeWorkers(bool all)
+		{
+			if (sleepingWorkers.load() > 0) {
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				if (all) {
+					sleepCondition.notify_all();
+				} else {
+					sleepCondition.notify_one();
+				}
+			}
+		}
+
+		Job* findJob()
+		{
+			Job* job = nullptr;
+			const bool isWorker = (currentSystem == this);
+			if (isWorker) {
+				job = workers[currentIndex]->queue.pop();
+			}
+			if (!job && !globalQueueEmpty.load(std::memory_order_relaxed)) {
+				std::lock_guard<std::mutex> lock(globalQueueMutex);
+				if (!globalQueue.empty()) {
+					job = globalQueue.front();
+					globalQueue.pop_front();
+					globalQueueEmpty.store(globalQueue.empty(), std::memory_order_relaxed);
+				}
+			}
+			if (!job) {
+				// Steal from the other workers, starting at the next one to spread out thieves
+				const size_t count = workers.size();
+				const size_t start = isWorker ? currentIndex + 1 : 0;
+				for (size_t i = 0; i < count && !job; i++) {
+					const size_t victim = (start + i) % count;
+					if (isWorker && victim == currentIndex) {
+						continue;
+					}
+					job = workers[victim]->queue.steal();
+				}
+			}
+			if (job) {
+				queuedJobs.fetch_sub(1);
+			}
+			return job;
+		}
+
+		void execute(Job* job)
+		{
+			JobCounter* counter = job->counter;
+			{
+				VKS_PROFILE_ZONE("Job");
+				job->execute();
+			}
+			releaseJob(job);
+			if (counter) {
+				counter->pending.fetch_sub(1, std::memory_order_release);
+			}
+		}
+
+		void workerLoop(uint32_t index)
+		{
+			currentSystem = this;
+			currentIndex = index;
+			VKS_PROFILE_THREAD("Job worker " + std::to_string(index));
+			while (!stopping.load(std::memory_order_relaxed)) {
+				Job* job = findJob();
+				if (job) {
+					execute(job);
+					continue;
+				}
+				// Nothing to do, go to sleep until new jobs are scheduled
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				sleepingWorkers.fetch_add(1);
+				sleepCondition.wait(lock, [this] { return queuedJobs.load() > 0 || stopping.load(); });
+				sleepingWorkers.fetch_sub(1);
+			}
+			currentSystem = nullptr;
+		}
+
+	public:
+		/** @brief Returned by currentWorkerIndex for threads that aren't part of the job system */
+		static constexpr uint32_t invalidWorkerIndex = ~0u;
+
+		JobSystem() = default;
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		~JobSystem()
+		{
+			destroy();
+		}
+
+		/**
+		* Create the worker threads, the calling thread becomes worker 0
+		*
+		* @param workerCount Total number of workers including the calling thread (defaults to the number of hardware threads)
+		*/
+		void create(uint32_t workerCount = 0)
+		{
+			destroy();
+			if (workerCount == 0) {
+				workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+			}
+			stopping = false;
+			for (uint32_t i = 0; i < workerCount; i++) {
+				workers.push_back(std::make_unique<Worker>());
+			}
+			previousSystem = currentSystem;
+			previousIndex = currentIndex;
+			currentSystem = this;
+			currentIndex = 0;
+			for (uint32_t i = 1; i < workerCount; i++) {
+				workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+			}
+		}
+
+		/** @brief Finish all outstanding jobs and join the worker threads */
+		void destroy()
+		{
+			if (workers.empty()) {
+				return;
+			}
+			waitIdle();
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				stopping = true;
+				sleepCondition.notify_all();
+			}
+			for (auto& worker : workers) {
+				if (worker->thread.joinable()) {
+					worker->thread.join();
+				}
+			}
+			workers.clear();
+			if (currentSystem == this) {
+				currentSystem = previousSystem;
+				currentIndex = previousIndex;
+			}
+		}
+
+		/** @brief Number of workers including the thread that created the job system */
+		uint32_t workerCount() const
+		{
+			return static_cast<uint32_t>(workers.size());
+		}
+
+		/** @brief Index of the worker executing the calling code, can be used to select per-worker resources like command pools */
+		uint32_t currentWorkerIndex() const
+		{
+			return (currentSystem == this) ? currentIndex : invalidWorkerIndex;
+		}
+
+		/** @brief Schedule a job that is waited for by waiting on the given counter */
+		template<typename F>
+		void run(JobCounter& counter, F&& func)
+		{
+			Job* job = allocateJob();
+			job->set(std::forward<F>(func));
+			job->counter = &counter;
+			counter.pending.fetch_add(1, std::memory_order_relaxed);
+			enqueue(job);
+			wakeWorkers(false);
+		}
+
+		/** @brief Schedule a job that is only waited for by waitIdle */
+		template<typename F>
+		void run(F&& func)
+		{
+			Job* job = allocateJob();
+			job->set(std::forward<F>(func));
+			job->counter = nullptr;
+			enqueue(job);
+			wakeWorkers(false);
+		}
+
+		/** @brief Wait for all jobs started with the counter, the calling thread executes other jobs in the meantime */
+		void wait(const JobCounter& counter)
+		{
+			while (!counter.done()) {
+				if (Job* job = findJob()) {
+					execute(job);
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		/** @brief Wait until no more jobs are queued (jobs already picked up by other workers may still be running) */
+		void waitIdle()
+		{
+			while (queuedJobs.load() > 0) {
+				if (Job* job = findJob()) {
+					execute(job);
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		/**
+		* Call func(index) for every index in [0, count) and wait for all calls to finish
+		*
+		* @param count Number of indices
+		* @param func Function that's called for each index, may be called concurrently from multiple workers
+		* @param grainSize Number of indices processed by a single job (defaults to enough chunks to balance the load over all workers)
+		*/
+		template<typename F>
+		void parallelFor(uint32_t count, F&& func, uint32_t grainSize = 0)
+		{
+			if (count == 0) {
+				return;
+			}
+			if (grainSize == 0) {
+				// A few chunks per worker leaves room for stealing if some indices are more expensive than others
+				grainSize = std::max(count / (workerCount() * 4), 1u);
+			}
+			if (workers.empty() || grainSize >= count) {
+				for (uint32_t i = 0; i < count; i++) {
+					func(i);
+				}
+				return;
+			}
+			JobCounter counter;
+			auto& f = func;
+			// The calling thread processes the first chunk itself
+			for (uint32_t begin = grainSize; begin < count; begin += grainSize) {
+				const uint32_t end = std::min(begin + grainSize, count);
+				Job* job = allocateJob();
+				job->set([&f, begin, end]() {
+					for (uint32_t i = begin; i < end; i++) {
+						f(i);
+					}
+				});
+				job->counter = &counter;
+				counter.pending.fetch_add(1, std::memory_order_relaxed);
+				enqueue(job);
+			}
+			wakeWorkers(true);
+			for (uint32_t i = 0; i < grainSize; i++) {
+				f(i);
+			}
+			wait(counter);
+		}
+	};
+}
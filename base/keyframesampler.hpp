@@ -0,0 +1,119 @@
+/*
+* Keyframe sampling for animation channels
+*
+* Finds the keyframe interval for a time with a cursor that's carried over between evaluations, so playback only checks the cached
+* and the following interval in the common case and falls back to a binary search when the time jumps (seeking, looping)
+* Supports linear, step and cubic spline (Hermite, as defined by glTF 2.0) interpolation of vec4 values and quaternions
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace vks
+{
+	class KeyframeSampler
+	{
+	private:
+		static glm::quat toQuat(const glm::vec4& v)
+		{
+			return glm::quat(v.w, v.x, v.y, v.z);
+		}
+
+		static glm::vec4 toVec4(const glm::quat& q)
+		{
+			return glm::vec4(q.x, q.y, q.z, q.w);
+		}
+
+	public:
+		enum class Interpolation { Linear, Step, CubicSpline };
+
+		/**
+		* Find the keyframe interval [times[i], times[i + 1]] that contains the time
+		*
+		* @param times Ascending keyframe times
+		* @param count Number of keyframes
+		* @param time Time to look up, clamped to the range of the keyframes
+		* @param cursor Interval found by the previous lookup, updated with the result
+		*
+		* @return Index of the first keyframe of the interval (0 if there are less than two keyframes)
+		*/
+		static uint32_t findInterval(const float* times, uint32_t count, float time, uint32_t& cursor)
+		{
+			if (count < 2 || time <= times[0]) {
+				cursor = 0;
+				return 0;
+			}
+			if (time >= times[count - 1]) {
+				cursor = count - 2;
+				return cursor;
+			}
+			// Temporal coherence: time is usually in the same or the next interval as in the previous evaluation
+			if (cursor < count - 1 && times[cursor] <= time) {
+				if (time < times[cursor + 1]) {
+					return cursor;
+				}
+				if (cursor + 2 < count && time < times[cursor + 2]) {
+					return ++cursor;
+				}
+			}
+			cursor = static_cast<uint32_t>(std::upper_bound(times, times + count, time) - times) - 1;
+			return cursor;
+		}
+
+		/**
+		* Sample a channel at the given time
+		*
+		* @param interpolation Interpolation mode of the channel
+		* @param times Ascending keyframe times
+		* @param values Keyframe values, for cubic splines three values per keyframe (in-tangent, value, out-tangent)
+		* @param count Number of keyframes
+		* @param time Time to sample, clamped to the range of the keyframes
+		* @param cursor Keyframe cursor of the channel (see findInterval)
+		* @param rotation Values are quaternions stored as (x, y, z, w), interpolated spherically and normalized
+		*/
+		static glm::vec4 sample(Interpolation interpolation, const float* times, const glm::vec4* values, uint32_t count, float time, uint32_t& cursor, bool rotation)
+		{
+			const uint32_t stride = (interpolation == Interpolation::CubicSpline) ? 3 : 1;
+			const uint32_t valueOffset = (interpolation == Interpolation::CubicSpline) ? 1 : 0;
+			const uint32_t i = findInterval(times, count, time, cursor);
+			if (count < 2 || time <= times[0]) {
+				return values[valueOffset];
+			}
+			if (time >= times[count - 1]) {
+				return values[(count - 1) * stride + valueOffset];
+			}
+
+			const float dt = times[i + 1] - times[i];
+			const float t = (dt > 0.0f) ? std::clamp((time - times[i]) / dt, 0.0f, 1.0f) : 0.0f;
+
+			switch (interpolation) {
+			case Interpolation::Step:
+				return values[i];
+			case Interpolation::CubicSpline: {
+				const glm::vec4& v0 = values[i * 3 + 1];
+				const glm::vec4& b0 = values[i * 3 + 2];
+				const glm::vec4& a1 = values[(i + 1) * 3];
+				const glm::vec4& v1 = values[(i + 1) * 3 + 1];
+				const float t2 = t * t;
+				const float t3 = t2 * t;
+				const glm::vec4 result = (2.0f * t3 - 3.0f * t2 + 1.0f) * v0 + dt * (t3 - 2.0f * t2 + t) * b0 + (-2.0f * t3 + 3.0f * t2) * v1 + dt * (t3 - t2) * a1;
+				return rotation ? toVec4(glm::normalize(toQuat(result))) : result;
+			}
+			default:
+				if (rotation) {
+					return toVec4(glm::normalize(glm::slerp(toQuat(values[i]), toQuat(values[i + 1]), t)));
+				}
+				return glm::mix(values[i], values[i + 1], t);
+			}
+		}
+	};
+}
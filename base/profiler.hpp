@@ -0,0 +1,200 @@
+/*
+* CPU profiler
+*
+* Records scoped zones into per-thread ring buffers and exports them in the Chrome trace event format (chrome://tracing, Perfetto)
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <cstdint>
+
+namespace vks
+{
+	/**
+	* @brief Low overhead CPU profiler for scoped zones, every thread records into its own ring buffer without locking
+	* @note Zone names are stored as pointers, so they need to be string literals (or otherwise outlive the profiler)
+	*/
+	class Profiler
+	{
+	public:
+		/** @brief Begin and end of a zone in ns since the profiler was created */
+		struct Zone
+		{
+			const char* name{ nullptr };
+			int64_t begin{ 0 };
+			int64_t end{ 0 };
+		};
+		/** @brief Number of zones kept per thread, older zones are overwritten once the ring buffer is full */
+		static constexpr uint64_t zonesPerThread = 65536;
+	private:
+		struct ThreadBuffer
+		{
+			std::vector<Zone> zones;
+			/** @brief Total number of zones recorded by the thread, published with release semantics after a zone has been written */
+			std::atomic<uint64_t> count{ 0 };
+			uint32_t threadId{ 0 };
+			std::string threadName;
+		};
+		std::atomic<bool> enabled{ false };
+		std::chrono::steady_clock::time_point startTime{ std::chrono::steady_clock::now() };
+		std::mutex mutex;
+		// Buffers are kept after their thread has finished, so zones of e.g. destroyed worker threads still end up in the trace
+		std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+		ThreadBuffer* getThreadBuffer()
+		{
+			static thread_local ThreadBuffer* threadBuffer{ nullptr };
+			if (!threadBuffer) {
+				std::lock_guard<std::mutex> lock(mutex);
+				threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+				threadBuffer = threadBuffers.back().get();
+				threadBuffer->threadId = static_cast<uint32_t>(threadBuffers.size() - 1);
+				threadBuffer->threadName = "Thread " + std::to_string(threadBuffer->threadId);
+			}
+			return threadBuffer;
+		}
+
+		static std::string escapeJson(const std::string& value)
+		{
+			std::string escaped;
+			for (const char c : value) {
+				if (c == '"' || c == '\\') {
+					escaped += '\\';
+				}
+				escaped += c;
+			}
+			return escaped;
+		}
+
+		Profiler() = default;
+	public:
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		static Profiler& get()
+		{
+			static Profiler profiler;
+			return profiler;
+		}
+
+		/** @brief Zones are only recorded while the profiler is enabled */
+		void setEnabled(bool enable)
+		{
+			enabled.store(enable, std::memory_order_relaxed);
+		}
+
+		bool isEnabled() const
+		{
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		/** @brief Current time in ns since the profiler was created */
+		int64_t now() const
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+		}
+
+		/** @brief Name the calling thread in the exported trace */
+		void setThreadName(const std::string& name)
+		{
+			ThreadBuffer* threadBuffer = getThreadBuffer();
+			std::lock_guard<std::mutex> lock(mutex);
+			threadBuffer->threadName = name;
+		}
+
+		void addZone(const char* name, int64_t begin, int64_t end)
+		{
+			ThreadBuffer* threadBuffer = getThreadBuffer();
+			if (threadBuffer->zones.empty()) {
+				threadBuffer->zones.resize(zonesPerThread);
+			}
+			const uint64_t index = threadBuffer->count.load(std::memory_order_relaxed);
+			threadBuffer->zones[index % zonesPerThread] = { name, begin, end };
+			threadBuffer->count.store(index + 1, std::memory_order_release);
+		}
+
+		/**
+		* Write all recorded zones as a Chrome trace event JSON file
+		* @note Threads should not record zones while the trace is saved, as their oldest zones might get overwritten during the export
+		*
+		* @param filename Name of the JSON file to write to
+		* @return True if the trace has been written
+		*/
+		bool saveTrace(const std::string& filename)
+		{
+			std::ofstream trace(filename, std::ios::out);
+			if (!trace.is_open()) {
+				std::cerr << "Could not write trace to " << filename << "\n";
+				return false;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			trace << std::fixed << std::setprecision(3);
+			trace << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			bool first = true;
+			uint64_t zoneCount = 0;
+			for (auto& threadBuffer : threadBuffers) {
+				trace << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threadBuffer->threadId << ",\"args\":{\"name\":\"" << escapeJson(threadBuffer->threadName) << "\"}}";
+				first = false;
+				const uint64_t count = threadBuffer->count.load(std::memory_order_acquire);
+				const uint64_t firstZone = (count > zonesPerThread) ? count - zonesPerThread : 0;
+				for (uint64_t i = firstZone; i < count; i++) {
+					const Zone& zone = threadBuffer->zones[i % zonesPerThread];
+					// Complete events, timestamps and durations are in microseconds
+					trace << ",\n{\"name\":\"" << escapeJson(zone.name) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << threadBuffer->threadId << ",\"ts\":" << zone.begin / 1000.0 << ",\"dur\":" << (zone.end - zone.begin) / 1000.0 << "}";
+				}
+				zoneCount += count - firstZone;
+			}
+			trace << "\n]}\n";
+			std::cout << "Trace: " << zoneCount << " zones of " << threadBuffers.size() << " threads written to \"" << filename << "\"\n";
+			return true;
+		}
+	};
+
+	/** @brief Records the lifetime of the enclosing scope as a zone, use the VKS_PROFILE_ZONE macro */
+	class ProfileZone
+	{
+	private:
+		const char* name;
+		int64_t begin{ -1 };
+	public:
+		explicit ProfileZone(const char* name) : name(name)
+		{
+			if (Profiler::get().isEnabled()) {
+				begin = Profiler::get().now();
+			}
+		}
+		~ProfileZone()
+		{
+			if (begin >= 0) {
+				Profiler::get().addZone(name, begin, Profiler::get().now());
+			}
+		}
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+	};
+}
+
+#define VKS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VKS_PROFILE_CONCAT(a, b) VKS_PROFILE_CONCAT_IMPL(a, b)
+#if defined(VKS_PROFILER_DISABLED)
+#define VKS_PROFILE_ZONE(name)
+#define VKS_PROFILE_THREAD(name)
+#else
+/** @brief Profile the current scope under the given name (must be a string literal) */
+#define VKS_PROFILE_ZONE(name) vks::ProfileZone VKS_PROFILE_CONCAT(profileZone, __LINE__)(name)
+/** @brief Name the calling thread in the exported trace, does nothing (not even evaluate the name) while the profiler is disabled */
+#define VKS_PROFILE_THREAD(name) do { if (vks::Profiler::get().isEnabled()) { vks::Profiler::get().setThreadName(name); } } while (0)
+#endif
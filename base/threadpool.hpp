@@ -1,6 +1,8 @@
 /*
 * Basic C++11 based thread pool with per-thread job queues
 *
+* Superseded by the work stealing job system (jobsystem.hpp), only kept for comparison in the multithreading sample
+*
 * Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
 *
 * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
@@ -0,0 +1,174 @@
+/*
+* Flattened transform hierarchy
+*
+* Node transforms are stored as structure of arrays with every parent stored before its children,
+* so world matrices can be updated with a single linear pass instead of walking the parent chain per node
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace vks
+{
+	class TransformHierarchy
+	{
+	private:
+		// Local transform changed since the last update
+		std::vector<uint8_t> dirty;
+		// World matrix has been recomputed by the last update
+		std::vector<uint8_t> changed;
+		std::vector<uint32_t> dirtyNodes;
+		std::vector<uint8_t> hasBaseMatrix;
+
+		void markDirty(uint32_t index)
+		{
+			if (!dirty[index]) {
+				dirty[index] = 1;
+				dirtyNodes.push_back(index);
+			}
+		}
+
+	public:
+		/** @brief Parent index of root nodes */
+		static constexpr uint32_t noParent = ~0u;
+
+		std::vector<uint32_t> parents;
+		std::vector<glm::vec3> translations;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::vec3> scales;
+		/** @brief Static part of the local transform applied after translation, rotation and scale (e.g. a glTF node matrix) */
+		std::vector<glm::mat4> baseMatrices;
+		std::vector<glm::mat4> localMatrices;
+		std::vector<glm::mat4> worldMatrices;
+
+		size_t size() const
+		{
+			return parents.size();
+		}
+
+		void clear()
+		{
+			dirty.clear();
+			changed.clear();
+			dirtyNodes.clear();
+			hasBaseMatrix.clear();
+			parents.clear();
+			translations.clear();
+			rotations.clear();
+			scales.clear();
+			baseMatrices.clear();
+			localMatrices.clear();
+			worldMatrices.clear();
+		}
+
+		void reserve(size_t count)
+		{
+			dirty.reserve(count);
+			changed.reserve(count);
+			hasBaseMatrix.reserve(count);
+			parents.reserve(count);
+			translations.reserve(count);
+			rotations.reserve(count);
+			scales.reserve(count);
+			baseMatrices.reserve(count);
+			localMatrices.reserve(count);
+			worldMatrices.reserve(count);
+		}
+
+		/**
+		* Add a node, its world matrix is computed with the next update
+		*
+		* @param parent Index of the parent node, which has to be added before its children (noParent for root nodes)
+		*
+		* @return Index of the node
+		*/
+		uint32_t add(uint32_t parent, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale, const glm::mat4& baseMatrix = glm::mat4(1.0f))
+		{
+			const uint32_t index = static_cast<uint32_t>(parents.size());
+			parents.push_back(parent < index ? parent : noParent);
+			translations.push_back(translation);
+			rotations.push_back(rotation);
+			scales.push_back(scale);
+			baseMatrices.push_back(baseMatrix);
+			hasBaseMatrix.push_back(baseMatrix != glm::mat4(1.0f));
+			localMatrices.push_back(glm::mat4(1.0f));
+			worldMatrices.push_back(glm::mat4(1.0f));
+			changed.push_back(0);
+			dirty.push_back(0);
+			markDirty(index);
+			return index;
+		}
+
+		void setTranslation(uint32_t index, const glm::vec3& translation)
+		{
+			translations[index] = translation;
+			markDirty(index);
+		}
+
+		void setRotation(uint32_t index, const glm::quat& rotation)
+		{
+			rotations[index] = rotation;
+			markDirty(index);
+		}
+
+		void setScale(uint32_t index, const glm::vec3& scale)
+		{
+			scales[index] = scale;
+			markDirty(index);
+		}
+
+		/** @brief Returns true if the world matrix of the node has been recomputed by the last update */
+		bool worldChanged(uint32_t index) const
+		{
+			return changed[index] != 0;
+		}
+
+		/**
+		* Recompute the local matrices of all dirty nodes and the world matrices of their subtrees
+		*
+		* @return Number of world matrices that have been recomputed
+		*/
+		uint32_t update()
+		{
+			std::fill(changed.begin(), changed.end(), 0);
+			if (dirtyNodes.empty()) {
+				return 0;
+			}
+
+			// Local matrices don't depend on each other: T * R * S * base
+			for (uint32_t index : dirtyNodes) {
+				const glm::mat3 r = glm::mat3_cast(rotations[index]);
+				const glm::vec3& s = scales[index];
+				glm::mat4 m(glm::vec4(r[0] * s.x, 0.0f), glm::vec4(r[1] * s.y, 0.0f), glm::vec4(r[2] * s.z, 0.0f), glm::vec4(translations[index], 1.0f));
+				localMatrices[index] = hasBaseMatrix[index] ? m * baseMatrices[index] : m;
+			}
+
+			// Parents are stored before their children, so one pass starting at the first dirty node propagates all changes down the hierarchy
+			const uint32_t first = *std::min_element(dirtyNodes.begin(), dirtyNodes.end());
+			const uint32_t count = static_cast<uint32_t>(parents.size());
+			uint32_t updated = 0;
+			for (uint32_t i = first; i < count; i++) {
+				const uint32_t parent = parents[i];
+				const uint8_t parentChanged = (parent != noParent) ? changed[parent] : 0;
+				changed[i] = dirty[i] | parentChanged;
+				if (changed[i]) {
+					worldMatrices[i] = (parent != noParent) ? worldMatrices[parent] * localMatrices[i] : localMatrices[i];
+					updated++;
+				}
+				dirty[i] = 0;
+			}
+			dirtyNodes.clear();
+			return updated;
+		}
+	};
+}
@@ -7,6 +7,7 @@
 */
 
 #include "vulkanexamplebase.h"
+#include "VulkanglTFModel.h"
 
 #if defined(VK_EXAMPLE_XCODE_GENERATED)
 #if (defined(VK_USE_PLATFORM_MACOS_MVK) || defined(VK_USE_PLATFORM_METAL_EXT))
@@ -212,10 +213,133 @@ std::string VulkanExampleBase::getShadersPath() const
 	return getShaderBasePath() + shaderDir + "/";
 }
 
+std::string VulkanExampleBase::getPipelineCacheFileName() const
+{
+	std::string dir = pipelineCacheDir;
+#if defined(VK_USE_PLATFORM_ANDROID_KHR)
+	// The app's internal data path is the only location that's guaranteed to be writable on Android
+	if (dir.empty() && androidApp->activity->internalDataPath) {
+		dir = androidApp->activity->internalDataPath;
+	}
+#else
+	// Store the cache next to the executable instead of the current working directory
+	if (dir.empty() && !args.empty() && args[0] != nullptr) {
+		const std::string executable = args[0];
+		const size_t separator = executable.find_last_of("/\\");
+		if (separator != std::string::npos) {
+			dir = executable.substr(0, separator + 1);
+		}
+	}
+#endif
+	if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') {
+		dir += "/";
+	}
+	return dir + getSampleName() + ".pipelinecache";
+}
+
+// Derives the sample name from the executable name, falls back to the (generic) name member if no arguments are available (e.g. Android)
+std::string VulkanExampleBase::getSampleName() const
+{
+	if (args.empty() || args[0] == nullptr) {
+		return name;
+	}
+	std::string executable = args[0];
+	const size_t separator = executable.find_last_of("/\\");
+	if (separator != std::string::npos) {
+		executable = executable.substr(separator + 1);
+	}
+	const size_t extension = executable.rfind('.');
+	if (extension != std::string::npos && extension > 0) {
+		executable = executable.substr(0, extension);
+	}
+	return executable.empty() ? name : executable;
+}
+
+void VulkanExampleBase::setBenchmarkInfo()
+{
+	benchmark.sampleName = getSampleName();
+	benchmark.shaderLanguage = shaderDir;
+	benchmark.width = width;
+	benchmark.height = height;
+}
+
 void VulkanExampleBase::createPipelineCache()
 {
-	VkPipelineCacheCreateInfo pipelineCacheCreateInfo { .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache));
+	// Try to initialize the pipeline cache with the data stored by a previous run, so pipelines don't have to be compiled from scratch
+	const std::string fileName = getPipelineCacheFileName();
+	std::vector<char> cacheData;
+	std::string missReason;
+	std::ifstream is(fileName, std::ios::binary | std::ios::in | std::ios::ate);
+	if (is.is_open()) {
+		const size_t size = is.tellg();
+		is.seekg(0, std::ios::beg);
+		cacheData.resize(size);
+		is.read(cacheData.data(), size);
+		is.close();
+		// The cache data is only valid for the device and driver it was created with, which is identified by the cache header
+		VkPipelineCacheHeaderVersionOne header{};
+		if (size >= sizeof(header)) {
+			memcpy(&header, cacheData.data(), sizeof(header));
+		}
+		if ((size < sizeof(header)) || (header.headerSize < sizeof(header)) || (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)) {
+			missReason = "invalid header";
+		} else if ((header.vendorID != deviceProperties.vendorID) || (header.deviceID != deviceProperties.deviceID)) {
+			missReason = "device mismatch";
+		} else if (memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+			missReason = "driver mismatch";
+		}
+		if (!missReason.empty()) {
+			cacheData.clear();
+		}
+	} else {
+		missReason = "no cache file";
+	}
+
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.initialDataSize = cacheData.size(),
+		.pInitialData = cacheData.data()
+	};
+	VkResult result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+	if ((result != VK_SUCCESS) && !cacheData.empty()) {
+		// Implementations may still refuse the data (e.g. if the file is corrupted), fall back to an empty cache in that case
+		missReason = "rejected by driver";
+		cacheData.clear();
+		pipelineCacheCreateInfo.initialDataSize = 0;
+		pipelineCacheCreateInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+	}
+	VK_CHECK_RESULT(result);
+	pipelineCacheLoadedData = std::move(cacheData);
+
+	if (missReason.empty()) {
+		std::cout << "Pipeline cache: hit (" << pipelineCacheLoadedData.size() << " bytes loaded from \"" << fileName << "\")\n";
+	} else {
+		std::cout << "Pipeline cache: miss (" << missReason << ")\n";
+	}
+}
+
+void VulkanExampleBase::savePipelineCache()
+{
+	size_t size{ 0 };
+	if ((vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) != VK_SUCCESS) || (size == 0)) {
+		return;
+	}
+	std::vector<char> cacheData(size);
+	VK_CHECK_RESULT(vkGetPipelineCacheData(device, pipelineCache, &size, cacheData.data()));
+	// Only write the cache back if its contents changed during this run (the size alone doesn't tell, e.g. if the driver replaced entries)
+	cacheData.resize(size);
+	if (cacheData == pipelineCacheLoadedData) {
+		return;
+	}
+	const std::string fileName = getPipelineCacheFileName();
+	std::ofstream os(fileName, std::ios::binary | std::ios::out | std::ios::trunc);
+	if (!os.is_open()) {
+		std::cerr << "Error: Could not write pipeline cache to \"" << fileName << "\"\n";
+		return;
+	}
+	os.write(cacheData.data(), size);
+	std::cout << "Pipeline cache: " << size << " bytes written to \"" << fileName << "\" (" << pipelineCacheLoadedData.size() << " bytes at startup)\n";
 }
 
 void VulkanExampleBase::prepare()
@@ -229,6 +353,17 @@ void VulkanExampleBase::prepare()
 	setupRenderPass();
 	createPipelineCache();
 	setupFrameBuffer();
+	// Timestamps are written with vkCmdWriteTimestamp2 if the sample enabled synchronization2
+	bool synchronization2 = false;
+	for (auto* pNext = static_cast<const VkBaseInStructure*>(deviceCreatepNextChain); pNext; pNext = pNext->pNext) {
+		if (pNext->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES) {
+			synchronization2 |= (reinterpret_cast<const VkPhysicalDeviceVulkan13Features*>(pNext)->synchronization2 == VK_TRUE);
+		}
+		if (pNext->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES) {
+			synchronization2 |= (reinterpret_cast<const VkPhysicalDeviceSynchronization2Features*>(pNext)->synchronization2 == VK_TRUE);
+		}
+	}
+	gpuProfiler.create(vulkanDevice, maxConcurrentFrames, synchronization2);
 	settings.overlay = settings.overlay && (!benchmark.active);
 	if (settings.overlay) {
 		ui.maxConcurrentFrames = maxConcurrentFrames;
@@ -262,6 +397,7 @@ VkPipelineShaderStageCreateInfo VulkanExampleBase::loadShader(std::string fileNa
 
 void VulkanExampleBase::nextFrame()
 {
+	VKS_PROFILE_ZONE("Frame");
 	auto tStart = std::chrono::high_resolution_clock::now();
 	render();
 	frameCounter++;
@@ -306,23 +442,30 @@ void VulkanExampleBase::renderLoop()
 #if !(defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK) || defined(VK_USE_PLATFORM_METAL_EXT))
 	if (benchmark.active) {
 #if defined(VK_USE_PLATFORM_WAYLAND_KHR)
-		while (!configured)
+		while (!configured && !settings.headless)
 		{
 			if (wl_display_dispatch(display) == -1)
 				break;
 		}
-		while (wl_display_prepare_read(display) != 0)
+		while (!settings.headless && wl_display_prepare_read(display) != 0)
 		{
 			if (wl_display_dispatch_pending(display) == -1)
 				break;
 		}
-		wl_display_flush(display);
-		wl_display_read_events(display);
-		if (wl_display_dispatch_pending(display) == -1)
-			return;
+		if (!settings.headless) {
+			wl_display_flush(display);
+			wl_display_read_events(display);
+			if (wl_display_dispatch_pending(display) == -1)
+				return;
+		}
 #endif
-		benchmark.run([=, this] { render(); }, vulkanDevice->properties);
+		benchmark.memoryStatistics = vulkanDevice->memoryAllocator.getStatistics();
+		setBenchmarkInfo();
+		benchmark.run([=, this] { VKS_PROFILE_ZONE("Frame"); render(); }, vulkanDevice->properties, &gpuProfiler);
 		vkDeviceWaitIdle(device);
+		if (!benchmark.jsonFilename.empty()) {
+			benchmark.saveResultsJson();
+		}
 		if (!benchmark.filename.empty()) {
 			benchmark.saveResults();
 		}
@@ -334,6 +477,16 @@ void VulkanExampleBase::renderLoop()
 	destHeight = height;
 	lastTimestamp = std::chrono::high_resolution_clock::now();
 	tPrevEnd = lastTimestamp;
+#if defined(_WIN32) || defined(VK_USE_PLATFORM_WAYLAND_KHR) || defined(VK_USE_PLATFORM_XCB_KHR)
+	if (settings.headless) {
+		// There are no window events to handle, so frames are rendered until the frame limit is reached or the sample requests to quit
+		for (int frame = 0; (frame != benchmark.outputFrames) && !quit; frame++) {
+			nextFrame();
+		}
+		vkDeviceWaitIdle(device);
+		return;
+	}
+#endif
 #if defined(_WIN32)
 	MSG msg;
 	bool quitMessageReceived = false;
@@ -643,6 +796,7 @@ void VulkanExampleBase::updateOverlay()
 	if (!settings.overlay)
 		return;
 
+	VKS_PROFILE_ZONE("Update overlay");
 	ImGuiIO& io = ImGui::GetIO();
 	io.DisplaySize = ImVec2((float)width, (float)height);
 	io.DeltaTime = frameTimer;
@@ -659,6 +813,15 @@ void VulkanExampleBase::updateOverlay()
 	ImGui::TextUnformatted(title.c_str());
 	ImGui::TextUnformatted(deviceProperties.deviceName);
 	ImGui::Text("%.2f ms/frame (%.1d fps)", (1000.0f / lastFPS), lastFPS);
+	const vks::MemoryStatistics memoryStatistics = vulkanDevice->memoryAllocator.getStatistics();
+	ImGui::Text("%.1f / %.1f MB in %d blocks (%.0f%% fragmented)", (float)memoryStatistics.usedBytes / (1024.0f * 1024.0f), (float)memoryStatistics.blockBytes / (1024.0f * 1024.0f), memoryStatistics.blockCount, memoryStatistics.fragmentation * 100.0f);
+	const std::vector<vks::GpuProfiler::Region>& gpuTimings = gpuProfiler.getResults();
+	// Only samples that profile more than the whole frame get a per-pass breakdown
+	if ((gpuTimings.size() > 1) && ImGui::CollapsingHeader("GPU timings", ImGuiTreeNodeFlags_DefaultOpen)) {
+		for (auto& region : gpuTimings) {
+			ImGui::Text("%*s%s: %.3f ms", static_cast<int>(region.depth * 2), "", region.name.c_str(), region.time);
+		}
+	}
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 	ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, 5.0f * ui.scale));
 #endif
@@ -696,12 +859,17 @@ void VulkanExampleBase::prepareFrame(bool waitForFence)
 {
 	// Ensure command buffer execution has finished
 	if (waitForFence) {
+		VKS_PROFILE_ZONE("Wait for frame fence");
 		VK_CHECK_RESULT(vkWaitForFences(device, 1, &waitFences[currentBuffer], VK_TRUE, UINT64_MAX));
 		VK_CHECK_RESULT(vkResetFences(device, 1, &waitFences[currentBuffer]));
 	}
 	updateOverlay();
 	// Acquire the next image from the swap chain
-	VkResult result = swapChain.acquireNextImage(presentCompleteSemaphores[currentBuffer], currentImageIndex);
+	VkResult result;
+	{
+		VKS_PROFILE_ZONE("Acquire next image");
+		result = swapChain.acquireNextImage(presentCompleteSemaphores[currentBuffer], currentImageIndex);
+	}
 	// Recreate the swapchain if it's no longer compatible with the surface (OUT_OF_DATE)
 	// If no longer optimal (VK_SUBOPTIMAL_KHR), wait until submitFrame() in case number of swapchain images will change on resize
 	if ((result == VK_ERROR_OUT_OF_DATE_KHR) || (result == VK_SUBOPTIMAL_KHR)) {
@@ -718,6 +886,7 @@ void VulkanExampleBase::prepareFrame(bool waitForFence)
 void VulkanExampleBase::submitFrame(bool skipQueueSubmit)
 {
 	if (!skipQueueSubmit) {
+		VKS_PROFILE_ZONE("Queue submit");
 		const VkPipelineStageFlags waitPipelineStage{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 		VkSubmitInfo submitInfo{
 			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
@@ -732,15 +901,11 @@ void VulkanExampleBase::submitFrame(bool skipQueueSubmit)
 		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, waitFences[currentBuffer]));
 	}
 
-	VkPresentInfoKHR presentInfo{
-		.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-		.waitSemaphoreCount = 1,
-		.pWaitSemaphores = &renderCompleteSemaphores[currentImageIndex],
-		.swapchainCount = 1,
-		.pSwapchains = &swapChain.swapChain,
-		.pImageIndices = &currentImageIndex
-	};
-	VkResult result = vkQueuePresentKHR(queue, &presentInfo);
+	VkResult result;
+	{
+		VKS_PROFILE_ZONE("Queue present");
+		result = swapChain.queuePresent(queue, currentImageIndex, renderCompleteSemaphores[currentImageIndex]);
+	}
 	// Recreate the swapchain if it's no longer compatible with the surface (OUT_OF_DATE) or no longer optimal for presentation (SUBOPTIMAL)
 	if ((result == VK_ERROR_OUT_OF_DATE_KHR) || (result == VK_SUBOPTIMAL_KHR)) {
 		windowResize();
@@ -774,6 +939,15 @@ VulkanExampleBase::VulkanExampleBase()
 	commandLineParser.add("benchmarkresultfile", { "-bf", "--benchfilename" }, 1, "Set file name for benchmark results");
 	commandLineParser.add("benchmarkresultframes", { "-bt", "--benchframetimes" }, 0, "Save frame times to benchmark results file");
 	commandLineParser.add("benchmarkframes", { "-bfs", "--benchmarkframes" }, 1, "Only render the given number of frames");
+	commandLineParser.add("benchmarkjsonfile", { "-bj", "--benchjson" }, 1, "Set file name for a JSON benchmark report (percentiles, histogram, run info)");
+	commandLineParser.add("benchmarkhitchthreshold", { "-bh", "--benchhitch" }, 1, "Set frame time in ms above which a frame counts as a hitch (default: twice the median frame time)");
+	commandLineParser.add("pipelinecache", { "-pc", "--pipelinecache" }, 1, "Set directory for storing the pipeline cache between runs (default: directory of the executable)");
+	commandLineParser.add("modelcache", { "-mc", "--modelcache" }, 1, "Store cooked glTF model caches in the given directory and load models from them on subsequent runs");
+	commandLineParser.add("modelstats", { "--modelstats" }, 0, "Print load timings and statistics for every loaded glTF model");
+	commandLineParser.add("trace", { "--trace" }, 1, "Write CPU profiler zones to the given file in Chrome trace event format (chrome://tracing, Perfetto)");
+#if defined(_WIN32) || defined(VK_USE_PLATFORM_WAYLAND_KHR) || defined(VK_USE_PLATFORM_XCB_KHR)
+	commandLineParser.add("headless", { "--headless" }, 0, "Render into offscreen images without a window (e.g. for benchmarks on machines without a window system), requires -b or -bfs");
+#endif
 #if (!(defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK) || defined(VK_USE_PLATFORM_METAL_EXT)))
 	commandLineParser.add("resourcepath", { "-rp", "--resourcepath" }, 1, "Set path for dir where assets and shaders folder is present");
 #endif
@@ -832,6 +1006,35 @@ VulkanExampleBase::VulkanExampleBase()
 	if (commandLineParser.isSet("benchmarkframes")) {
 		benchmark.outputFrames = commandLineParser.getValueAsInt("benchmarkframes", benchmark.outputFrames);
 	}
+	if (commandLineParser.isSet("benchmarkjsonfile")) {
+		benchmark.jsonFilename = commandLineParser.getValueAsString("benchmarkjsonfile", benchmark.jsonFilename);
+	}
+	if (commandLineParser.isSet("benchmarkhitchthreshold")) {
+		benchmark.hitchThreshold = std::atof(commandLineParser.getValueAsString("benchmarkhitchthreshold", "0").c_str());
+	}
+	if (commandLineParser.isSet("pipelinecache")) {
+		pipelineCacheDir = commandLineParser.getValueAsString("pipelinecache", pipelineCacheDir);
+	}
+	if (commandLineParser.isSet("modelcache")) {
+		vkglTF::modelCacheDir = commandLineParser.getValueAsString("modelcache", vkglTF::modelCacheDir);
+		vkglTF::modelCacheEnabled = !vkglTF::modelCacheDir.empty();
+	}
+	if (commandLineParser.isSet("modelstats")) {
+		vkglTF::printLoadStatistics = true;
+	}
+	if (commandLineParser.isSet("headless")) {
+		// Without a window there's no way to close the sample, so it needs to know when to stop
+		if (!benchmark.active && (benchmark.outputFrames < 0)) {
+			std::cerr << "Error: --headless requires benchmark mode (-b) or a frame limit (-bfs)\n";
+			exit(-1);
+		}
+		settings.headless = true;
+	}
+	if (commandLineParser.isSet("trace")) {
+		traceFilename = commandLineParser.getValueAsString("trace", traceFilename);
+		vks::Profiler::get().setEnabled(!traceFilename.empty());
+		VKS_PROFILE_THREAD("Main thread");
+	}
 #if (!(defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK) || defined(VK_USE_PLATFORM_METAL_EXT)))
 	if(commandLineParser.isSet("resourcepath")) {
 		vks::tools::resourcePath = commandLineParser.getValueAsString("resourcepath", "");
@@ -880,9 +1083,13 @@ VulkanExampleBase::VulkanExampleBase()
 #elif defined(_DIRECT2DISPLAY)
 
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
-	initWaylandConnection();
+	if (!settings.headless) {
+		initWaylandConnection();
+	}
 #elif defined(VK_USE_PLATFORM_XCB_KHR)
-	initxcbConnection();
+	if (!settings.headless) {
+		initxcbConnection();
+	}
 #endif
 
 #if defined(_WIN32)
@@ -897,6 +1104,9 @@ VulkanExampleBase::VulkanExampleBase()
 
 VulkanExampleBase::~VulkanExampleBase()
 {
+	if (!traceFilename.empty()) {
+		vks::Profiler::get().saveTrace(traceFilename);
+	}
 	// Clean up Vulkan resources
 	swapChain.cleanup();
 	if (descriptorPool != VK_NULL_HANDLE) {
@@ -915,6 +1125,9 @@ VulkanExampleBase::~VulkanExampleBase()
 	vkDestroyImageView(device, depthStencil.view, nullptr);
 	vkDestroyImage(device, depthStencil.image, nullptr);
 	vkFreeMemory(device, depthStencil.memory, nullptr);
+	if (pipelineCache != VK_NULL_HANDLE) {
+		savePipelineCache();
+	}
 	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 	vkDestroyCommandPool(device, cmdPool, nullptr);
 	for (auto& fence : waitFences) {
@@ -929,6 +1142,7 @@ VulkanExampleBase::~VulkanExampleBase()
 	if (settings.overlay) {
 		ui.freeResources();
 	}
+	gpuProfiler.destroy();
 	delete vulkanDevice;
 	if (settings.validation) {
 		vks::debug::freeDebugCallback(instance);
@@ -948,6 +1162,9 @@ VulkanExampleBase::~VulkanExampleBase()
 	if (dfb)
 		dfb->Release(dfb);
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
+	if (settings.headless) {
+		return;
+	}
 	xdg_toplevel_destroy(xdg_toplevel);
 	xdg_surface_destroy(xdg_surface);
 	wl_surface_destroy(surface);
@@ -962,6 +1179,9 @@ VulkanExampleBase::~VulkanExampleBase()
 	wl_registry_destroy(registry);
 	wl_display_disconnect(display);
 #elif defined(VK_USE_PLATFORM_XCB_KHR)
+	if (settings.headless) {
+		return;
+	}
 	xcb_destroy_window(connection, window);
 	xcb_disconnect(connection);
 #elif defined(VK_USE_PLATFORM_SCREEN_QNX)
@@ -1128,6 +1348,9 @@ void VulkanExampleBase::setupDPIAwareness()
 HWND VulkanExampleBase::setupWindow(HINSTANCE hinstance, WNDPROC wndproc)
 {
 	this->windowInstance = hinstance;
+	if (settings.headless) {
+		return nullptr;
+	}
 
 	WNDCLASSEX wndClass{
 		.cbSize = sizeof(WNDCLASSEX),
@@ -1888,7 +2111,12 @@ void VulkanExampleBase::displayLinkOutputCb()
 {
 #if defined(VK_EXAMPLE_XCODE_GENERATED)
 	if (benchmark.active) {
-		benchmark.run([=] { render(); }, vulkanDevice->properties);
+		benchmark.memoryStatistics = vulkanDevice->memoryAllocator.getStatistics();
+		setBenchmarkInfo();
+		benchmark.run([=] { VKS_PROFILE_ZONE("Frame"); render(); }, vulkanDevice->properties, &gpuProfiler);
+		if (benchmark.jsonFilename != "") {
+			benchmark.saveResultsJson();
+		}
 		if (benchmark.filename != "") {
 			benchmark.saveResults();
 		}
@@ -2397,6 +2625,9 @@ static const struct xdg_toplevel_listener xdg_toplevel_listener = {
 
 struct xdg_surface *VulkanExampleBase::setupWindow()
 {
+	if (settings.headless) {
+		return nullptr;
+	}
 	surface = wl_compositor_create_surface(compositor);
 	xdg_surface = xdg_wm_base_get_xdg_surface(shell, surface);
 
@@ -2427,6 +2658,9 @@ static inline xcb_intern_atom_reply_t* intern_atom_helper(xcb_connection_t *conn
 // Set up a window using XCB and request event types
 xcb_window_t VulkanExampleBase::setupWindow()
 {
+	if (settings.headless) {
+		return 0;
+	}
 	uint32_t value_mask, value_list[32];
 
 	window = xcb_generate_id(connection);
@@ -3178,6 +3412,9 @@ void VulkanExampleBase::windowResized() {}
 
 void VulkanExampleBase::createSurface()
 {
+	if (settings.headless) {
+		return;
+	}
 #if defined(_WIN32)
 	swapChain.initSurface(windowInstance, window);
 #elif defined(VK_USE_PLATFORM_ANDROID_KHR)
@@ -3201,6 +3438,11 @@ void VulkanExampleBase::createSurface()
 
 void VulkanExampleBase::createSwapChain()
 {
+	if (settings.headless) {
+		// One image per frame in flight, so an image can be reused as soon as the fence of its frame has been waited on
+		swapChain.createHeadless(width, height, maxConcurrentFrames, queue);
+		return;
+	}
 	swapChain.create(width, height, settings.vsync, settings.fullscreen);
 }
 
@@ -68,10 +68,13 @@
 #include "VulkanBuffer.h"
 #include "VulkanDevice.h"
 #include "VulkanTexture.h"
+#include "VulkanGpuProfiler.h"
+#include "VulkanQueryManager.h"
 
 #include "VulkanInitializers.hpp"
 #include "camera.hpp"
 #include "benchmark.hpp"
+#include "profiler.hpp"
 
 constexpr uint32_t maxConcurrentFrames{ 2 };
 
@@ -86,6 +89,10 @@ private:
 	void nextFrame();
 	void updateOverlay();
 	void createPipelineCache();
+	void savePipelineCache();
+	std::string getPipelineCacheFileName() const;
+	std::string getSampleName() const;
+	void setBenchmarkInfo();
 	void createCommandPool();
 	void createSynchronizationPrimitives();
 	void createSurface();
@@ -93,6 +100,12 @@ private:
 	void createCommandBuffers();
 	void destroyCommandBuffers();
 	std::string shaderDir = "glsl";
+	// Directory the pipeline cache blob is read from at startup and written to on shutdown (empty = directory of the executable)
+	std::string pipelineCacheDir = "";
+	// Pipeline cache blob that was accepted at startup (empty = cache miss)
+	std::vector<char> pipelineCacheLoadedData;
+	// File the CPU profiler zones are written to on shutdown (empty = profiler disabled)
+	std::string traceFilename = "";
 protected:
 	// Returns the path to the root of the glsl, hlsl or slang shader directory.
 	std::string getShadersPath() const;
@@ -168,6 +181,9 @@ public:
 
 	vks::Benchmark benchmark;
 
+	/** @brief GPU timings of command buffer regions, samples wrap their passes with beginRegion/endRegion between beginFrame/endFrame */
+	vks::GpuProfiler gpuProfiler;
+
 	/** @brief Encapsulated physical and logical vulkan device */
 	vks::VulkanDevice *vulkanDevice{};
 
@@ -181,6 +197,8 @@ public:
 		bool vsync = false;
 		/** @brief Enable UI overlay */
 		bool overlay = true;
+		/** @brief Render into offscreen images instead of a swapchain, no window or surface is created */
+		bool headless = false;
 	} settings;
 
 	/** @brief State of gamepad input (only used on Android) */
@@ -227,6 +245,8 @@ public:
 #if defined(_WIN32)
 	HWND window;
 	HINSTANCE windowInstance;
+	// Only used to end headless rendering, windowed rendering ends with the window's quit message
+	bool quit = false;
 #elif defined(VK_USE_PLATFORM_ANDROID_KHR)
 	// true if application has focused, false if moved to background
 	bool focused = false;
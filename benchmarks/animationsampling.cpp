@@ -0,0 +1,260 @@
+/*
+* Micro benchmark for animation keyframe sampling
+*
+* Plays back a long motion capture like clip on many skeletons (characters) and compares the linear keyframe scan vkglTF used before
+* against cursor based lookups with vks::KeyframeSampler, evaluated serially and distributed over the workers of a vks::JobSystem
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include "keyframesampler.hpp"
+#include "transformhierarchy.hpp"
+#include "jobsystem.hpp"
+
+// Runs the function repeatedly for at least the given time and returns the average time per call in milliseconds
+double measure(const std::function<void()>& func, double minTime = 250.0)
+{
+	// Warm up
+	func();
+	uint32_t iterations = 0;
+	auto tStart = std::chrono::high_resolution_clock::now();
+	double elapsed = 0.0;
+	do {
+		func();
+		iterations++;
+		elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+	} while (elapsed < minTime);
+	return elapsed / iterations;
+}
+
+// Keyframes of one joint, shared by all characters playing the clip
+struct Channel
+{
+	uint32_t joint;
+	bool rotation;
+	std::vector<float> times;
+	std::vector<glm::vec4> values;
+};
+
+struct Character
+{
+	vks::TransformHierarchy skeleton;
+	std::vector<uint32_t> cursors;
+	float phase;
+};
+
+const uint32_t jointCount = 64;
+const float clipDuration = 30.0f;
+const float keyRate = 60.0f;
+
+std::vector<Channel> createClip(std::default_random_engine& rndEngine)
+{
+	std::uniform_real_distribution<float> rndDelta(-0.05f, 0.05f);
+	const uint32_t keyCount = static_cast<uint32_t>(clipDuration * keyRate) + 1;
+	std::vector<Channel> channels;
+	for (uint32_t joint = 0; joint < jointCount; joint++) {
+		// Rotation for every joint, the root is also translated
+		for (bool rotation : { true, false }) {
+			if (!rotation && joint != 0) {
+				continue;
+			}
+			Channel channel{ joint, rotation };
+			glm::vec4 value = rotation ? glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) : glm::vec4(0.0f);
+			for (uint32_t key = 0; key < keyCount; key++) {
+				channel.times.push_back(key / keyRate);
+				value = value + glm::vec4(rndDelta(rndEngine), rndDelta(rndEngine), rndDelta(rndEngine), rotation ? rndDelta(rndEngine) : 0.0f);
+				if (rotation) {
+					const glm::quat q = glm::normalize(glm::quat(value.w, value.x, value.y, value.z));
+					value = glm::vec4(q.x, q.y, q.z, q.w);
+				}
+				channel.values.push_back(value);
+			}
+			channels.push_back(channel);
+		}
+	}
+	return channels;
+}
+
+// Linear search over all intervals without stopping at the match, like vkglTF::Model::updateAnimation did before
+glm::vec4 sampleLinearScan(const Channel& channel, float time)
+{
+	glm::vec4 result = channel.values[0];
+	for (size_t i = 0; i < channel.times.size() - 1; i++) {
+		if ((time >= channel.times[i]) && (time <= channel.times[i + 1])) {
+			const float u = std::max(0.0f, time - channel.times[i]) / (channel.times[i + 1] - channel.times[i]);
+			if (u <= 1.0f) {
+				if (channel.rotation) {
+					const glm::vec4& a = channel.values[i];
+					const glm::vec4& b = channel.values[i + 1];
+					const glm::quat q = glm::normalize(glm::slerp(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), u));
+					result = glm::vec4(q.x, q.y, q.z, q.w);
+				} else {
+					result = glm::mix(channel.values[i], channel.values[i + 1], u);
+				}
+			}
+		}
+	}
+	return result;
+}
+
+void apply(Character& character, const Channel& channel, const glm::vec4& value)
+{
+	if (channel.rotation) {
+		character.skeleton.setRotation(channel.joint, glm::quat(value.w, value.x, value.y, value.z));
+	} else {
+		character.skeleton.setTranslation(channel.joint, glm::vec3(value));
+	}
+}
+
+void animateLinearScan(Character& character, const std::vector<Channel>& channels, float time)
+{
+	time = std::fmod(time + character.phase, clipDuration);
+	for (const Channel& channel : channels) {
+		apply(character, channel, sampleLinearScan(channel, time));
+	}
+	character.skeleton.update();
+}
+
+void animateCursor(Character& character, const std::vector<Channel>& channels, float time)
+{
+	time = std::fmod(time + character.phase, clipDuration);
+	for (size_t c = 0; c < channels.size(); c++) {
+		const Channel& channel = channels[c];
+		const glm::vec4 value = vks::KeyframeSampler::sample(vks::KeyframeSampler::Interpolation::Linear, channel.times.data(), channel.values.data(), static_cast<uint32_t>(channel.times.size()), time, character.cursors[c], channel.rotation);
+		apply(character, channel, value);
+	}
+	character.skeleton.update();
+}
+
+bool near(const glm::vec4& a, const glm::vec4& b, float epsilon = 1e-4f)
+{
+	return std::abs(a.x - b.x) < epsilon && std::abs(a.y - b.y) < epsilon && std::abs(a.z - b.z) < epsilon && std::abs(a.w - b.w) < epsilon;
+}
+
+// Cursor lookups have to give the same intervals as a search from scratch, for forward playback as well as for random jumps
+bool validateLookups(std::default_random_engine& rndEngine, const Channel& channel)
+{
+	std::uniform_real_distribution<float> rndTime(-1.0f, clipDuration + 1.0f);
+	const uint32_t count = static_cast<uint32_t>(channel.times.size());
+	uint32_t cursor = 0;
+	bool valid = true;
+	for (uint32_t i = 0; i < 10000; i++) {
+		const float time = (i < 5000) ? i * 0.004f : rndTime(rndEngine);
+		const uint32_t interval = vks::KeyframeSampler::findInterval(channel.times.data(), count, time, cursor);
+		const float clamped = std::clamp(time, channel.times.front(), channel.times.back());
+		valid &= (interval < count - 1) && (channel.times[interval] <= clamped) && (clamped <= channel.times[interval + 1]);
+		uint32_t freshCursor = 0;
+		valid &= near(vks::KeyframeSampler::sample(vks::KeyframeSampler::Interpolation::Linear, channel.times.data(), channel.values.data(), count, time, freshCursor, channel.rotation),
+			sampleLinearScan(channel, clamped), 1e-3f);
+	}
+	return valid;
+}
+
+// Hermite splines reproduce cubic polynomials exactly if the tangents are their derivatives
+bool validateCubicSpline()
+{
+	auto f = [](float t) { return glm::vec4(t * t * t, 2.0f * t - 1.0f, -t * t, 1.0f); };
+	auto df = [](float t) { return glm::vec4(3.0f * t * t, 2.0f, -2.0f * t, 0.0f); };
+	std::vector<float> times = { 0.0f, 0.5f, 1.25f, 2.0f, 3.0f };
+	std::vector<glm::vec4> values;
+	for (float t : times) {
+		values.insert(values.end(), { df(t), f(t), df(t) });
+	}
+	uint32_t cursor = 0;
+	bool valid = true;
+	for (float t = 0.0f; t <= 3.0f; t += 0.01f) {
+		valid &= near(vks::KeyframeSampler::sample(vks::KeyframeSampler::Interpolation::CubicSpline, times.data(), values.data(), static_cast<uint32_t>(times.size()), t, cursor, false), f(t), 1e-3f);
+	}
+	return valid;
+}
+
+int main()
+{
+	std::default_random_engine rndEngine(0);
+	const std::vector<Channel> channels = createClip(rndEngine);
+
+	bool valid = validateCubicSpline();
+	for (const Channel& channel : { channels[0], channels[1] }) {
+		valid &= validateLookups(rndEngine, channel);
+	}
+
+	vks::JobSystem jobSystem;
+	jobSystem.create();
+
+	std::cout << "Clip with " << channels.size() << " channels of " << channels[0].times.size() << " keyframes, " << jointCount << " joints per character, " << jobSystem.workerCount() << " workers\n";
+	std::cout << std::fixed;
+
+	std::uniform_real_distribution<float> rndPhase(0.0f, clipDuration);
+	for (uint32_t characterCount : { 1u, 100u, 1000u }) {
+		std::vector<Character> characters(characterCount);
+		for (Character& character : characters) {
+			// Limbs branch off the preceding joints, giving a skeleton with a few chains
+			std::uniform_int_distribution<uint32_t> rndParent(0, 3);
+			for (uint32_t joint = 0; joint < jointCount; joint++) {
+				const uint32_t parent = (joint == 0) ? vks::TransformHierarchy::noParent : joint - 1 - rndParent(rndEngine) % std::min(joint, 4u);
+				character.skeleton.add(parent, glm::vec3(0.0f, 0.1f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+			}
+			character.cursors.resize(channels.size(), 0);
+			character.phase = rndPhase(rndEngine);
+		}
+
+		std::cout << characterCount << " characters\n";
+		float time = 0.0f;
+		const double tScan = measure([&]() {
+			time += 1.0f / 60.0f;
+			for (Character& character : characters) {
+				animateLinearScan(character, channels, time);
+			}
+		}, characterCount > 100 ? 1000.0 : 250.0);
+		std::cout << "  linear keyframe scan     " << std::setprecision(3) << std::setw(10) << tScan << " ms per frame\n";
+
+		const double tCursor = measure([&]() {
+			time += 1.0f / 60.0f;
+			for (Character& character : characters) {
+				animateCursor(character, channels, time);
+			}
+		});
+		std::cout << "  cursor lookup            " << std::setw(10) << tCursor << " ms per frame\n";
+
+		const double tParallel = measure([&]() {
+			time += 1.0f / 60.0f;
+			jobSystem.parallelFor(characterCount, [&](uint32_t i) { animateCursor(characters[i], channels, time); });
+		});
+		std::cout << "  cursor lookup, parallel  " << std::setw(10) << tParallel << " ms per frame\n";
+		std::cout << "  speedup over linear scan " << std::setprecision(1) << tScan / tCursor << "x (serial), " << tScan / tParallel << "x (parallel)\n";
+
+		// Both paths have to produce the same poses
+		for (Character& character : characters) {
+			animateLinearScan(character, channels, time);
+			const std::vector<glm::mat4> reference = character.skeleton.worldMatrices;
+			animateCursor(character, channels, time);
+			for (uint32_t joint = 0; joint < jointCount; joint++) {
+				for (int c = 0; c < 4; c++) {
+					valid &= near(reference[joint][c], character.skeleton.worldMatrices[joint][c], 1e-3f);
+				}
+			}
+		}
+	}
+
+	if (!valid) {
+		std::cout << "Error: Keyframe sampling results don't match the reference\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,288 @@
+/*
+* Benchmark suite runner
+*
+* Runs the registered samples in benchmark mode, collects their reports into a single suite report and compares it against a baseline report
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+#include "json.hpp"
+#include "CommandLineParser.hpp"
+
+using json = nlohmann::json;
+
+// Exit codes, so CI can tell regressions from broken runs
+enum ExitCode { Success = 0, Regression = 1, Failure = 2 };
+
+struct SampleConfig {
+	std::string name;
+	// Name of the run in the suite report, allows registering the same sample with different arguments (defaults to the sample name)
+	std::string label{};
+	// Max. allowed increase of the mean frame time in percent
+	double threshold{ 5.0 };
+	// Additional command line arguments passed to the sample
+	std::vector<std::string> args{};
+};
+
+struct SuiteConfig {
+	uint32_t frames{ 1000 };
+	uint32_t warmup{ 1 };
+	// Upper limit for the runtime of a single sample in seconds, the sample stops after this even if it hasn't rendered all frames
+	uint32_t maxRuntime{ 120 };
+	uint32_t width{ 1280 };
+	uint32_t height{ 720 };
+	double threshold{ 5.0 };
+	// Significance level of the test for a change of the mean frame time
+	double alpha{ 0.01 };
+	std::vector<SampleConfig> samples;
+};
+
+bool loadConfig(const std::filesystem::path& filename, SuiteConfig& config)
+{
+	std::ifstream file(filename);
+	if (!file.is_open()) {
+		std::cerr << "Could not open suite configuration " << filename << "\n";
+		return false;
+	}
+	json data = json::parse(file, nullptr, false);
+	if (data.is_discarded()) {
+		std::cerr << "Could not parse suite configuration " << filename << "\n";
+		return false;
+	}
+	config.frames = data.value("frames", config.frames);
+	config.warmup = data.value("warmup", config.warmup);
+	config.maxRuntime = data.value("maxRuntime", config.maxRuntime);
+	config.width = data.value("width", config.width);
+	config.height = data.value("height", config.height);
+	config.threshold = data.value("threshold", config.threshold);
+	config.alpha = data.value("alpha", config.alpha);
+	for (auto& sample : data.value("samples", json::array())) {
+		SampleConfig sampleConfig{ .name = sample.value("name", ""), .threshold = sample.value("threshold", config.threshold) };
+		sampleConfig.args = sample.value("args", std::vector<std::string>());
+		sampleConfig.label = sample.value("label", sampleConfig.name);
+		if (!sampleConfig.name.empty()) {
+			config.samples.push_back(sampleConfig);
+		}
+	}
+	return true;
+}
+
+std::string quote(const std::string& value)
+{
+	return "\"" + value + "\"";
+}
+
+// Regularized incomplete beta function I_x(a, b), evaluated with a continued fraction (modified Lentz's method)
+double incompleteBeta(double a, double b, double x)
+{
+	if (x <= 0.0) {
+		return 0.0;
+	}
+	if (x >= 1.0) {
+		return 1.0;
+	}
+	// The continued fraction converges quickly for x < (a + 1) / (a + b + 2), use the symmetry relation otherwise
+	if (x > (a + 1.0) / (a + b + 2.0)) {
+		return 1.0 - incompleteBeta(b, a, 1.0 - x);
+	}
+	const double lnFront = std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x);
+	const double tiny = 1.0e-300;
+	double c = 1.0;
+	double d = 1.0 - (a + b) * x / (a + 1.0);
+	d = 1.0 / ((std::abs(d) < tiny) ? tiny : d);
+	double f = d;
+	for (int m = 1; m <= 300; m++) {
+		for (int step = 0; step < 2; step++) {
+			const double numerator = (step == 0)
+				? m * (b - m) * x / ((a + 2.0 * m - 1.0) * (a + 2.0 * m))
+				: -(a + m) * (a + b + m) * x / ((a + 2.0 * m) * (a + 2.0 * m + 1.0));
+			d = 1.0 + numerator * d;
+			d = 1.0 / ((std::abs(d) < tiny) ? tiny : d);
+			c = 1.0 + numerator / c;
+			c = (std::abs(c) < tiny) ? tiny : c;
+			f *= c * d;
+		}
+		if (std::abs(c * d - 1.0) < 1.0e-12) {
+			break;
+		}
+	}
+	return std::exp(lnFront) * f / a;
+}
+
+// Two-sided p-value of Welch's t-test for the difference of two means
+double welchTest(double meanA, double stddevA, double countA, double meanB, double stddevB, double countB)
+{
+	if ((countA < 2.0) || (countB < 2.0)) {
+		return 1.0;
+	}
+	const double varA = stddevA * stddevA / countA;
+	const double varB = stddevB * stddevB / countB;
+	if (varA + varB <= 0.0) {
+		return (meanA == meanB) ? 1.0 : 0.0;
+	}
+	const double t = (meanA - meanB) / std::sqrt(varA + varB);
+	const double dof = (varA + varB) * (varA + varB) / (varA * varA / (countA - 1.0) + varB * varB / (countB - 1.0));
+	return incompleteBeta(dof / 2.0, 0.5, dof / (dof + t * t));
+}
+
+int main(int argc, char* argv[])
+{
+	const std::filesystem::path executableDir = std::filesystem::absolute(argv[0]).parent_path();
+
+	CommandLineParser commandLineParser;
+	commandLineParser.add("help", { "--help" }, 0, "Show help");
+	commandLineParser.add("config", { "-c", "--config" }, 1, "Suite configuration with the registered samples, frame count, resolution and thresholds (default: benchmark_suite.json next to this executable)");
+	commandLineParser.add("samples", { "-s", "--samples" }, 1, "Comma separated subset of the registered samples to run (by label)");
+	commandLineParser.add("bindir", { "-d", "--bindir" }, 1, "Directory containing the sample binaries (default: directory of this executable)");
+	commandLineParser.add("output", { "-o", "--output" }, 1, "File name for the suite report (default: benchmark_suite_report.json)");
+	commandLineParser.add("baseline", { "-bl", "--baseline" }, 1, "Suite report of a previous run to compare against");
+	commandLineParser.add("frames", { "-f", "--frames" }, 1, "Override the number of frames rendered per sample");
+	commandLineParser.add("headless", { "--headless" }, 0, "Run the samples without a window");
+	commandLineParser.parse(argc, argv);
+	if (commandLineParser.isSet("help")) {
+		commandLineParser.printHelp();
+		std::cout << "\n";
+		return Success;
+	}
+
+	SuiteConfig config{};
+	if (!loadConfig(commandLineParser.getValueAsString("config", (executableDir / "benchmark_suite.json").string()), config)) {
+		return Failure;
+	}
+	config.frames = commandLineParser.getValueAsInt("frames", config.frames);
+	if (commandLineParser.isSet("samples")) {
+		std::vector<SampleConfig> selected;
+		std::stringstream names(commandLineParser.getValueAsString("samples", ""));
+		std::string name;
+		while (std::getline(names, name, ',')) {
+			auto sample = std::find_if(config.samples.begin(), config.samples.end(), [&name](const SampleConfig& sample) { return sample.label == name; });
+			// Samples that aren't registered are run with the default settings
+			selected.push_back((sample != config.samples.end()) ? *sample : SampleConfig{ .name = name, .label = name, .threshold = config.threshold });
+		}
+		config.samples = selected;
+	}
+	const std::filesystem::path binDir = commandLineParser.getValueAsString("bindir", executableDir.string());
+	const std::filesystem::path outputFile = commandLineParser.getValueAsString("output", "benchmark_suite_report.json");
+
+	json baseline;
+	if (commandLineParser.isSet("baseline")) {
+		std::ifstream file(commandLineParser.getValueAsString("baseline", ""));
+		baseline = file.is_open() ? json::parse(file, nullptr, false) : json();
+		if (!baseline.is_object()) {
+			std::cerr << "Could not read baseline report " << commandLineParser.getValueAsString("baseline", "") << "\n";
+			return Failure;
+		}
+	}
+
+	const std::filesystem::path reportDir = std::filesystem::temp_directory_path() / "vulkan_benchmark_suite";
+	std::filesystem::create_directories(reportDir);
+
+	json suiteReport = {
+		{ "frames", config.frames },
+		{ "width", config.width },
+		{ "height", config.height },
+		{ "samples", json::object() },
+	};
+	uint32_t failedCount = 0;
+	for (auto& sample : config.samples) {
+#if defined(_WIN32)
+		const std::filesystem::path binary = binDir / (sample.name + ".exe");
+#else
+		const std::filesystem::path binary = binDir / sample.name;
+#endif
+		const std::filesystem::path reportFile = reportDir / (sample.label + ".json");
+		std::filesystem::remove(reportFile);
+		std::string command = quote(binary.string()) + " -b -bfs " + std::to_string(config.frames) + " -bw " + std::to_string(config.warmup) + " -br " + std::to_string(config.maxRuntime)
+			+ " -w " + std::to_string(config.width) + " -h " + std::to_string(config.height) + " -bj " + quote(reportFile.string());
+		if (commandLineParser.isSet("headless")) {
+			command += " --headless";
+		}
+		for (auto& arg : sample.args) {
+			command += " " + arg;
+		}
+#if defined(_WIN32)
+		// cmd.exe strips the outer quotes of the command
+		command = quote(command);
+#endif
+		std::cout << "Running " << sample.label << "\n";
+		const int result = std::system(command.c_str());
+		std::ifstream file(reportFile);
+		json report = file.is_open() ? json::parse(file, nullptr, false) : json();
+		if ((result != 0) || !report.is_object()) {
+			std::cerr << sample.label << " failed (exit code " << result << ")\n";
+			failedCount++;
+			continue;
+		}
+		report["threshold"] = sample.threshold;
+		suiteReport["samples"][sample.label] = report;
+	}
+
+	std::ofstream output(outputFile);
+	if (output.is_open()) {
+		output << suiteReport.dump(1, '\t') << "\n";
+		std::cout << "Suite report written to " << outputFile << "\n";
+	} else {
+		std::cerr << "Could not write suite report to " << outputFile << "\n";
+	}
+
+	// Compare against the baseline, a sample has regressed if its mean frame time increased by more than its threshold and the increase is statistically significant
+	uint32_t regressionCount = 0;
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "\n" << std::left << std::setw(28) << "sample" << std::right << std::setw(12) << "mean (ms)" << std::setw(12) << "p99 (ms)";
+	if (!baseline.is_null()) {
+		std::cout << std::setw(12) << "base (ms)" << std::setw(10) << "change" << std::setw(10) << "p-value" << "  result";
+	}
+	std::cout << "\n";
+	for (auto& [name, report] : suiteReport["samples"].items()) {
+		const json& frameTime = report["frameTime"];
+		const double mean = frameTime.value("mean", 0.0);
+		std::cout << std::left << std::setw(28) << name << std::right << std::setw(12) << mean << std::setw(12) << frameTime.value("p99", 0.0);
+		if (!baseline.is_null()) {
+			if (baseline["samples"].count(name) == 0) {
+				std::cout << std::setw(12) << "-" << std::setw(10) << "-" << std::setw(10) << "-" << "  no baseline";
+			} else {
+				const json& baseReport = baseline["samples"][name];
+				const json& baseFrameTime = baseReport["frameTime"];
+				const double baseMean = baseFrameTime.value("mean", 0.0);
+				const double change = (baseMean > 0.0) ? (mean - baseMean) / baseMean * 100.0 : 0.0;
+				const double pValue = welchTest(mean, frameTime.value("stddev", 0.0), report.value("frames", 0.0), baseMean, baseFrameTime.value("stddev", 0.0), baseReport.value("frames", 0.0));
+				const bool regressed = (change > report.value("threshold", config.threshold)) && (pValue < config.alpha);
+				const bool improved = (change < -report.value("threshold", config.threshold)) && (pValue < config.alpha);
+				std::cout << std::setw(12) << baseMean << std::setw(9) << std::showpos << change << std::noshowpos << "%" << std::setw(10) << std::setprecision(4) << pValue << std::setprecision(3);
+				std::cout << (regressed ? "  REGRESSION" : (improved ? "  improved" : "  ok"));
+				if (baseReport["device"].value("name", "") != report["device"].value("name", "")) {
+					std::cout << " (different device)";
+				}
+				if (regressed) {
+					regressionCount++;
+				}
+			}
+		}
+		std::cout << "\n";
+	}
+	std::cout << "\n" << suiteReport["samples"].size() << " samples run, " << failedCount << " failed";
+	if (!baseline.is_null()) {
+		std::cout << ", " << regressionCount << " regressed";
+	}
+	std::cout << "\n";
+
+	if (failedCount > 0) {
+		return Failure;
+	}
+	return (regressionCount > 0) ? Regression : Success;
+}
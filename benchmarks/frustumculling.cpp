@@ -0,0 +1,118 @@
+/*
+* Micro benchmark for the batched frustum culling functions
+*
+* Compares the per-object checkSphere test against the scalar, SSE and AVX2 batch paths of vks::Frustum at different object counts
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <string>
+
+#include "frustum.hpp"
+
+// Runs the function repeatedly for at least the given time and returns the average time per call in milliseconds
+double measure(const std::function<void()>& func, double minTime = 250.0)
+{
+	// Warm up
+	func();
+	uint32_t iterations = 0;
+	auto tStart = std::chrono::high_resolution_clock::now();
+	double elapsed = 0.0;
+	do {
+		func();
+		iterations++;
+		elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+	} while (elapsed < minTime);
+	return elapsed / iterations;
+}
+
+void printResult(const std::string& name, size_t count, double time, double baseline)
+{
+	std::cout << "  " << std::left << std::setw(20) << name << std::right << std::setw(12) << std::fixed << std::setprecision(4) << time << " ms" << std::setw(10) << std::setprecision(2) << (time * 1.0e6 / count) << " ns/object" << std::setw(9) << (baseline / time) << "x\n";
+}
+
+int main()
+{
+	std::default_random_engine rndEngine(0);
+	std::uniform_real_distribution<float> rndPos(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> rndSize(0.1f, 2.0f);
+
+	vks::Frustum frustum;
+	const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 256.0f);
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, -50.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	frustum.update(projection * view);
+
+	const vks::Frustum::CullPath bestPath = vks::Frustum::getBestCullPath();
+	std::vector<std::pair<std::string, vks::Frustum::CullPath>> paths = { { "batch scalar", vks::Frustum::CullPath::Scalar } };
+	if (bestPath != vks::Frustum::CullPath::Scalar) {
+		paths.push_back({ "batch SSE", vks::Frustum::CullPath::SSE });
+	}
+	if (bestPath == vks::Frustum::CullPath::AVX2) {
+		paths.push_back({ "batch AVX2", vks::Frustum::CullPath::AVX2 });
+	}
+
+	for (size_t count : { size_t(1000), size_t(64 * 1000), size_t(1000 * 1000) }) {
+		std::vector<glm::vec3> positions(count);
+		std::vector<float> radii(count);
+		vks::BoundingSpheres spheres;
+		vks::BoundingBoxes boxes;
+		spheres.resize(count);
+		boxes.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			positions[i] = glm::vec3(rndPos(rndEngine), rndPos(rndEngine), rndPos(rndEngine));
+			radii[i] = rndSize(rndEngine);
+			spheres.set(i, positions[i], radii[i]);
+			boxes.set(i, positions[i] - glm::vec3(radii[i]), positions[i] + glm::vec3(radii[i]));
+		}
+
+		std::cout << count << " objects\n";
+
+		// Baseline: one checkSphere call per object, as done by the samples
+		std::vector<uint32_t> referenceMask;
+		double baseline = measure([&]() {
+			referenceMask.assign((count + 31) / 32, 0);
+			for (size_t i = 0; i < count; i++) {
+				referenceMask[i / 32] |= uint32_t(frustum.checkSphere(positions[i], radii[i])) << (i % 32);
+			}
+		});
+		printResult("checkSphere", count, baseline, baseline);
+
+		std::vector<uint32_t> mask;
+		for (auto& [name, path] : paths) {
+			frustum.cullPath = path;
+			double time = measure([&]() { frustum.cullSpheres(spheres, mask); });
+			printResult(name + " spheres", count, time, baseline);
+			if (mask != referenceMask) {
+				std::cout << "  Mismatch between " << name << " and checkSphere results!\n";
+			}
+		}
+		for (auto& [name, path] : paths) {
+			frustum.cullPath = path;
+			double time = measure([&]() { frustum.cullBoxes(boxes, mask); });
+			printResult(name + " boxes", count, time, baseline);
+		}
+
+		std::vector<uint32_t> visibleIndices;
+		frustum.cullPath = bestPath;
+		double time = measure([&]() {
+			frustum.cullSpheres(spheres, mask);
+			vks::Frustum::compactVisible(mask, count, visibleIndices);
+		});
+		printResult("best + compaction", count, time, baseline);
+		std::cout << "  " << visibleIndices.size() << " of " << count << " spheres visible\n";
+	}
+
+	return 0;
+}
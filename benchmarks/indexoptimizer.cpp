@@ -0,0 +1,128 @@
+/*
+* Micro benchmark for the index buffer optimizer
+*
+* Reports the vertex cache efficiency (ACMR/ATVR) of a grid mesh in different triangle orders before and after optimization, and the time the optimization passes take
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+
+#include "indexoptimizer.hpp"
+
+struct Mesh
+{
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	uint32_t vertexCount() const { return static_cast<uint32_t>(positions.size() / 3); }
+};
+
+// Regular grid with size * size quads, bent into a half cylinder so the overdraw pass has something to sort
+Mesh createGrid(uint32_t size)
+{
+	Mesh mesh;
+	for (uint32_t y = 0; y <= size; y++) {
+		for (uint32_t x = 0; x <= size; x++) {
+			const float angle = 3.14159265f * x / size;
+			mesh.positions.insert(mesh.positions.end(), { std::cos(angle), static_cast<float>(y) / size, std::sin(angle) });
+		}
+	}
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			const uint32_t i = y * (size + 1) + x;
+			mesh.indices.insert(mesh.indices.end(), { i, i + 1, i + size + 1, i + 1, i + size + 2, i + size + 1 });
+		}
+	}
+	return mesh;
+}
+
+// Triangles sorted, used to check that an optimization pass only reordered them
+std::vector<std::array<uint32_t, 3>> sortedTriangles(const std::vector<uint32_t>& indices)
+{
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		std::array<uint32_t, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+		// Rotate so the smallest index comes first, which keeps the winding
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+void printStatistics(const std::string& name, const Mesh& mesh, double time = -1.0)
+{
+	const vks::VertexCacheStatistics statistics = vks::IndexOptimizer::analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+	std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3) << "ACMR " << statistics.acmr << "  ATVR " << statistics.atvr;
+	if (time >= 0.0) {
+		std::cout << std::setprecision(2) << "  " << time << " ms";
+	}
+	std::cout << "\n";
+}
+
+int main()
+{
+	std::default_random_engine rndEngine(0);
+	bool valid = true;
+
+	for (uint32_t size : { 64u, 256u, 1024u }) {
+		const Mesh grid = createGrid(size);
+		std::cout << "Grid " << size << "x" << size << " (" << grid.indices.size() / 3 << " triangles, " << grid.vertexCount() << " vertices)\n";
+
+		Mesh shuffled = grid;
+		std::vector<uint32_t> order(shuffled.indices.size() / 3);
+		for (uint32_t i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+		std::shuffle(order.begin(), order.end(), rndEngine);
+		for (size_t i = 0; i < order.size(); i++) {
+			std::copy_n(grid.indices.begin() + order[i] * 3, 3, shuffled.indices.begin() + i * 3);
+		}
+
+		printStatistics("row order", grid);
+		printStatistics("shuffled", shuffled);
+
+		for (const auto& [name, source] : { std::pair<std::string, const Mesh&>{ "row order", grid }, std::pair<std::string, const Mesh&>{ "shuffled", shuffled } }) {
+			Mesh mesh = source;
+			std::vector<uint32_t> clusters;
+			auto tStart = std::chrono::high_resolution_clock::now();
+			vks::IndexOptimizer::optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount(), vks::IndexOptimizer::defaultCacheSize, &clusters);
+			const double tCache = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+			printStatistics(name + " + vertex cache", mesh, tCache);
+			valid &= (sortedTriangles(mesh.indices) == sortedTriangles(source.indices));
+
+			tStart = std::chrono::high_resolution_clock::now();
+			vks::IndexOptimizer::optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.vertexCount(), clusters);
+			const double tOverdraw = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+			printStatistics(name + " + overdraw (" + std::to_string(clusters.size()) + " clusters)", mesh, tOverdraw);
+			valid &= (sortedTriangles(mesh.indices) == sortedTriangles(source.indices));
+
+			// Fetch remapping renumbers the vertices, map the original triangles to compare
+			std::vector<uint32_t> originalIndices = mesh.indices;
+			tStart = std::chrono::high_resolution_clock::now();
+			const std::vector<uint32_t> remap = vks::IndexOptimizer::optimizeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+			const double tFetch = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+			for (uint32_t& index : originalIndices) {
+				index = remap[index];
+			}
+			valid &= (originalIndices == mesh.indices);
+			std::cout << "  " << std::left << std::setw(40) << (name + " + vertex fetch") << std::right << std::setprecision(2) << tFetch << " ms\n";
+		}
+	}
+
+	if (!valid) {
+		std::cout << "Error: Optimized index buffers don't contain the same triangles as the source\n";
+		return 1;
+	}
+	return 0;
+}
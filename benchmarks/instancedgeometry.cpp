@@ -0,0 +1,210 @@
+/*
+* Micro benchmark for glTF geometry sharing
+*
+* Generates glTF scenes with many nodes instancing the same mesh and reports the geometry size and draw count with vkglTF::Model's
+* geometry sharing (mesh loaded once, one instanced draw per primitive) compared to every node storing and drawing its own copy,
+* and the time tinygltf takes to parse the scene. Pass a file name to also write the 500 instance scene for loading it in a sample.
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#define TINYGLTF_NO_EXTERNAL_IMAGE
+#include "tiny_gltf.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstring>
+#include <cmath>
+
+// Size of vkglTF::Vertex, all vertices are expanded to the default layout when loading
+constexpr size_t vertexSize = 96;
+
+struct Sphere
+{
+	std::vector<float> positions;
+	std::vector<float> normals;
+	std::vector<uint32_t> indices;
+	uint32_t vertexCount() const { return static_cast<uint32_t>(positions.size() / 3); }
+};
+
+Sphere createSphere(uint32_t rings, uint32_t segments)
+{
+	Sphere sphere;
+	const float pi = 3.14159265f;
+	for (uint32_t r = 0; r <= rings; r++) {
+		const float theta = pi * r / rings;
+		for (uint32_t s = 0; s <= segments; s++) {
+			const float phi = 2.0f * pi * s / segments;
+			const float normal[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+			sphere.positions.insert(sphere.positions.end(), { normal[0] * 0.5f, normal[1] * 0.5f, normal[2] * 0.5f });
+			sphere.normals.insert(sphere.normals.end(), { normal[0], normal[1], normal[2] });
+		}
+	}
+	for (uint32_t r = 0; r < rings; r++) {
+		for (uint32_t s = 0; s < segments; s++) {
+			const uint32_t i = r * (segments + 1) + s;
+			sphere.indices.insert(sphere.indices.end(), { i, i + segments + 1, i + 1, i + 1, i + segments + 1, i + segments + 2 });
+		}
+	}
+	return sphere;
+}
+
+// Scene with the given number of nodes on a grid, all referring to the same sphere mesh
+tinygltf::Model createScene(const Sphere& sphere, uint32_t instances)
+{
+	tinygltf::Model model;
+	model.asset.version = "2.0";
+	model.asset.generator = "instancedgeometry";
+
+	const size_t positionSize = sphere.positions.size() * sizeof(float);
+	const size_t normalSize = sphere.normals.size() * sizeof(float);
+	const size_t indexSize = sphere.indices.size() * sizeof(uint32_t);
+	tinygltf::Buffer buffer;
+	buffer.data.resize(positionSize + normalSize + indexSize);
+	memcpy(buffer.data.data(), sphere.positions.data(), positionSize);
+	memcpy(buffer.data.data() + positionSize, sphere.normals.data(), normalSize);
+	memcpy(buffer.data.data() + positionSize + normalSize, sphere.indices.data(), indexSize);
+	model.buffers.push_back(buffer);
+
+	auto addView = [&model](size_t offset, size_t length, int target) {
+		tinygltf::BufferView view;
+		view.buffer = 0;
+		view.byteOffset = offset;
+		view.byteLength = length;
+		view.target = target;
+		model.bufferViews.push_back(view);
+	};
+	addView(0, positionSize, TINYGLTF_TARGET_ARRAY_BUFFER);
+	addView(positionSize, normalSize, TINYGLTF_TARGET_ARRAY_BUFFER);
+	addView(positionSize + normalSize, indexSize, TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
+
+	auto addAccessor = [&model](int view, int componentType, size_t count, int type) {
+		tinygltf::Accessor accessor;
+		accessor.bufferView = view;
+		accessor.componentType = componentType;
+		accessor.count = count;
+		accessor.type = type;
+		model.accessors.push_back(accessor);
+	};
+	addAccessor(0, TINYGLTF_COMPONENT_TYPE_FLOAT, sphere.vertexCount(), TINYGLTF_TYPE_VEC3);
+	model.accessors[0].minValues = { -0.5, -0.5, -0.5 };
+	model.accessors[0].maxValues = { 0.5, 0.5, 0.5 };
+	addAccessor(1, TINYGLTF_COMPONENT_TYPE_FLOAT, sphere.vertexCount(), TINYGLTF_TYPE_VEC3);
+	addAccessor(2, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, sphere.indices.size(), TINYGLTF_TYPE_SCALAR);
+
+	tinygltf::Material material;
+	material.name = "default";
+	model.materials.push_back(material);
+
+	tinygltf::Primitive primitive;
+	primitive.attributes["POSITION"] = 0;
+	primitive.attributes["NORMAL"] = 1;
+	primitive.indices = 2;
+	primitive.material = 0;
+	primitive.mode = TINYGLTF_MODE_TRIANGLES;
+	tinygltf::Mesh mesh;
+	mesh.name = "sphere";
+	mesh.primitives.push_back(primitive);
+	model.meshes.push_back(mesh);
+
+	tinygltf::Scene scene;
+	const uint32_t grid = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(instances))));
+	for (uint32_t i = 0; i < instances; i++) {
+		tinygltf::Node node;
+		node.mesh = 0;
+		node.translation = { (static_cast<double>(i % grid) - grid / 2.0) * 1.5, 0.0, (static_cast<double>(i / grid) - grid / 2.0) * 1.5 };
+		model.nodes.push_back(node);
+		scene.nodes.push_back(static_cast<int>(i));
+	}
+	model.scenes.push_back(scene);
+	model.defaultScene = 0;
+	return model;
+}
+
+struct GeometryStatistics
+{
+	size_t sharedSize{ 0 };
+	size_t copiedSize{ 0 };
+	uint32_t sharedDraws{ 0 };
+	uint32_t nodeDraws{ 0 };
+};
+
+// Geometry of a parsed scene if meshes are loaded once per glTF mesh (like vkglTF::Model does) compared to once per node
+GeometryStatistics analyzeScene(const tinygltf::Model& model)
+{
+	std::map<int, uint32_t> meshReferences;
+	for (const tinygltf::Node& node : model.nodes) {
+		if (node.mesh > -1) {
+			meshReferences[node.mesh]++;
+		}
+	}
+	GeometryStatistics statistics;
+	for (const auto& [meshIndex, references] : meshReferences) {
+		size_t meshSize = 0;
+		for (const tinygltf::Primitive& primitive : model.meshes[meshIndex].primitives) {
+			meshSize += model.accessors[primitive.attributes.at("POSITION")].count * vertexSize;
+			if (primitive.indices > -1) {
+				meshSize += model.accessors[primitive.indices].count * sizeof(uint32_t);
+			}
+		}
+		const uint32_t primitiveCount = static_cast<uint32_t>(model.meshes[meshIndex].primitives.size());
+		statistics.sharedSize += meshSize;
+		statistics.copiedSize += meshSize * references;
+		statistics.sharedDraws += primitiveCount;
+		statistics.nodeDraws += primitiveCount * references;
+	}
+	return statistics;
+}
+
+int main(int argc, char* argv[])
+{
+	const Sphere sphere = createSphere(32, 64);
+	std::cout << "Sphere mesh with " << sphere.vertexCount() << " vertices and " << sphere.indices.size() / 3 << " triangles\n";
+
+	tinygltf::TinyGLTF gltfContext;
+	bool valid = true;
+	for (uint32_t instances : { 1u, 100u, 500u, 2000u }) {
+		tinygltf::Model scene = createScene(sphere, instances);
+		std::stringstream stream;
+		gltfContext.WriteGltfSceneToStream(&scene, stream, false, false);
+		const std::string json = stream.str();
+
+		tinygltf::Model parsed;
+		std::string error, warning;
+		auto tStart = std::chrono::high_resolution_clock::now();
+		const bool loaded = gltfContext.LoadASCIIFromString(&parsed, &error, &warning, json.c_str(), static_cast<unsigned int>(json.size()), "");
+		const double tParse = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+		if (!loaded || (parsed.nodes.size() != instances)) {
+			std::cout << "Error: Could not parse the generated scene with " << instances << " instances: " << error << "\n";
+			valid = false;
+			continue;
+		}
+
+		const GeometryStatistics statistics = analyzeScene(parsed);
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "  " << std::right << std::setw(5) << instances << " instances: parse " << std::setprecision(2) << tParse << " ms, ";
+		std::cout << std::setprecision(1) << "geometry " << statistics.sharedSize / 1024.0 << " KiB shared vs. " << statistics.copiedSize / 1024.0 << " KiB copied per node, ";
+		std::cout << statistics.sharedDraws << " instanced draws vs. " << statistics.nodeDraws << " draws per node\n";
+
+		if ((argc > 1) && (instances == 500)) {
+			if (gltfContext.WriteGltfSceneToFile(&scene, argv[1], true, true, true, false)) {
+				std::cout << "  Wrote the scene to \"" << argv[1] << "\"\n";
+			} else {
+				std::cout << "Error: Could not write the scene to \"" << argv[1] << "\"\n";
+				valid = false;
+			}
+		}
+	}
+
+	return valid ? 0 : 1;
+}
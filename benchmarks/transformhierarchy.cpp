@@ -0,0 +1,195 @@
+/*
+* Micro benchmark for the flattened transform hierarchy
+*
+* Compares world matrix updates of a large node hierarchy walking the parent chain per node (like vkglTF::Node::getMatrix), a recursive
+* traversal of a pointer based tree and the linear pass of vks::TransformHierarchy with all nodes or only a few animated nodes changing
+*
+* Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cmath>
+
+#include "transformhierarchy.hpp"
+
+// Runs the function repeatedly for at least the given time and returns the average time per call in milliseconds
+double measure(const std::function<void()>& func, double minTime = 250.0)
+{
+	// Warm up
+	func();
+	uint32_t iterations = 0;
+	auto tStart = std::chrono::high_resolution_clock::now();
+	double elapsed = 0.0;
+	do {
+		func();
+		iterations++;
+		elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+	} while (elapsed < minTime);
+	return elapsed / iterations;
+}
+
+// Pointer based node like vkglTF::Node, allocated individually
+struct Node
+{
+	Node* parent{ nullptr };
+	std::vector<Node*> children;
+	glm::vec3 translation{};
+	glm::quat rotation{};
+	glm::vec3 scale{ 1.0f };
+	glm::mat4 world{ 1.0f };
+
+	glm::mat4 localMatrix() const
+	{
+		return glm::translate(glm::mat4(1.0f), translation) * glm::mat4(rotation) * glm::scale(glm::mat4(1.0f), scale);
+	}
+
+	glm::mat4 getMatrix() const
+	{
+		glm::mat4 m = localMatrix();
+		const Node* p = parent;
+		while (p) {
+			m = p->localMatrix() * m;
+			p = p->parent;
+		}
+		return m;
+	}
+
+	void updateRecursive(const glm::mat4& parentMatrix)
+	{
+		world = parentMatrix * localMatrix();
+		for (Node* child : children) {
+			child->updateRecursive(world);
+		}
+	}
+};
+
+bool equal(const glm::mat4& a, const glm::mat4& b)
+{
+	for (int c = 0; c < 4; c++) {
+		for (int r = 0; r < 4; r++) {
+			if (std::abs(a[c][r] - b[c][r]) > 1e-3f * std::max(1.0f, std::abs(a[c][r]))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	std::default_random_engine rndEngine(0);
+	std::uniform_real_distribution<float> rndOffset(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> rndAngle(0.0f, 6.2831853f);
+	std::uniform_real_distribution<float> rndScale(0.95f, 1.05f);
+	bool valid = true;
+
+	for (uint32_t nodeCount : { 1000u, 10000u, 50000u }) {
+		// Random forest with one root per 1000 nodes, parents are picked from the preceding nodes of the same tree (depth grows logarithmically)
+		std::vector<std::unique_ptr<Node>> nodes;
+		std::vector<Node*> roots;
+		std::vector<uint32_t> parents(nodeCount);
+		for (uint32_t i = 0; i < nodeCount; i++) {
+			std::unique_ptr<Node> node = std::make_unique<Node>();
+			node->translation = glm::vec3(rndOffset(rndEngine), rndOffset(rndEngine), rndOffset(rndEngine));
+			node->rotation = glm::angleAxis(rndAngle(rndEngine), glm::normalize(glm::vec3(rndOffset(rndEngine), 1.0f, rndOffset(rndEngine))));
+			node->scale = glm::vec3(rndScale(rndEngine));
+			if ((i % 1000) == 0) {
+				parents[i] = vks::TransformHierarchy::noParent;
+				roots.push_back(node.get());
+			} else {
+				std::uniform_int_distribution<uint32_t> rndParent(i - (i % 1000), i - 1);
+				parents[i] = rndParent(rndEngine);
+				node->parent = nodes[parents[i]].get();
+				node->parent->children.push_back(node.get());
+			}
+			nodes.push_back(std::move(node));
+		}
+
+		// The flattened hierarchy requires parents before children, which the generated order already satisfies
+		vks::TransformHierarchy hierarchy;
+		hierarchy.reserve(nodeCount);
+		for (uint32_t i = 0; i < nodeCount; i++) {
+			hierarchy.add(parents[i], nodes[i]->translation, nodes[i]->rotation, nodes[i]->scale);
+		}
+		hierarchy.update();
+
+		// Animate one percent of the nodes
+		std::vector<uint32_t> animated;
+		for (uint32_t i = 0; i < nodeCount; i += 100) {
+			animated.push_back(i + 50);
+		}
+
+		std::cout << nodeCount << " nodes\n";
+		std::cout << std::fixed << std::setprecision(4);
+
+		std::vector<glm::mat4> chainMatrices(nodeCount);
+		const double tChain = measure([&]() {
+			for (uint32_t i = 0; i < nodeCount; i++) {
+				chainMatrices[i] = nodes[i]->getMatrix();
+			}
+		});
+		std::cout << "  parent chain per node    " << std::setw(10) << tChain << " ms\n";
+
+		const double tRecursive = measure([&]() {
+			for (Node* root : roots) {
+				root->updateRecursive(glm::mat4(1.0f));
+			}
+		});
+		std::cout << "  recursive traversal      " << std::setw(10) << tRecursive << " ms\n";
+
+		uint32_t updatedAll = 0;
+		const double tFlatAll = measure([&]() {
+			for (uint32_t i = 0; i < nodeCount; i++) {
+				hierarchy.setRotation(i, hierarchy.rotations[i]);
+			}
+			updatedAll = hierarchy.update();
+		});
+		std::cout << "  flattened, all dirty     " << std::setw(10) << tFlatAll << " ms (" << updatedAll << " world matrices)\n";
+
+		uint32_t updatedPartial = 0;
+		float angle = 0.0f;
+		const double tFlatPartial = measure([&]() {
+			angle += 0.01f;
+			const glm::quat rotation = glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			for (uint32_t index : animated) {
+				hierarchy.setRotation(index, rotation);
+			}
+			updatedPartial = hierarchy.update();
+		});
+		std::cout << "  flattened, " << std::setw(5) << animated.size() << " animated " << std::setw(10) << tFlatPartial << " ms (" << updatedPartial << " world matrices)\n";
+		std::cout << "  speedup over parent chain " << std::setprecision(1) << tChain / tFlatAll << "x (all dirty), " << tChain / tFlatPartial << "x (animated)\n";
+
+		// Apply the last animated rotations to the pointer tree and compare against both reference paths
+		for (uint32_t index : animated) {
+			nodes[index]->rotation = hierarchy.rotations[index];
+		}
+		for (Node* root : roots) {
+			root->updateRecursive(glm::mat4(1.0f));
+		}
+		for (uint32_t i = 0; i < nodeCount; i++) {
+			valid &= equal(nodes[i]->world, hierarchy.worldMatrices[i]);
+			valid &= equal(nodes[i]->getMatrix(), hierarchy.worldMatrices[i]);
+		}
+	}
+
+	if (!valid) {
+		std::cout << "Error: World matrices of the flattened hierarchy don't match the pointer based hierarchy\n";
+		return 1;
+	}
+	return 0;
+}
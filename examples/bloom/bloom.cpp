@@ -555,6 +555,7 @@ public:
 			While it's possible to blur in one pass, this method is widely used as it requires far less samples to generate the blur
 		*/
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
+		gpuProfiler.beginFrame(cmdBuffer, currentBuffer);
 
 		if (bloom) {
 			VkClearValue clearValues[2]{};
@@ -578,6 +579,7 @@ public:
 				First render pass: Render glow parts of the model (separate mesh) to an offscreen frame buffer
 			*/
 
+			gpuProfiler.beginRegion(cmdBuffer, "Glow");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets[currentBuffer].scene, 0, nullptr);
@@ -586,6 +588,7 @@ public:
 			models.ufoGlow.draw(cmdBuffer);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 
 			/*
 				Second render pass: Vertical blur
@@ -596,6 +599,7 @@ public:
 
 			renderPassBeginInfo.framebuffer = offscreenPass.framebuffers[1].framebuffer;
 
+			gpuProfiler.beginRegion(cmdBuffer, "Vertical blur");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.blur, 0, 1, &descriptorSets[currentBuffer].blurVert, 0, nullptr);
@@ -603,6 +607,7 @@ public:
 			vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 		}
 
 		/*
@@ -628,6 +633,7 @@ public:
 			renderPassBeginInfo.clearValueCount = 2;
 			renderPassBeginInfo.pClearValues = clearValues;
 
+			gpuProfiler.beginRegion(cmdBuffer, "Scene and horizontal blur");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
@@ -654,9 +660,11 @@ public:
 			drawUI(cmdBuffer);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 
 		}
 
+		gpuProfiler.endFrame(cmdBuffer);
 		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
@@ -107,7 +107,7 @@ public:
 
 		void loadAssets()
 	{
-		scene.loadFromFile(getAssetPath() + "models/gltf/glTF-Embedded/Buggy.gltf", vulkanDevice, queue);
+		scene.loadFromFile(getAssetPath() + "models/gltf/glTF-Embedded/Buggy.gltf", vulkanDevice, queue, vkglTF::FileLoadingFlags::NodeUniformBuffers);
 	}
 
 	void setupDescriptors()
@@ -613,6 +613,7 @@ public:
 		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
+		gpuProfiler.beginFrame(cmdBuffer, currentBuffer);
 
 		// First render pass : Offscreen pass to fill deferred attachments
 		{
@@ -631,6 +632,7 @@ public:
 			renderPassBeginInfo.clearValueCount = 4;
 			renderPassBeginInfo.pClearValues = clearValues;
 
+			gpuProfiler.beginRegion(cmdBuffer, "G-Buffer");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 			VkViewport viewport = vks::initializers::viewport((float)offScreenFrameBuf.width, (float)offScreenFrameBuf.height, 0.0f, 1.0f);
 			vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
@@ -645,6 +647,7 @@ public:
 			models.model.bindBuffers(cmdBuffer);
 			vkCmdDrawIndexed(cmdBuffer, models.model.indices.count, 3, 0, 0, 0);
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 		}
 
 		// Second render pass: Composition
@@ -665,6 +668,7 @@ public:
 			renderPassBeginInfo.pClearValues = clearValues;
 			renderPassBeginInfo.framebuffer = frameBuffers[currentImageIndex];
 
+			gpuProfiler.beginRegion(cmdBuffer, "Composition");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 			VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
 			vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
@@ -679,9 +683,10 @@ public:
 			vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
 			drawUI(cmdBuffer);
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 		}
 
-
+		gpuProfiler.endFrame(cmdBuffer);
 		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
@@ -324,10 +324,7 @@ public:
 		}
 		memcpy(uniformBuffers[currentBuffer].dynamic.mapped, uboDataDynamic.model, uniformBuffers[currentBuffer].dynamic.size);
 		// Flush to make changes visible to the host
-		VkMappedMemoryRange memoryRange = vks::initializers::mappedMemoryRange();
-		memoryRange.memory = uniformBuffers[currentBuffer].dynamic.memory;
-		memoryRange.size = uniformBuffers[currentBuffer].dynamic.size;
-		vkFlushMappedMemoryRanges(device, 1, &memoryRange);
+		uniformBuffers[currentBuffer].dynamic.flush(uniformBuffers[currentBuffer].dynamic.size);
 	}
 
 	void prepare()
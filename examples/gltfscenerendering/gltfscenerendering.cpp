@@ -28,11 +28,8 @@ VulkanglTFScene::~VulkanglTFScene()
 	vkFreeMemory(vulkanDevice->logicalDevice, vertices.memory, nullptr);
 	vkDestroyBuffer(vulkanDevice->logicalDevice, indices.buffer, nullptr);
 	vkFreeMemory(vulkanDevice->logicalDevice, indices.memory, nullptr);
-	for (Image image : images) {
-		vkDestroyImageView(vulkanDevice->logicalDevice, image.texture.view, nullptr);
-		vkDestroyImage(vulkanDevice->logicalDevice, image.texture.image, nullptr);
-		vkDestroySampler(vulkanDevice->logicalDevice, image.texture.sampler, nullptr);
-		vkFreeMemory(vulkanDevice->logicalDevice, image.texture.deviceMemory, nullptr);
+	for (auto& image : images) {
+		image.texture.destroy();
 	}
 	for (Material material : materials) {
 		vkDestroyPipeline(vulkanDevice->logicalDevice, material.pipeline, nullptr);
@@ -274,10 +271,115 @@ void VulkanglTFScene::draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipel
 	VkDeviceSize offsets[1] = { 0 };
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices.buffer, offsets);
 	vkCmdBindIndexBuffer(commandBuffer, indices.buffer, 0, VK_INDEX_TYPE_UINT32);
-	// Render all nodes at top-level
+	if (!useDrawList) {
+		// Render all nodes at top-level
+		for (auto& node : nodes) {
+			drawNode(commandBuffer, pipelineLayout, node);
+		}
+		return;
+	}
+	if (drawListDirty) {
+		buildDrawList();
+	}
+	// POI: As the draw list is sorted, pipelines, descriptor sets and matrices only need to be bound when they change
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkDescriptorSet boundDescriptorSet = VK_NULL_HANDLE;
+	uint32_t boundMatrix = ~0u;
+	for (const DrawCommand& command : drawList) {
+		if (command.pipeline != boundPipeline) {
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, command.pipeline);
+			boundPipeline = command.pipeline;
+		}
+		if (command.descriptorSet != boundDescriptorSet) {
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &command.descriptorSet, 0, nullptr);
+			boundDescriptorSet = command.descriptorSet;
+		}
+		if (command.matrixIndex != boundMatrix) {
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &drawMatrices[command.matrixIndex]);
+			boundMatrix = command.matrixIndex;
+		}
+		vkCmdDrawIndexed(commandBuffer, command.indexCount, 1, command.firstIndex, 0, 0);
+	}
+}
+
+// Add the primitives of a visible node and its children to the draw list, also counts the commands drawNode would record for the same nodes
+void VulkanglTFScene::collectDrawCommands(VulkanglTFScene::Node* node, const glm::mat4& parentMatrix)
+{
+	if (!node->visible) {
+		return;
+	}
+	const glm::mat4 nodeMatrix = parentMatrix * node->matrix;
+	if (node->mesh.primitives.size() > 0) {
+		const uint32_t matrixIndex = static_cast<uint32_t>(drawMatrices.size());
+		drawMatrices.push_back(nodeMatrix);
+		hierarchyStatistics.pushConstants++;
+		for (VulkanglTFScene::Primitive& primitive : node->mesh.primitives) {
+			if (primitive.indexCount > 0) {
+				const VulkanglTFScene::Material& material = materials[primitive.materialIndex];
+				std::vector<DrawCommand>& target = (material.alphaMode == "BLEND") ? blendedDrawList : drawList;
+				target.push_back({ material.pipeline, material.descriptorSet, primitive.firstIndex, primitive.indexCount, matrixIndex });
+				hierarchyStatistics.pipelineBinds++;
+				hierarchyStatistics.descriptorSetBinds++;
+				hierarchyStatistics.draws++;
+			}
+		}
+	}
+	for (auto& child : node->children) {
+		collectDrawCommands(child, nodeMatrix);
+	}
+}
+
+void VulkanglTFScene::buildDrawList()
+{
+	drawList.clear();
+	blendedDrawList.clear();
+	drawMatrices.clear();
+	hierarchyStatistics = {};
+	drawListStatistics = {};
 	for (auto& node : nodes) {
-		drawNode(commandBuffer, pipelineLayout, node);
+		collectDrawCommands(node, glm::mat4(1.0f));
+	}
+
+	// Opaque and masked primitives are sorted by pipeline, then material, then geometry to minimize state changes, blended primitives go last
+	std::sort(drawList.begin(), drawList.end(), [](const DrawCommand& a, const DrawCommand& b) {
+		if (a.pipeline != b.pipeline) {
+			return a.pipeline < b.pipeline;
+		}
+		if (a.descriptorSet != b.descriptorSet) {
+			return a.descriptorSet < b.descriptorSet;
+		}
+		if (a.firstIndex != b.firstIndex) {
+			return a.firstIndex < b.firstIndex;
+		}
+		return a.matrixIndex < b.matrixIndex;
+	});
+	firstBlendedDraw = static_cast<uint32_t>(drawList.size());
+	drawList.insert(drawList.end(), blendedDrawList.begin(), blendedDrawList.end());
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	uint32_t matrixIndex = ~0u;
+	for (const DrawCommand& command : drawList) {
+		drawListStatistics.pipelineBinds += (command.pipeline != pipeline) ? 1 : 0;
+		drawListStatistics.descriptorSetBinds += (command.descriptorSet != descriptorSet) ? 1 : 0;
+		drawListStatistics.pushConstants += (command.matrixIndex != matrixIndex) ? 1 : 0;
+		pipeline = command.pipeline;
+		descriptorSet = command.descriptorSet;
+		matrixIndex = command.matrixIndex;
 	}
+	drawListStatistics.draws = static_cast<uint32_t>(drawList.size());
+	drawListDirty = false;
+}
+
+// Blended primitives need to be drawn back to front, so their order depends on the camera position
+void VulkanglTFScene::sortBlendedDraws(const glm::vec3& viewPos)
+{
+	if (drawListDirty) {
+		buildDrawList();
+	}
+	std::sort(drawList.begin() + firstBlendedDraw, drawList.end(), [this, &viewPos](const DrawCommand& a, const DrawCommand& b) {
+		return glm::distance(glm::vec3(drawMatrices[a.matrixIndex][3]), viewPos) > glm::distance(glm::vec3(drawMatrices[b.matrixIndex][3]), viewPos);
+	});
 }
 
 /*
@@ -613,6 +715,7 @@ void VulkanExample::buildCommandBuffer()
 	vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentBuffer], 0, nullptr);
 
 	// POI: Draw the glTF scene
+	glTFScene.sortBlendedDraws(glm::vec3(camera.viewPos));
 	glTFScene.draw(cmdBuffer, pipelineLayout);
 
 	drawUI(cmdBuffer);
@@ -634,10 +737,12 @@ void VulkanExample::OnUpdateUIOverlay(vks::UIOverlay* overlay)
 
 		if (overlay->button("All")) {
 			std::for_each(glTFScene.nodes.begin(), glTFScene.nodes.end(), [](VulkanglTFScene::Node* node) { node->visible = true; });
+			glTFScene.drawListDirty = true;
 		}
 		ImGui::SameLine();
 		if (overlay->button("None")) {
 			std::for_each(glTFScene.nodes.begin(), glTFScene.nodes.end(), [](VulkanglTFScene::Node* node) { node->visible = false; });
+			glTFScene.drawListDirty = true;
 		}
 		ImGui::NewLine();
 
@@ -645,10 +750,22 @@ void VulkanExample::OnUpdateUIOverlay(vks::UIOverlay* overlay)
 		ImGui::BeginChild("#nodelist", ImVec2(200.0f * overlay->scale, 340.0f * overlay->scale), false);
 		for (auto& node : glTFScene.nodes)
 		{		
-			overlay->checkBox(node->name.c_str(), &node->visible);
+			if (overlay->checkBox(node->name.c_str(), &node->visible)) {
+				glTFScene.drawListDirty = true;
+			}
 		}
 		ImGui::EndChild();
 	}
+	if (overlay->header("Draw list")) {
+		overlay->checkBox("Sorted draw list", &glTFScene.useDrawList);
+		if (glTFScene.drawListDirty) {
+			glTFScene.buildDrawList();
+		}
+		const VulkanglTFScene::DrawStatistics& hierarchy = glTFScene.hierarchyStatistics;
+		const VulkanglTFScene::DrawStatistics& sorted = glTFScene.drawListStatistics;
+		overlay->text("Hierarchy: %d pipelines, %d sets, %d push constants, %d draws", hierarchy.pipelineBinds, hierarchy.descriptorSetBinds, hierarchy.pushConstants, hierarchy.draws);
+		overlay->text("Sorted: %d pipelines, %d sets, %d push constants, %d draws", sorted.pipelineBinds, sorted.descriptorSetBinds, sorted.pushConstants, sorted.draws);
+	}
 }
 
 VULKAN_EXAMPLE_MAIN()
@@ -119,6 +119,32 @@ public:
 	std::vector<Material> materials;
 	std::vector<Node*> nodes;
 
+	// POI: Instead of walking the node hierarchy for every draw, the visible primitives are compiled into a draw list sorted by pipeline, material and geometry
+	// The list only needs to be rebuilt if the scene changes (e.g. the visibility of a node)
+	struct DrawCommand {
+		VkPipeline pipeline;
+		VkDescriptorSet descriptorSet;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t matrixIndex;
+	};
+	std::vector<DrawCommand> drawList;
+	std::vector<DrawCommand> blendedDrawList;
+	// Blended primitives are stored at the end of the draw list and sorted back to front
+	uint32_t firstBlendedDraw{ 0 };
+	// World matrices of the nodes referenced by the draw list, passed via push constants
+	std::vector<glm::mat4> drawMatrices;
+	bool useDrawList = true;
+	bool drawListDirty = true;
+
+	// Commands recorded for drawing the scene in hierarchy order and with the draw list
+	struct DrawStatistics {
+		uint32_t pipelineBinds{ 0 };
+		uint32_t descriptorSetBinds{ 0 };
+		uint32_t pushConstants{ 0 };
+		uint32_t draws{ 0 };
+	} hierarchyStatistics, drawListStatistics;
+
 	std::string path;
 
 	~VulkanglTFScene();
@@ -129,6 +155,9 @@ public:
 	void loadNode(const tinygltf::Node& inputNode, const tinygltf::Model& input, VulkanglTFScene::Node* parent, std::vector<uint32_t>& indexBuffer, std::vector<VulkanglTFScene::Vertex>& vertexBuffer);
 	void drawNode(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VulkanglTFScene::Node* node);
 	void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
+	void collectDrawCommands(VulkanglTFScene::Node* node, const glm::mat4& parentMatrix);
+	void buildDrawList();
+	void sortBlendedDraws(const glm::vec3& viewPos);
 };
 
 class VulkanExample : public VulkanExampleBase
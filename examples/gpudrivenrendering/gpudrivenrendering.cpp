@@ -0,0 +1,528 @@
+/*
+ * Vulkan Example - GPU driven rendering of a glTF scene
+ *
+ * All materials of the scene are stored in one storage buffer and all of its textures in one variable sized descriptor array (vkglTF::FileLoadingFlags::BindlessMaterials)
+ * The whole scene is drawn with a single descriptor set for the materials, draws only select their material with a push constant
+ * With GPU culling enabled the primitives are frustum culled in a compute shader and the visible ones are drawn with a single indirect count draw (vks::GpuCulling),
+ * the material of each draw is then selected in the vertex shader with gl_DrawID
+ * Occlusion culling splits the frame into two phases: The early draws are tested against a depth pyramid (Hi-Z) built in the previous frame, the depth buffer they
+ * write is reduced into a new pyramid and the primitives rejected by the early phase are tested again against it and drawn in a second render pass (late draws)
+ *
+ * Copyright (C) 2025 by Sascha Willems - www.saschawillems.de
+ *
+ * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+ */
+
+#include "vulkanexamplebase.h"
+#include "VulkanglTFModel.h"
+#include "VulkanGpuCulling.h"
+
+class VulkanExample : public VulkanExampleBase
+{
+public:
+	vkglTF::Model scene;
+	vks::GpuCulling gpuCulling;
+	bool useGpuCulling{ true };
+
+	struct UniformData {
+		glm::mat4 projection;
+		glm::mat4 view;
+		glm::vec4 lightPos{ 0.0f, 2.5f, 0.0f, 1.0f };
+		glm::vec4 viewPos;
+	} uniformData;
+	std::array<vks::Buffer, maxConcurrentFrames> uniformBuffers;
+
+	// The culled pipeline selects the material from the draws compacted on the GPU instead of a push constant
+	struct Pipelines {
+		VkPipeline scene{ VK_NULL_HANDLE };
+		VkPipeline culled{ VK_NULL_HANDLE };
+	} pipelines;
+	struct PipelineLayouts {
+		VkPipelineLayout scene{ VK_NULL_HANDLE };
+		VkPipelineLayout culled{ VK_NULL_HANDLE };
+	} pipelineLayouts;
+	struct DescriptorSetLayouts {
+		VkDescriptorSetLayout scene{ VK_NULL_HANDLE };
+		VkDescriptorSetLayout culled{ VK_NULL_HANDLE };
+	} descriptorSetLayouts;
+	struct DescriptorSets {
+		VkDescriptorSet scene{ VK_NULL_HANDLE };
+		VkDescriptorSet culled{ VK_NULL_HANDLE };
+	};
+	std::array<DescriptorSets, maxConcurrentFrames> descriptorSets{};
+
+	// With occlusion culling the frame is split into a render pass for the early draws, that keeps the depth buffer for building the depth pyramid, and one for the late draws
+	struct RenderPasses {
+		VkRenderPass early{ VK_NULL_HANDLE };
+		VkRenderPass late{ VK_NULL_HANDLE };
+	} renderPasses;
+	// The depth buffer is sampled for the depth pyramid, which requires a view with only the depth aspect
+	VkImageView depthSampleView{ VK_NULL_HANDLE };
+	VkPipelineShaderStageCreateInfo depthDownsampleShaderStage{};
+
+	VkPhysicalDeviceVulkan11Features enabledFeatures11{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES };
+	VkPhysicalDeviceVulkan12Features enabledFeatures12{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+
+	VulkanExample() : VulkanExampleBase()
+	{
+		title = "GPU driven rendering";
+		camera.type = Camera::CameraType::firstperson;
+		camera.flipY = true;
+		camera.setPosition(glm::vec3(0.0f, 1.0f, 0.0f));
+		camera.setRotation(glm::vec3(0.0f, -90.0f, 0.0f));
+		camera.setPerspective(60.0f, (float)width / (float)height, 0.1f, 256.0f);
+
+		// Descriptor indexing and indirect count draws are core with Vulkan 1.2
+		apiVersion = VK_API_VERSION_1_2;
+
+		// The material textures are accessed through a runtime sized descriptor array, which is sized per model at allocation time and not all of its elements may be written
+		enabledFeatures12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		enabledFeatures12.runtimeDescriptorArray = VK_TRUE;
+		enabledFeatures12.descriptorBindingVariableDescriptorCount = VK_TRUE;
+		enabledFeatures12.descriptorBindingPartiallyBound = VK_TRUE;
+		// The culled pipeline reads the material of a draw with gl_DrawID
+		enabledFeatures11.shaderDrawParameters = VK_TRUE;
+		enabledFeatures11.pNext = &enabledFeatures12;
+
+		deviceCreatepNextChain = &enabledFeatures11;
+
+#if (defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK) || defined(VK_USE_PLATFORM_METAL_EXT))
+		// Use layer settings extension to configure MoltenVK
+		enabledInstanceExtensions.push_back(VK_EXT_LAYER_SETTINGS_EXTENSION_NAME);
+
+		// Configure MoltenVK to use Metal argument buffers (needed for descriptor indexing)
+		VkLayerSettingEXT layerSetting;
+		layerSetting.pLayerName = "MoltenVK";
+		layerSetting.pSettingName = "MVK_CONFIG_USE_METAL_ARGUMENT_BUFFERS";
+		layerSetting.type = VK_LAYER_SETTING_TYPE_BOOL32_EXT;
+		layerSetting.valueCount = 1;
+
+		// Make this static so layer setting reference remains valid after leaving constructor scope
+		static const VkBool32 layerSettingOn = VK_TRUE;
+		layerSetting.pValues = &layerSettingOn;
+		enabledLayerSettings.push_back(layerSetting);
+#endif
+	}
+
+	~VulkanExample()
+	{
+		if (device) {
+			gpuCulling.destroy();
+			vkDestroyRenderPass(device, renderPasses.early, nullptr);
+			vkDestroyRenderPass(device, renderPasses.late, nullptr);
+			vkDestroyImageView(device, depthSampleView, nullptr);
+			vkDestroyPipeline(device, pipelines.scene, nullptr);
+			vkDestroyPipeline(device, pipelines.culled, nullptr);
+			vkDestroyPipelineLayout(device, pipelineLayouts.scene, nullptr);
+			vkDestroyPipelineLayout(device, pipelineLayouts.culled, nullptr);
+			vkDestroyDescriptorSetLayout(device, descriptorSetLayouts.scene, nullptr);
+			vkDestroyDescriptorSetLayout(device, descriptorSetLayouts.culled, nullptr);
+			for (auto& buffer : uniformBuffers) {
+				buffer.destroy();
+			}
+		}
+	}
+
+	virtual void getEnabledFeatures()
+	{
+		if (deviceFeatures.samplerAnisotropy) {
+			enabledFeatures.samplerAnisotropy = VK_TRUE;
+		}
+		// Adds drawIndirectCount to the Vulkan 1.2 features or VK_KHR_draw_indirect_count to the device extensions, the scene is drawn on the CPU if neither is supported
+		vks::GpuCulling::getEnabledFeatures(physicalDevice, apiVersion, enabledFeatures12, enabledDeviceExtensions);
+	}
+
+	void loadAssets()
+	{
+		// Vertices are not pre-transformed, the vertex shader applies the node matrices from the model's node storage buffer
+		scene.loadFromFile(getAssetPath() + "models/sponza/sponza.gltf", vulkanDevice, queue, vkglTF::FileLoadingFlags::BindlessMaterials | vkglTF::FileLoadingFlags::NodeStorageBuffers);
+		gpuCulling.create(vulkanDevice, &scene, loadShader(getShadersPath() + "base/gltfcull.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT));
+		useGpuCulling = gpuCulling.enabled;
+		if (gpuCulling.enabled) {
+			depthDownsampleShaderStage = loadShader(getShadersPath() + "base/hizdownsample.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+			gpuCulling.setDepthSource(depthSampleView, width, height, depthDownsampleShaderStage);
+		}
+	}
+
+	// Same as the base class depth buffer, but it's also sampled to build the depth pyramid for occlusion culling
+	void setupDepthStencil()
+	{
+		if (depthSampleView != VK_NULL_HANDLE) {
+			vkDestroyImageView(device, depthSampleView, nullptr);
+		}
+		VkImageCreateInfo imageCI = vks::initializers::imageCreateInfo();
+		imageCI.imageType = VK_IMAGE_TYPE_2D;
+		imageCI.format = depthFormat;
+		imageCI.extent = { width, height, 1 };
+		imageCI.mipLevels = 1;
+		imageCI.arrayLayers = 1;
+		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCI.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		VK_CHECK_RESULT(vkCreateImage(device, &imageCI, nullptr, &depthStencil.image));
+		VkMemoryRequirements memReqs{};
+		vkGetImageMemoryRequirements(device, depthStencil.image, &memReqs);
+		VkMemoryAllocateInfo memAllloc = vks::initializers::memoryAllocateInfo();
+		memAllloc.allocationSize = memReqs.size;
+		memAllloc.memoryTypeIndex = vulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		VK_CHECK_RESULT(vkAllocateMemory(device, &memAllloc, nullptr, &depthStencil.memory));
+		VK_CHECK_RESULT(vkBindImageMemory(device, depthStencil.image, depthStencil.memory, 0));
+
+		VkImageViewCreateInfo imageViewCI = vks::initializers::imageViewCreateInfo();
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		imageViewCI.image = depthStencil.image;
+		imageViewCI.format = depthFormat;
+		imageViewCI.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+		VK_CHECK_RESULT(vkCreateImageView(device, &imageViewCI, nullptr, &depthSampleView));
+		// Stencil aspect should only be set on depth + stencil formats (VK_FORMAT_D16_UNORM_S8_UINT..VK_FORMAT_D32_SFLOAT_S8_UINT
+		if (depthFormat >= VK_FORMAT_D16_UNORM_S8_UINT) {
+			imageViewCI.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+		VK_CHECK_RESULT(vkCreateImageView(device, &imageViewCI, nullptr, &depthStencil.view));
+	}
+
+	// The base class render pass is used if occlusion culling is disabled, the early and late render passes are compatible with it and share its frame buffers
+	void setupRenderPass()
+	{
+		VulkanExampleBase::setupRenderPass();
+
+		std::array<VkAttachmentDescription, 2> attachments{};
+		attachments[0].format = swapChain.colorFormat;
+		attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachments[1].format = depthFormat;
+		attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		// Read by the depth pyramid downsample shader
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+		VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+		VkSubpassDescription subpassDescription{};
+		subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpassDescription.colorAttachmentCount = 1;
+		subpassDescription.pColorAttachments = &colorReference;
+		subpassDescription.pDepthStencilAttachment = &depthReference;
+
+		std::array<VkSubpassDependency, 2> dependencies{};
+		// Depth and color writes of the previous pass, the compute stage is included so the depth layout transition of the late pass waits for the downsample shader
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+		// The depth pyramid is built from the depth buffer of the early pass in a compute shader
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+		VkRenderPassCreateInfo renderPassInfo = vks::initializers::renderPassCreateInfo();
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpassDescription;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
+		VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPasses.early));
+
+		// The late pass continues with the results of the early pass and presents them
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPasses.late));
+	}
+
+	void windowResized()
+	{
+		// The depth pyramid has to match the recreated depth buffer
+		const bool occlusionCulling = gpuCulling.occlusionCulling;
+		gpuCulling.setDepthSource(depthSampleView, width, height, depthDownsampleShaderStage);
+		gpuCulling.occlusionCulling = occlusionCulling;
+	}
+
+	void setupDescriptors()
+	{
+		// Pool
+		std::vector<VkDescriptorPoolSize> poolSizes = {
+			vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, maxConcurrentFrames * 2),
+			vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxConcurrentFrames),
+		};
+		VkDescriptorPoolCreateInfo descriptorPoolInfo = vks::initializers::descriptorPoolCreateInfo(poolSizes, maxConcurrentFrames * 2);
+		VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorPool));
+		// Layouts
+		std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
+			vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0),
+		};
+		VkDescriptorSetLayoutCreateInfo descriptorLayout = vks::initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorLayout, nullptr, &descriptorSetLayouts.scene));
+		// The culled pipeline additionally reads the material indices of the compacted draws
+		setLayoutBindings.push_back(vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1));
+		descriptorLayout = vks::initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorLayout, nullptr, &descriptorSetLayouts.culled));
+		// Sets per frame, just like the buffers themselves
+		for (auto i = 0; i < uniformBuffers.size(); i++) {
+			VkDescriptorSetAllocateInfo allocInfo = vks::initializers::descriptorSetAllocateInfo(descriptorPool, &descriptorSetLayouts.scene, 1);
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets[i].scene));
+			std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
+				vks::initializers::writeDescriptorSet(descriptorSets[i].scene, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &uniformBuffers[i].descriptor),
+			};
+			vkUpdateDescriptorSets(device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+			if (gpuCulling.enabled) {
+				allocInfo = vks::initializers::descriptorSetAllocateInfo(descriptorPool, &descriptorSetLayouts.culled, 1);
+				VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets[i].culled));
+				// The cull buffers are created per node storage buffer, so the frame index selects both
+				VkDescriptorBufferInfo materialBufferInfo = gpuCulling.getMaterialBufferInfo(i);
+				writeDescriptorSets = {
+					vks::initializers::writeDescriptorSet(descriptorSets[i].culled, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &uniformBuffers[i].descriptor),
+					vks::initializers::writeDescriptorSet(descriptorSets[i].culled, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &materialBufferInfo),
+				};
+				vkUpdateDescriptorSets(device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+			}
+		}
+	}
+
+	void preparePipelines()
+	{
+		// Layouts
+		// Set 0 = scene uniform buffer, set 1 = node storage buffer (taken from the glTF model), set 2 = material buffer and texture array (taken from the glTF model)
+		std::vector<VkDescriptorSetLayout> setLayouts = {
+			descriptorSetLayouts.scene,
+			vkglTF::descriptorSetLayoutNodes,
+			vkglTF::descriptorSetLayoutBindless,
+		};
+		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = vks::initializers::pipelineLayoutCreateInfo(setLayouts.data(), static_cast<uint32_t>(setLayouts.size()));
+		// The material index of a draw is passed as a push constant
+		VkPushConstantRange pushConstantRange = vks::initializers::pushConstantRange(VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(uint32_t), scene.materialPushConstantOffset);
+		pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+		pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+		VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayouts.scene));
+		// The culled pipeline passes the index of the first draw of an indirect count draw instead
+		setLayouts[0] = descriptorSetLayouts.culled;
+		pushConstantRange = vks::initializers::pushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, sizeof(uint32_t), 0);
+		VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayouts.culled));
+
+		// Pipeline
+		VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = vks::initializers::pipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+		// Sponza contains double sided materials, as all materials share one pipeline back face culling is disabled
+		VkPipelineRasterizationStateCreateInfo rasterizationState = vks::initializers::pipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+		VkPipelineColorBlendAttachmentState blendAttachmentState = vks::initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE);
+		VkPipelineColorBlendStateCreateInfo colorBlendState = vks::initializers::pipelineColorBlendStateCreateInfo(1, &blendAttachmentState);
+		VkPipelineDepthStencilStateCreateInfo depthStencilState = vks::initializers::pipelineDepthStencilStateCreateInfo(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL);
+		VkPipelineViewportStateCreateInfo viewportState = vks::initializers::pipelineViewportStateCreateInfo(1, 1, 0);
+		VkPipelineMultisampleStateCreateInfo multisampleState = vks::initializers::pipelineMultisampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
+		std::vector<VkDynamicState> dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+		VkPipelineDynamicStateCreateInfo dynamicState = vks::initializers::pipelineDynamicStateCreateInfo(dynamicStateEnables);
+		std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
+
+		VkGraphicsPipelineCreateInfo pipelineCI = vks::initializers::pipelineCreateInfo(pipelineLayouts.scene, renderPass, 0);
+		pipelineCI.pInputAssemblyState = &inputAssemblyState;
+		pipelineCI.pRasterizationState = &rasterizationState;
+		pipelineCI.pColorBlendState = &colorBlendState;
+		pipelineCI.pMultisampleState = &multisampleState;
+		pipelineCI.pViewportState = &viewportState;
+		pipelineCI.pDepthStencilState = &depthStencilState;
+		pipelineCI.pDynamicState = &dynamicState;
+		pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
+		pipelineCI.pStages = shaderStages.data();
+		pipelineCI.pVertexInputState = vkglTF::Vertex::getPipelineVertexInputState({ vkglTF::VertexComponent::Position, vkglTF::VertexComponent::Normal, vkglTF::VertexComponent::UV, vkglTF::VertexComponent::Tangent });
+
+		shaderStages[0] = loadShader(getShadersPath() + "gpudrivenrendering/scene.vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
+		shaderStages[1] = loadShader(getShadersPath() + "gpudrivenrendering/scene.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCI, nullptr, &pipelines.scene));
+
+		if (gpuCulling.enabled) {
+			pipelineCI.layout = pipelineLayouts.culled;
+			shaderStages[0] = loadShader(getShadersPath() + "gpudrivenrendering/culled.vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
+			shaderStages[1] = loadShader(getShadersPath() + "gpudrivenrendering/culled.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+			VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCI, nullptr, &pipelines.culled));
+		}
+	}
+
+	// Prepare and initialize uniform buffer containing shader uniforms
+	void prepareUniformBuffers()
+	{
+		for (auto& buffer : uniformBuffers) {
+			VK_CHECK_RESULT(vulkanDevice->createBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, sizeof(UniformData), &uniformData));
+			VK_CHECK_RESULT(buffer.map());
+		}
+	}
+
+	void updateUniformBuffers()
+	{
+		uniformData.projection = camera.matrices.perspective;
+		uniformData.view = camera.matrices.view;
+		uniformData.viewPos = camera.viewPos;
+		memcpy(uniformBuffers[currentBuffer].mapped, &uniformData, sizeof(uniformData));
+		// Also reads back the statistics of the last frame that used this index
+		gpuCulling.update(currentBuffer, camera.matrices.perspective * camera.matrices.view);
+	}
+
+	void prepare()
+	{
+		VulkanExampleBase::prepare();
+		loadAssets();
+		prepareUniformBuffers();
+		setupDescriptors();
+		preparePipelines();
+		prepared = true;
+	}
+
+	// Draws the primitives that passed one of the cull phases, late draws start at the candidate count in the material buffer
+	void drawCulled(VkCommandBuffer cmdBuffer, bool late)
+	{
+		const std::array<VkDescriptorSet, 3> sets = { descriptorSets[currentBuffer].culled, scene.nodeBuffers[currentBuffer].descriptorSet, scene.bindlessMaterials.descriptorSet };
+		const uint32_t drawOffset = late ? gpuCulling.statistics.candidates : 0;
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.culled);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.culled, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+		vkCmdPushConstants(cmdBuffer, pipelineLayouts.culled, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &drawOffset);
+		if (late) {
+			gpuCulling.drawOccluded(cmdBuffer, currentBuffer);
+		} else {
+			gpuCulling.draw(cmdBuffer, currentBuffer);
+		}
+	}
+
+	void buildCommandBuffer()
+	{
+		VkCommandBuffer cmdBuffer = drawCmdBuffers[currentBuffer];
+
+		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+
+		VkClearValue clearValues[2]{};
+		clearValues[0].color = defaultClearColor;
+		clearValues[1].depthStencil = { 1.0f, 0 };
+
+		VkRenderPassBeginInfo renderPassBeginInfo = vks::initializers::renderPassBeginInfo();
+		renderPassBeginInfo.renderPass = renderPass;
+		renderPassBeginInfo.renderArea.offset.x = 0;
+		renderPassBeginInfo.renderArea.offset.y = 0;
+		renderPassBeginInfo.renderArea.extent.width = width;
+		renderPassBeginInfo.renderArea.extent.height = height;
+		renderPassBeginInfo.clearValueCount = 2;
+		renderPassBeginInfo.pClearValues = clearValues;
+		renderPassBeginInfo.framebuffer = frameBuffers[currentImageIndex];
+
+		VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
+		VkRect2D scissor = vks::initializers::rect2D(width, height, 0, 0);
+
+		const bool culled = useGpuCulling && gpuCulling.enabled;
+		const bool occlusionCulled = culled && gpuCulling.occlusionCulling;
+
+		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
+		gpuProfiler.beginFrame(cmdBuffer, currentBuffer);
+
+		if (culled) {
+			// Fills the indirect draw buffer for this frame, has to be recorded outside of the render pass
+			gpuProfiler.beginRegion(cmdBuffer, "Cull");
+			gpuCulling.cull(cmdBuffer, currentBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
+		}
+
+		if (occlusionCulled) {
+			// Early draws, tested against the depth pyramid of the previous frame
+			gpuProfiler.beginRegion(cmdBuffer, "Early draws");
+			renderPassBeginInfo.renderPass = renderPasses.early;
+			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
+			drawCulled(cmdBuffer, false);
+			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
+
+			// Build the depth pyramid from the early draws and test the candidates the early phase rejected against it
+			gpuProfiler.beginRegion(cmdBuffer, "Depth pyramid and late cull");
+			gpuCulling.buildDepthPyramid(cmdBuffer);
+			gpuCulling.cullOccluded(cmdBuffer, currentBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
+
+			// Late draws, loads the results of the early pass
+			gpuProfiler.beginRegion(cmdBuffer, "Late draws");
+			renderPassBeginInfo.renderPass = renderPasses.late;
+			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
+			drawCulled(cmdBuffer, true);
+		} else {
+			gpuProfiler.beginRegion(cmdBuffer, "Draws");
+			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
+			if (culled) {
+				// All visible opaque and masked primitives are drawn with a single indirect count draw
+				drawCulled(cmdBuffer, false);
+			}
+		}
+
+		// Blended primitives aren't culled on the GPU
+		const uint32_t renderFlags = culled ? (vkglTF::RenderFlags::BindImages | vkglTF::RenderFlags::RenderAlphaBlendedNodes) : vkglTF::RenderFlags::BindImages;
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.scene);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets[currentBuffer].scene, 0, nullptr);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 1, 1, &scene.nodeBuffers[currentBuffer].descriptorSet, 0, nullptr);
+		// Binds the material descriptor set once (at set 2) and pushes the material index of each draw
+		scene.draw(cmdBuffer, renderFlags, pipelineLayouts.scene, 2);
+		gpuProfiler.endRegion(cmdBuffer);
+
+		drawUI(cmdBuffer);
+
+		vkCmdEndRenderPass(cmdBuffer);
+		gpuProfiler.endFrame(cmdBuffer);
+		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
+	}
+
+	virtual void render()
+	{
+		if (!prepared)
+			return;
+		VulkanExampleBase::prepareFrame();
+		updateUniformBuffers();
+		buildCommandBuffer();
+		VulkanExampleBase::submitFrame();
+	}
+
+	virtual void OnUpdateUIOverlay(vks::UIOverlay* overlay)
+	{
+		if (overlay->header("GPU culling")) {
+			if (!gpuCulling.enabled) {
+				overlay->text("Indirect count draws not supported");
+			} else {
+				overlay->checkBox("Enabled", &useGpuCulling);
+				overlay->checkBox("Occlusion culling", &gpuCulling.occlusionCulling);
+				// Percentages are relative to the number of primitives tested by the cull shader
+				const vks::GpuCulling::Statistics& statistics = gpuCulling.statistics;
+				const float percent = (statistics.candidates > 0) ? 100.0f / static_cast<float>(statistics.candidates) : 0.0f;
+				overlay->text("Candidates: %d", statistics.candidates);
+				overlay->text("Visible draws: %d (%.1f%%)", statistics.visibleDraws, statistics.visibleDraws * percent);
+				overlay->text("Frustum culled: %d (%.1f%%)", statistics.frustumCulled, statistics.frustumCulled * percent);
+				overlay->text("Occlusion culled: %d (%.1f%%)", statistics.occlusionCulled, statistics.occlusionCulled * percent);
+				overlay->text("Late draws: %d (%.1f%%)", statistics.lateDraws, statistics.lateDraws * percent);
+			}
+		}
+		if (overlay->header("Command recording")) {
+			overlay->text("Materials: %d", static_cast<int32_t>(scene.materials.size()));
+			overlay->text("Draws: %d", scene.recordStatistics.draws);
+			overlay->text("Descriptor set binds: %d", scene.recordStatistics.descriptorBinds);
+			overlay->text("Material push constants: %d", scene.recordStatistics.pushConstants);
+			overlay->text("Set per material: %d binds", scene.drawListStatistics.descriptorBinds);
+			overlay->text("CPU record time: %.3f ms", scene.recordStatistics.cpuTime);
+		}
+	}
+};
+
+VULKAN_EXAMPLE_MAIN()
@@ -662,6 +662,7 @@ public:
 		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
+		gpuProfiler.beginFrame(cmdBuffer, currentBuffer);
 
 		{
 			/*
@@ -681,6 +682,7 @@ public:
 			renderPassBeginInfo.clearValueCount = 3;
 			renderPassBeginInfo.pClearValues = clearValues.data();
 
+			gpuProfiler.beginRegion(cmdBuffer, "Scene");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			VkViewport viewport = vks::initializers::viewport((float)offscreen.width, (float)offscreen.height, 0.0f, 1.0f);
@@ -709,6 +711,7 @@ public:
 			models.objects[models.index].draw(cmdBuffer);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 		}
 
 		/*
@@ -728,6 +731,7 @@ public:
 			renderPassBeginInfo.renderArea.extent.height = filterPass.height;
 			renderPassBeginInfo.pClearValues = clearValues;
 
+			gpuProfiler.beginRegion(cmdBuffer, "Bloom filter");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			VkViewport viewport = vks::initializers::viewport((float)filterPass.width, (float)filterPass.height, 0.0f, 1.0f);
@@ -742,6 +746,7 @@ public:
 			vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 		}
 
 		/*
@@ -765,6 +770,7 @@ public:
 			renderPassBeginInfo.renderArea.extent.height = height;
 			renderPassBeginInfo.pClearValues = clearValues;
 
+			gpuProfiler.beginRegion(cmdBuffer, "Composition");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
@@ -788,8 +794,10 @@ public:
 			drawUI(cmdBuffer);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 		}
 
+		gpuProfiler.endFrame(cmdBuffer);
 		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
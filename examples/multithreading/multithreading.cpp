@@ -8,6 +8,7 @@
 
 #include "vulkanexamplebase.h"
 
+#include "jobsystem.hpp"
 #include "threadpool.hpp"
 #include "frustum.hpp"
 
@@ -42,13 +43,18 @@ public:
 	};
 	std::array<SecondaryCommandBuffers, maxConcurrentFrames> secondaryCommandBuffers{};
 
-	// Number of animated objects to be renderer
+	// Number of animated objects to be rendered
 	// by using threads and secondary command buffers
-	uint32_t numObjectsPerThread{ 0 };
+	// Can be changed with the --objects command line argument
+	uint32_t numObjects{ 512 };
 
 	// Multi threaded stuff
 	// Max. number of concurrent threads
 	uint32_t numThreads{ 0 };
+	// Distribute the objects with the old per-thread job queues instead of the work stealing job system (--threadpool command line argument, for comparison)
+	bool useThreadPool{ false };
+	// Time spent on updating and recording the object command buffers
+	float recordingTime{ 0.0f };
 
 	// Use push constants to update shader
 	// parameters on a per-thread base
@@ -66,24 +72,34 @@ public:
 		float scale;
 		float deltaT;
 		float stateT = 0;
-		bool visible = true;
+		// Secondary command buffer the object was recorded to in the current frame
+		VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
 	};
-
-	struct ThreadData {
-		VkCommandPool commandPool{ VK_NULL_HANDLE };
-		// One command buffer per render object per max. frames in flight
-		std::array<std::vector<VkCommandBuffer>, maxConcurrentFrames> commandBuffer;
-		// One push constant block per render object
-		std::vector<ThreadPushConstantBlock> pushConstBlock;
-		// Per object information (position, rotation, etc.)
-		std::vector<ObjectData> objectData;
+	// Per object information (position, rotation, etc.)
+	std::vector<ObjectData> objectData;
+	// One push constant block per render object
+	std::vector<ThreadPushConstantBlock> pushConstBlocks;
+
+	// Command pools can't be used from multiple threads at the same time, so every thread records to command buffers from its own pools
+	// As objects may be recorded by any thread (work stealing), command buffers are handed out from the recording thread's pool on demand instead of being tied to an object
+	struct alignas(64) ThreadData {
+		// One command pool per max. frames in flight, reset at the start of the frame
+		std::array<VkCommandPool, maxConcurrentFrames> commandPool{};
+		std::array<std::vector<VkCommandBuffer>, maxConcurrentFrames> commandBuffers;
+		// Number of command buffers handed out in the current frame
+		uint32_t usedCommandBuffers{ 0 };
 	};
 	std::vector<ThreadData> threadData;
 
+	vks::JobSystem jobSystem;
 	vks::ThreadPool threadPool;
 
 	// View frustum for culling invisible objects
 	vks::Frustum frustum;
+	// Object bounds are culled in one batch before recording, only visible objects are distributed to the threads
+	vks::BoundingSpheres boundingSpheres;
+	std::vector<uint32_t> visibilityMask;
+	std::vector<uint32_t> visibleObjects;
 
 	std::default_random_engine rndEngine;
 
@@ -95,6 +111,12 @@ public:
 		camera.setRotation(glm::vec3(0.0f));
 		camera.setRotationSpeed(0.5f);
 		camera.setPerspective(60.0f, (float)width / (float)height, 0.1f, 256.0f);
+		// Sample specific command line arguments, used to compare the schedulers at different object counts
+		commandLineParser.add("objects", { "--objects" }, 1, "Number of objects to render (multithreading sample)");
+		commandLineParser.add("threadpool", { "--threadpool" }, 0, "Use per-thread job queues instead of the work stealing job system (multithreading sample)");
+		commandLineParser.parse(args);
+		numObjects = commandLineParser.getValueAsInt("objects", numObjects);
+		useThreadPool = commandLineParser.isSet("threadpool");
 		// Get number of max. concurrent threads
 		numThreads = std::thread::hardware_concurrency();
 		assert(numThreads > 0);
@@ -103,8 +125,12 @@ public:
 #else
 		std::cout << "numThreads = " << numThreads << std::endl;
 #endif
-		threadPool.setThreadCount(numThreads);
-		numObjectsPerThread = 512 / numThreads;
+		if (useThreadPool) {
+			threadPool.setThreadCount(numThreads);
+		} else {
+			// The main thread is one of the job system's workers
+			jobSystem.create(numThreads);
+		}
 		rndEngine.seed(benchmark.active ? 0 : (unsigned)time(nullptr));
 	}
 
@@ -115,10 +141,12 @@ public:
 			vkDestroyPipeline(device, pipelines.starsphere, nullptr);
 			vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 			for (auto& thread : threadData) {
-				for (auto& cmdBuffers : thread.commandBuffer) {
-					vkFreeCommandBuffers(device, thread.commandPool, static_cast<uint32_t>(cmdBuffers.size()), cmdBuffers.data());
+				for (uint32_t i = 0; i < maxConcurrentFrames; i++) {
+					if (!thread.commandBuffers[i].empty()) {
+						vkFreeCommandBuffers(device, thread.commandPool[i], static_cast<uint32_t>(thread.commandBuffers[i].size()), thread.commandBuffers[i].data());
+					}
+					vkDestroyCommandPool(device, thread.commandPool[i], nullptr);
 				}
-				vkDestroyCommandPool(device, thread.commandPool, nullptr);
 			}
 		}
 	}
@@ -141,60 +169,64 @@ public:
 
 		threadData.resize(numThreads);
 
-		for (uint32_t i = 0; i < numThreads; i++) {
-			ThreadData *thread = &threadData[i];
-
+		for (auto& thread : threadData) {
 			// Command pools need to be per thread
-			VkCommandPoolCreateInfo cmdPoolInfo = vks::initializers::commandPoolCreateInfo();
-			cmdPoolInfo.queueFamilyIndex = swapChain.queueNodeIndex;
-			cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-			VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &thread->commandPool));
-
-			// One secondary command buffer per object that is updated by this thread
-			// We also duplicate the command buffers per max. frames in flight
-			for (auto& commandBuffers : thread->commandBuffer) {
-				commandBuffers.resize(numObjectsPerThread);
-				// Generate secondary command buffers for each thread
-				VkCommandBufferAllocateInfo secondaryCmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(thread->commandPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, static_cast<uint32_t>(commandBuffers.size()));
-				VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &secondaryCmdBufAllocateInfo, commandBuffers.data()));
+			for (auto& commandPool : thread.commandPool) {
+				VkCommandPoolCreateInfo cmdPoolInfo = vks::initializers::commandPoolCreateInfo();
+				cmdPoolInfo.queueFamilyIndex = swapChain.queueNodeIndex;
+				VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &commandPool));
 			}
-
-			thread->pushConstBlock.resize(numObjectsPerThread);
-			thread->objectData.resize(numObjectsPerThread);
-
-			for (uint32_t j = 0; j < numObjectsPerThread; j++) {
-				float theta = 2.0f * float(M_PI) * rnd(1.0f);
-				float phi = acos(1.0f - 2.0f * rnd(1.0f));
-				thread->objectData[j].pos = glm::vec3(sin(phi) * cos(theta), 0.0f, cos(phi)) * 35.0f;
-				thread->objectData[j].rotation = glm::vec3(0.0f, rnd(360.0f), 0.0f);
-				thread->objectData[j].deltaT = rnd(1.0f);
-				thread->objectData[j].rotationDir = (rnd(100.0f) < 50.0f) ? 1.0f : -1.0f;
-				thread->objectData[j].rotationSpeed = (2.0f + rnd(4.0f)) * thread->objectData[j].rotationDir;
-				thread->objectData[j].scale = 0.75f + rnd(0.5f);
-				thread->pushConstBlock[j].color = glm::vec3(rnd(1.0f), rnd(1.0f), rnd(1.0f));
+			// Secondary command buffers are allocated on demand, start with an even share of the objects
+			for (uint32_t i = 0; i < maxConcurrentFrames; i++) {
+				thread.commandBuffers[i].resize(std::max(numObjects / numThreads, 1u));
+				VkCommandBufferAllocateInfo secondaryCmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(thread.commandPool[i], VK_COMMAND_BUFFER_LEVEL_SECONDARY, static_cast<uint32_t>(thread.commandBuffers[i].size()));
+				VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &secondaryCmdBufAllocateInfo, thread.commandBuffers[i].data()));
 			}
 		}
+
+		pushConstBlocks.resize(numObjects);
+		objectData.resize(numObjects);
+
+		for (uint32_t i = 0; i < numObjects; i++) {
+			float theta = 2.0f * float(M_PI) * rnd(1.0f);
+			float phi = acos(1.0f - 2.0f * rnd(1.0f));
+			objectData[i].pos = glm::vec3(sin(phi) * cos(theta), 0.0f, cos(phi)) * 35.0f;
+			objectData[i].rotation = glm::vec3(0.0f, rnd(360.0f), 0.0f);
+			objectData[i].deltaT = rnd(1.0f);
+			objectData[i].rotationDir = (rnd(100.0f) < 50.0f) ? 1.0f : -1.0f;
+			objectData[i].rotationSpeed = (2.0f + rnd(4.0f)) * objectData[i].rotationDir;
+			objectData[i].scale = 0.75f + rnd(0.5f);
+			pushConstBlocks[i].color = glm::vec3(rnd(1.0f), rnd(1.0f), rnd(1.0f));
+		}
 	}
 
-	// Builds the secondary command buffer for each thread
-	void threadRenderCode(uint32_t threadIndex, uint32_t cmdBufferIndex, VkCommandBufferInheritanceInfo inheritanceInfo)
+	// Returns the next unused secondary command buffer from the given thread's pool for the current frame
+	VkCommandBuffer getThreadCommandBuffer(uint32_t threadIndex)
 	{
-		ThreadData *thread = &threadData[threadIndex];
-		ObjectData *objectData = &thread->objectData[cmdBufferIndex];
-
-		// Check visibility against view frustum using a simple sphere check based on the radius of the mesh
-		objectData->visible = frustum.checkSphere(objectData->pos, models.ufo.dimensions.radius * 0.5f);
-
-		if (!objectData->visible)
-		{
-			return;
+		ThreadData& thread = threadData[threadIndex];
+		std::vector<VkCommandBuffer>& commandBuffers = thread.commandBuffers[currentBuffer];
+		if (thread.usedCommandBuffers == commandBuffers.size()) {
+			// Grow the pool if this thread recorded more objects than ever before
+			const uint32_t count = std::max(static_cast<uint32_t>(commandBuffers.size()), 16u);
+			commandBuffers.resize(commandBuffers.size() + count);
+			VkCommandBufferAllocateInfo secondaryCmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(thread.commandPool[currentBuffer], VK_COMMAND_BUFFER_LEVEL_SECONDARY, count);
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &secondaryCmdBufAllocateInfo, &commandBuffers[commandBuffers.size() - count]));
 		}
+		return commandBuffers[thread.usedCommandBuffers++];
+	}
+
+	// Builds the secondary command buffer for an object on the given thread
+	void threadRenderCode(uint32_t threadIndex, uint32_t objectIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo)
+	{
+		VKS_PROFILE_ZONE("Record object");
+		ObjectData *objectData = &this->objectData[objectIndex];
 
 		VkCommandBufferBeginInfo commandBufferBeginInfo = vks::initializers::commandBufferBeginInfo();
 		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
 		commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
 
-		VkCommandBuffer cmdBuffer = thread->commandBuffer[currentBuffer][cmdBufferIndex];
+		VkCommandBuffer cmdBuffer = getThreadCommandBuffer(threadIndex);
+		objectData->commandBuffer = cmdBuffer;
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &commandBufferBeginInfo));
 
@@ -224,7 +256,7 @@ public:
 		objectData->model = glm::rotate(objectData->model, glm::radians(objectData->deltaT * 360.0f), glm::vec3(0.0f, objectData->rotationDir, 0.0f));
 		objectData->model = glm::scale(objectData->model, glm::vec3(objectData->scale));
 
-		thread->pushConstBlock[cmdBufferIndex].mvp = matrices.projection * matrices.view * objectData->model;
+		pushConstBlocks[objectIndex].mvp = matrices.projection * matrices.view * objectData->model;
 
 		// Update shader push constant block
 		// Contains model view matrix
@@ -234,7 +266,7 @@ public:
 			VK_SHADER_STAGE_VERTEX_BIT,
 			0,
 			sizeof(ThreadPushConstantBlock),
-			&thread->pushConstBlock[cmdBufferIndex]);
+			&pushConstBlocks[objectIndex]);
 
 		VkDeviceSize offsets[1] = { 0 };
 		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &models.ufo.vertices.buffer, offsets);
@@ -246,6 +278,7 @@ public:
 
 	void updateSecondaryCommandBuffers(VkCommandBufferInheritanceInfo inheritanceInfo)
 	{
+		VKS_PROFILE_ZONE("Record background and UI");
 		// Secondary command buffer for the sky sphere
 		VkCommandBufferBeginInfo commandBufferBeginInfo = vks::initializers::commandBufferBeginInfo();
 		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
@@ -377,6 +410,7 @@ public:
 	// lat submitted to the queue for rendering
 	void updateCommandBuffer()
 	{
+		VKS_PROFILE_ZONE("Update command buffer");
 		VkCommandBuffer cmdBuffer = drawCmdBuffers[currentBuffer];
 		
 		// Contains the list of secondary command buffers to be submitted
@@ -417,22 +451,43 @@ public:
 			commandBuffers.push_back(secondaryCommandBuffers[currentBuffer].background);
 		}
 
-		// Add a job to the thread's queue for each object to be rendered
-		for (uint32_t t = 0; t < numThreads; t++) {
-			for (uint32_t i = 0; i < numObjectsPerThread; i++) {
-				threadPool.threads[t]->addJob([=, this] { threadRenderCode(t, i, inheritanceInfo); });
-			}
+		// The previous use of this frame's command pools has finished (fence wait in prepareFrame), so they can be recycled as a whole
+		for (auto& thread : threadData) {
+			VK_CHECK_RESULT(vkResetCommandPool(device, thread.commandPool[currentBuffer], 0));
+			thread.usedCommandBuffers = 0;
 		}
 
-		threadPool.wait();
+		auto tStart = std::chrono::high_resolution_clock::now();
 
-		// Only submit if object is within the current view frustum
-		for (uint32_t t = 0; t < numThreads; t++) {
-			for (uint32_t i = 0; i < numObjectsPerThread; i++) {
-				if (threadData[t].objectData[i].visible) {
-					commandBuffers.push_back(threadData[t].commandBuffer[currentBuffer][i]);
-				}
+		// Check visibility of all objects against the view frustum using a simple sphere check based on the radius of the mesh
+		{
+			VKS_PROFILE_ZONE("Frustum culling");
+			boundingSpheres.resize(numObjects);
+			for (uint32_t i = 0; i < numObjects; i++) {
+				boundingSpheres.set(i, objectData[i].pos, models.ufo.dimensions.radius * 0.5f);
+			}
+			frustum.cullSpheres(boundingSpheres, visibilityMask);
+			vks::Frustum::compactVisible(visibilityMask, numObjects, visibleObjects);
+		}
+		const uint32_t visibleCount = static_cast<uint32_t>(visibleObjects.size());
+
+		if (useThreadPool) {
+			// Add a job to the thread's queue for each object to be rendered, objects are statically distributed across the threads
+			for (uint32_t i = 0; i < visibleCount; i++) {
+				const uint32_t t = i % numThreads;
+				const uint32_t objectIndex = visibleObjects[i];
+				threadPool.threads[t]->addJob([=, this] { threadRenderCode(t, objectIndex, inheritanceInfo); });
 			}
+			threadPool.wait();
+		} else {
+			// Objects are split into chunks that idle workers steal from busy ones
+			jobSystem.parallelFor(visibleCount, [&](uint32_t i) { threadRenderCode(jobSystem.currentWorkerIndex(), visibleObjects[i], inheritanceInfo); });
+		}
+		recordingTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+		// Only objects within the current view frustum have been recorded
+		for (uint32_t objectIndex : visibleObjects) {
+			commandBuffers.push_back(objectData[objectIndex].commandBuffer);
 		}
 
 		// Render ui last
@@ -463,6 +518,9 @@ public:
 	{
 		if (overlay->header("Statistics")) {
 			overlay->text("Active threads: %d", numThreads);
+			overlay->text("Scheduler: %s", useThreadPool ? "per-thread queues" : "work stealing");
+			overlay->text("Objects: %d (%d visible)", numObjects, static_cast<uint32_t>(visibleObjects.size()));
+			overlay->text("Recording: %.2f ms", recordingTime);
 		}
 		if (overlay->header("Settings")) {
 			overlay->checkBox("Stars", &displayStarSphere);
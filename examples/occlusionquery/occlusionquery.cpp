@@ -51,8 +51,8 @@ public:
 	};
 	std::array<DescriptorSets, maxConcurrentFrames> descriptorSets;
 
-	// Pool that stores all occlusion queries
-	VkQueryPool queryPool;
+	// Occlusion queries for the teapot and the sphere, results are read back without stalling once a frame has finished on the GPU
+	vks::QueryManager occlusionQueries;
 
 	// Passed query samples
 	uint64_t passedSamples[2] = { 1,1 };
@@ -75,7 +75,7 @@ public:
 			vkDestroyPipeline(device, pipelines.simple, nullptr);
 			vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 			vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
-			vkDestroyQueryPool(device, queryPool, nullptr);
+			occlusionQueries.destroy();
 			for (auto& buffer : uniformBuffers) {
 				buffer.sphere.destroy();
 				buffer.teapot.destroy();
@@ -84,14 +84,10 @@ public:
 		}
 	}
 
-	// Create a query pool for storing the occlusion query result
+	// Create the occlusion queries, each frame in flight gets its own set of queries
 	void setupQueryPool()
 	{
-		VkQueryPoolCreateInfo queryPoolInfo = {};
-		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-		queryPoolInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
-		queryPoolInfo.queryCount = 2;
-		VK_CHECK_RESULT(vkCreateQueryPool(device, &queryPoolInfo, NULL, &queryPool));
+		occlusionQueries.create(vulkanDevice, VK_QUERY_TYPE_OCCLUSION, 2, maxConcurrentFrames);
 	}
 
 	void loadAssets()
@@ -271,9 +267,9 @@ public:
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
 
-		// Reset query pool
+		// Reset the queries of this frame and read back the results of the frame that last used them
 		// Must be done outside of render pass
-		vkCmdResetQueryPool(cmdBuffer, queryPool, 0, 2);
+		occlusionQueries.beginFrame(cmdBuffer, currentBuffer);
 
 		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
@@ -301,16 +297,16 @@ public:
 		models.plane.draw(cmdBuffer);
 
 		// Teapot
-		vkCmdBeginQuery(cmdBuffer, queryPool, 0, VK_FLAGS_NONE);
+		occlusionQueries.beginQuery(cmdBuffer, 0);
 		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentBuffer].teapot, 0, nullptr);
 		models.teapot.draw(cmdBuffer);
-		vkCmdEndQuery(cmdBuffer, queryPool, 0);
+		occlusionQueries.endQuery(cmdBuffer, 0);
 
 		// Sphere
-		vkCmdBeginQuery(cmdBuffer, queryPool, 1, VK_FLAGS_NONE);
+		occlusionQueries.beginQuery(cmdBuffer, 1);
 		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentBuffer].sphere, 0, nullptr);
 		models.sphere.draw(cmdBuffer);
-		vkCmdEndQuery(cmdBuffer, queryPool, 1);
+		occlusionQueries.endQuery(cmdBuffer, 1);
 
 		// Visible pass
 		// Clear color and depth attachments
@@ -354,6 +350,9 @@ public:
 
 		vkCmdEndRenderPass(cmdBuffer);
 
+		// Copy the query results to a host visible buffer on the GPU, must be done outside of render pass
+		occlusionQueries.endFrame(cmdBuffer);
+
 		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
@@ -365,19 +364,12 @@ public:
 		updateUniformBuffers();
 		buildCommandBuffer();
 		VulkanExampleBase::submitFrame();
-		// vkGetQueryResults copies the query results into a host visible buffer that we can display
-		vkGetQueryPoolResults(
-			device,
-			queryPool,
-			0,
-			2,
-			sizeof(passedSamples),
-			passedSamples,
-			sizeof(uint64_t),
-			// Store results a 64 bit values and wait until the results have been finished
-			// If you don't want to wait, you can use VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
-			// which also returns the state of the result (ready) in the result
-			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+		// Instead of waiting for the GPU with vkGetQueryPoolResults and VK_QUERY_RESULT_WAIT_BIT, the results of an earlier frame are used
+		// These are a few frames old (see latency), which is not noticeable for visibility testing
+		if (occlusionQueries.getResults().available) {
+			passedSamples[0] = occlusionQueries.getResult(0);
+			passedSamples[1] = occlusionQueries.getResult(1);
+		}
 	}
 
 	virtual void OnUpdateUIOverlay(vks::UIOverlay *overlay)
@@ -385,6 +377,7 @@ public:
 		if (overlay->header("Occlusion query results")) {
 			overlay->text("Teapot: %d samples passed", passedSamples[0]);
 			overlay->text("Sphere: %d samples passed", passedSamples[1]);
+			overlay->text("Latency: %d frames", occlusionQueries.getResults().latency);
 		}
 	}
 
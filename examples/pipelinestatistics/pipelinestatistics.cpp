@@ -39,7 +39,8 @@ public:
 	VkDescriptorSetLayout descriptorSetLayout{ VK_NULL_HANDLE };
 	std::array<VkDescriptorSet, maxConcurrentFrames> descriptorSets{};
 
-	VkQueryPool queryPool{ VK_NULL_HANDLE };
+	// Pipeline statistics query, results are read back without stalling once a frame has finished on the GPU
+	vks::QueryManager statisticsQueries;
 
 	// Vector for storing pipeline statistics results
 	std::vector<uint64_t> pipelineStats{};
@@ -63,7 +64,7 @@ public:
 			vkDestroyPipeline(device, pipeline, nullptr);
 			vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 			vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
-			vkDestroyQueryPool(device, queryPool, nullptr);
+			statisticsQueries.destroy();
 			for (auto& buffer : uniformBuffers) {
 				buffer.destroy();
 			}
@@ -104,12 +105,8 @@ public:
 		}
 		pipelineStats.resize(pipelineStatNames.size());
 
-		VkQueryPoolCreateInfo queryPoolInfo = {};
-		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-		// This query pool will store pipeline statistics
-		queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
-		// Pipeline counters to be returned for this pool
-		queryPoolInfo.pipelineStatistics =
+		// Pipeline counters to be returned for the query
+		VkQueryPipelineStatisticFlags pipelineStatistics =
 			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
 			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
 			VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
@@ -117,31 +114,23 @@ public:
 			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
 			VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
 		if (deviceFeatures.tessellationShader) {
-			queryPoolInfo.pipelineStatistics |=
+			pipelineStatistics |=
 				VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT |
 				VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
 		}
-		queryPoolInfo.queryCount = 1;
-		VK_CHECK_RESULT(vkCreateQueryPool(device, &queryPoolInfo, NULL, &queryPool));
+		// Each frame in flight gets its own query, the counters are the values of the query's results
+		statisticsQueries.create(vulkanDevice, VK_QUERY_TYPE_PIPELINE_STATISTICS, 1, maxConcurrentFrames, pipelineStatistics);
 	}
 
-	// Retrieves the results of the pipeline statistics query submitted to the command buffer
+	// Retrieves the results of the pipeline statistics query of the most recent frame that has finished on the GPU
 	void getQueryResults()
 	{
-		// The size of the data we want to fetch ist based on the count of statistics values
-		uint32_t dataSize = static_cast<uint32_t>(pipelineStats.size()) * sizeof(uint64_t);
-		// The stride between queries is the no. of unique value entries
-		uint32_t stride = static_cast<uint32_t>(pipelineStatNames.size()) * sizeof(uint64_t);
-		// Note: for one query both values have the same size, but to make it easier to expand this sample these are properly calculated
-		vkGetQueryPoolResults(
-			device,
-			queryPool,
-			0,
-			1,
-			dataSize,
-			pipelineStats.data(),
-			stride,
-			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+		if (!statisticsQueries.getResults().available) {
+			return;
+		}
+		for (uint32_t i = 0; i < static_cast<uint32_t>(pipelineStats.size()); i++) {
+			pipelineStats[i] = statisticsQueries.getResult(0, i);
+		}
 	}
 
 	void loadAssets()
@@ -308,8 +297,8 @@ public:
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
 
-		// Reset timestamp query pool
-		vkCmdResetQueryPool(cmdBuffer, queryPool, 0, 1);
+		// Reset the query of this frame and read back the results of the frame that last used it
+		statisticsQueries.beginFrame(cmdBuffer, currentBuffer);
 
 		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
@@ -322,7 +311,7 @@ public:
 		VkDeviceSize offsets[1] = { 0 };
 
 		// Start capture of pipeline statistics
-		vkCmdBeginQuery(cmdBuffer, queryPool, 0, 0);
+		statisticsQueries.beginQuery(cmdBuffer, 0);
 
 		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentBuffer], 0, nullptr);
@@ -338,12 +327,15 @@ public:
 		}
 
 		// End capture of pipeline statistics
-		vkCmdEndQuery(cmdBuffer, queryPool, 0);
+		statisticsQueries.endQuery(cmdBuffer, 0);
 
 		drawUI(cmdBuffer);
 
 		vkCmdEndRenderPass(cmdBuffer);
 
+		// Copy the query results to a host visible buffer on the GPU
+		statisticsQueries.endFrame(cmdBuffer);
+
 		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
@@ -356,7 +348,7 @@ public:
 		buildCommandBuffer();
 		VulkanExampleBase::submitFrame();
 
-		// Read query results for displaying in next frame
+		// Get the query results for displaying, these don't wait for the frame that was just submitted
 		getQueryResults();
 	}
 
@@ -390,6 +382,7 @@ public:
 					std::string caption = pipelineStatNames[i] + ": %d";
 					overlay->text(caption.c_str(), pipelineStats[i]);
 				}
+				overlay->text("Latency: %d frames", statisticsQueries.getResults().latency);
 			}
 		}
 	}
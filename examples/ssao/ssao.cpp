@@ -763,6 +763,7 @@ public:
 		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
+		gpuProfiler.beginFrame(cmdBuffer, currentBuffer);
 
 		/*
 			Offscreen SSAO generation
@@ -787,6 +788,7 @@ public:
 				First pass: Fill G-Buffer components (positions+depth, normals, albedo) using MRT
 			*/
 
+			gpuProfiler.beginRegion(cmdBuffer, "G-Buffer");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			VkViewport viewport = vks::initializers::viewport((float)frameBuffers.offscreen.width, (float)frameBuffers.offscreen.height, 0.0f, 1.0f);
@@ -801,6 +803,7 @@ public:
 			scene.draw(cmdBuffer, vkglTF::RenderFlags::BindImages, pipelineLayouts.gBuffer);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 
 			/*
 				Second pass: SSAO generation
@@ -816,6 +819,7 @@ public:
 			renderPassBeginInfo.clearValueCount = 2;
 			renderPassBeginInfo.pClearValues = clearValues.data();
 
+			gpuProfiler.beginRegion(cmdBuffer, "SSAO");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			viewport = vks::initializers::viewport((float)frameBuffers.ssao.width, (float)frameBuffers.ssao.height, 0.0f, 1.0f);
@@ -828,6 +832,7 @@ public:
 			vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 
 			/*
 				Third pass: SSAO blur
@@ -838,6 +843,7 @@ public:
 			renderPassBeginInfo.renderArea.extent.width = frameBuffers.ssaoBlur.width;
 			renderPassBeginInfo.renderArea.extent.height = frameBuffers.ssaoBlur.height;
 
+			gpuProfiler.beginRegion(cmdBuffer, "SSAO blur");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			viewport = vks::initializers::viewport((float)frameBuffers.ssaoBlur.width, (float)frameBuffers.ssaoBlur.height, 0.0f, 1.0f);
@@ -850,6 +856,7 @@ public:
 			vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 		}
 
 		/*
@@ -872,6 +879,7 @@ public:
 			renderPassBeginInfo.clearValueCount = 2;
 			renderPassBeginInfo.pClearValues = clearValues.data();
 
+			gpuProfiler.beginRegion(cmdBuffer, "Composition");
 			vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
@@ -889,8 +897,10 @@ public:
 			drawUI(cmdBuffer);
 
 			vkCmdEndRenderPass(cmdBuffer);
+			gpuProfiler.endRegion(cmdBuffer);
 		}
 
+		gpuProfiler.endFrame(cmdBuffer);
 		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
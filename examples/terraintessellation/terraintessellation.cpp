@@ -85,11 +85,7 @@ public:
 	std::array<DescriptorSets, maxConcurrentFrames> descriptorSets;
 
 	// If supported, this sample will gather pipeline statistics to show e.g. tessellation related information
-	struct {
-		VkBuffer buffer{ VK_NULL_HANDLE };
-		VkDeviceMemory memory{ VK_NULL_HANDLE };
-	} queryResult;
-	VkQueryPool queryPool{ VK_NULL_HANDLE };
+	vks::QueryManager statisticsQueries;
 	uint64_t pipelineStats[2] = { 0 };
 
 	// View frustum passed to tessellation control shader for culling
@@ -126,11 +122,7 @@ public:
 			textures.terrainArray.destroy();
 			terrain.vertexBuffer.destroy();
 			terrain.indexBuffer.destroy();
-			if (queryPool != VK_NULL_HANDLE) {
-				vkDestroyQueryPool(device, queryPool, nullptr);
-				vkDestroyBuffer(device, queryResult.buffer, nullptr);
-				vkFreeMemory(device, queryResult.memory, nullptr);
-			}
+			statisticsQueries.destroy();
 		}
 	}
 
@@ -157,37 +149,10 @@ public:
 		}
 	}
 
-	// Setup a pool and a buffer for storing pipeline statistics results
+	// Setup the pipeline statistics query, results are copied to a host visible buffer on the GPU and read back without stalling
 	void setupQueryResultBuffer()
 	{
-		uint32_t bufSize = 2 * sizeof(uint64_t);
-
-		VkMemoryRequirements memReqs;
-		VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
-		VkBufferCreateInfo bufferCreateInfo =
-			vks::initializers::bufferCreateInfo(
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-				bufSize);
-
-		// Results are saved in a host visible buffer for easy access by the application
-		VK_CHECK_RESULT(vkCreateBuffer(device, &bufferCreateInfo, nullptr, &queryResult.buffer));
-		vkGetBufferMemoryRequirements(device, queryResult.buffer, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		memAlloc.memoryTypeIndex = vulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		VK_CHECK_RESULT(vkAllocateMemory(device, &memAlloc, nullptr, &queryResult.memory));
-		VK_CHECK_RESULT(vkBindBufferMemory(device, queryResult.buffer, queryResult.memory, 0));
-
-		// Create query pool
-		if (deviceFeatures.pipelineStatisticsQuery) {
-			VkQueryPoolCreateInfo queryPoolInfo = {};
-			queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-			queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
-			queryPoolInfo.pipelineStatistics =
-				VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
-				VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
-			queryPoolInfo.queryCount = 2;
-			VK_CHECK_RESULT(vkCreateQueryPool(device, &queryPoolInfo, NULL, &queryPool));
-		}
+		statisticsQueries.create(vulkanDevice, VK_QUERY_TYPE_PIPELINE_STATISTICS, 1, maxConcurrentFrames, VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT);
 	}
 
 	void loadAssets()
@@ -391,10 +356,8 @@ public:
 
 		vulkanDevice->flushCommandBuffer(copyCmd, queue, true);
 
-		vkDestroyBuffer(device, vertexStaging.buffer, nullptr);
-		vkFreeMemory(device, vertexStaging.memory, nullptr);
-		vkDestroyBuffer(device, indexStaging.buffer, nullptr);
-		vkFreeMemory(device, indexStaging.memory, nullptr);
+		vertexStaging.destroy();
+		indexStaging.destroy();
 
 		delete[] vertices;
 		delete[] indices;
@@ -611,9 +574,8 @@ public:
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
 
-		if (deviceFeatures.pipelineStatisticsQuery) {
-			vkCmdResetQueryPool(cmdBuffer, queryPool, 0, 2);
-		}
+		// Reset the query of this frame and read back the results of the frame that last used it (no-op if pipeline statistics aren't supported)
+		statisticsQueries.beginFrame(cmdBuffer, currentBuffer);
 
 		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
@@ -633,25 +595,23 @@ public:
 		models.skysphere.draw(cmdBuffer);
 
 		// Tessellated terrain
-		if (deviceFeatures.pipelineStatisticsQuery) {
-			// Begin pipeline statistics query
-			vkCmdBeginQuery(cmdBuffer, queryPool, 0, 0);
-		}
+		// Begin pipeline statistics query
+		statisticsQueries.beginQuery(cmdBuffer, 0);
 		// Render
 		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.wireframe : pipelines.terrain);
 		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.terrain, 0, 1, &descriptorSets[currentBuffer].terrain, 0, nullptr);
 		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &terrain.vertexBuffer.buffer, offsets);
 		vkCmdBindIndexBuffer(cmdBuffer, terrain.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
 		vkCmdDrawIndexed(cmdBuffer, terrain.indexCount, 1, 0, 0, 0);
-		if (deviceFeatures.pipelineStatisticsQuery) {
-			// End pipeline statistics query
-			vkCmdEndQuery(cmdBuffer, queryPool, 0);
-		}
+		// End pipeline statistics query
+		statisticsQueries.endQuery(cmdBuffer, 0);
 
 		drawUI(cmdBuffer);
 
 		vkCmdEndRenderPass(cmdBuffer);
 
+		statisticsQueries.endFrame(cmdBuffer);
+
 		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
@@ -663,18 +623,10 @@ public:
 		updateUniformBuffers();
 		buildCommandBuffer();
 		VulkanExampleBase::submitFrame();
-		// Read query results for displaying in next frame (if the device supports pipeline statistics)
-		if (deviceFeatures.pipelineStatisticsQuery) {
-			// We use vkGetQueryResults to copy the results into a host visible buffer
-			vkGetQueryPoolResults(
-				device,
-				queryPool,
-				0,
-				1,
-				sizeof(pipelineStats),
-				pipelineStats,
-				sizeof(uint64_t),
-				VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+		// Get the query results of the most recent frame that has finished on the GPU for displaying (if the device supports pipeline statistics)
+		if (statisticsQueries.getResults().available) {
+			pipelineStats[0] = statisticsQueries.getResult(0, 0);
+			pipelineStats[1] = statisticsQueries.getResult(0, 1);
 		}
 	}
 
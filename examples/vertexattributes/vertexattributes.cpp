@@ -168,11 +168,8 @@ VulkanExample::~VulkanExample()
 		separateVertexBuffers.tangent.destroy();
 		separateVertexBuffers.uv.destroy();
 		interleavedVertexBuffer.destroy();
-		for (Image image : scene.images) {
-			vkDestroyImageView(vulkanDevice->logicalDevice, image.texture.view, nullptr);
-			vkDestroyImage(vulkanDevice->logicalDevice, image.texture.image, nullptr);
-			vkDestroySampler(vulkanDevice->logicalDevice, image.texture.sampler, nullptr);
-			vkFreeMemory(vulkanDevice->logicalDevice, image.texture.deviceMemory, nullptr);
+		for (auto& image : scene.images) {
+			image.texture.destroy();
 		}
 	}
 }
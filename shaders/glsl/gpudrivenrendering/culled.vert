@@ -0,0 +1,67 @@
+// Copyright 2025 Sascha Willems
+
+#version 450
+
+#extension GL_ARB_shader_draw_parameters : require
+
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inUV;
+layout (location = 3) in vec4 inTangent;
+
+layout (set = 0, binding = 0) uniform UBO
+{
+	mat4 projection;
+	mat4 view;
+	vec4 lightPos;
+	vec4 viewPos;
+} ubo;
+
+// Same layout as vkglTF::NodeData
+struct NodeData
+{
+	mat4 matrix;
+	uint jointOffset;
+	uint jointCount;
+	uint _pad0;
+	uint _pad1;
+};
+
+// Node storage buffer of the glTF model, gl_InstanceIndex is the index of the node
+layout (set = 1, binding = 0, std430) readonly buffer Nodes
+{
+	NodeData nodes[ ];
+};
+
+// Material index of every draw compacted by the cull shader (vks::GpuCulling::getMaterialBufferInfo)
+layout (set = 0, binding = 1, std430) readonly buffer DrawMaterials
+{
+	uint drawMaterials[ ];
+};
+
+// Index of the first draw of the indirect count draw call, late draws start at the candidate count
+layout (push_constant) uniform PushConsts
+{
+	uint drawOffset;
+} pushConsts;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec2 outUV;
+layout (location = 2) out vec3 outViewVec;
+layout (location = 3) out vec3 outLightVec;
+layout (location = 4) out vec4 outTangent;
+layout (location = 5) flat out uint outMaterial;
+
+void main()
+{
+	mat4 model = nodes[gl_InstanceIndex].matrix;
+	vec4 pos = model * vec4(inPos, 1.0);
+	gl_Position = ubo.projection * ubo.view * pos;
+
+	outNormal = mat3(model) * inNormal;
+	outTangent = vec4(mat3(model) * inTangent.xyz, inTangent.w);
+	outUV = inUV;
+	outLightVec = ubo.lightPos.xyz - pos.xyz;
+	outViewVec = ubo.viewPos.xyz - pos.xyz;
+	outMaterial = drawMaterials[pushConsts.drawOffset + gl_DrawIDARB];
+}
@@ -0,0 +1,75 @@
+// Copyright 2025 Sascha Willems
+
+#version 450
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Same layout as vkglTF::MaterialData
+struct MaterialData
+{
+	vec4 baseColorFactor;
+	float metallicFactor;
+	float roughnessFactor;
+	float alphaCutoff;
+	uint alphaMode;
+	uint baseColorTexture;
+	uint metallicRoughnessTexture;
+	uint normalTexture;
+	uint occlusionTexture;
+	uint emissiveTexture;
+	uint _pad0;
+	uint _pad1;
+	uint _pad2;
+};
+
+// Materials and textures of the glTF model, texture index 0 means the material has no such texture
+layout (set = 2, binding = 0, std430) readonly buffer Materials
+{
+	MaterialData materials[ ];
+};
+layout (set = 2, binding = 1) uniform sampler2D textures[];
+
+layout (push_constant) uniform PushConsts
+{
+	uint material;
+} pushConsts;
+
+layout (location = 0) in vec3 inNormal;
+layout (location = 1) in vec2 inUV;
+layout (location = 2) in vec3 inViewVec;
+layout (location = 3) in vec3 inLightVec;
+layout (location = 4) in vec4 inTangent;
+
+layout (location = 0) out vec4 outFragColor;
+
+const uint ALPHAMODE_MASK = 1;
+
+void main()
+{
+	MaterialData material = materials[pushConsts.material];
+
+	vec4 color = material.baseColorFactor;
+	if (material.baseColorTexture != 0) {
+		color *= texture(textures[nonuniformEXT(material.baseColorTexture)], inUV);
+	}
+
+	if ((material.alphaMode == ALPHAMODE_MASK) && (color.a < material.alphaCutoff)) {
+		discard;
+	}
+
+	vec3 N = normalize(inNormal);
+	if (material.normalTexture != 0) {
+		vec3 T = normalize(inTangent.xyz);
+		vec3 B = cross(N, T) * inTangent.w;
+		mat3 TBN = mat3(T, B, N);
+		N = TBN * normalize(texture(textures[nonuniformEXT(material.normalTexture)], inUV).xyz * 2.0 - vec3(1.0));
+	}
+
+	const float ambient = 0.1;
+	vec3 L = normalize(inLightVec);
+	vec3 V = normalize(inViewVec);
+	vec3 R = reflect(-L, N);
+	vec3 diffuse = max(dot(N, L), ambient).rrr;
+	float specular = pow(max(dot(R, V), 0.0), 32.0) * 0.25;
+	outFragColor = vec4(diffuse * color.rgb + specular, 1.0);
+}